@@ -0,0 +1,71 @@
+/*----------------------------------------------------------
+* COSC363  Ray Tracer
+*
+*  The allocation counter
+-------------------------------------------------------------*/
+
+#include "AllocationCounter.h"
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace
+{
+    //Only read on the allocation path while nothing is being counted, so the
+    //counter itself is not contended by renders that do allocate
+    std::atomic<bool> counting(false);
+    std::atomic<size_t> allocations(0);
+
+    void* allocate(size_t size)
+    {
+        if(counting.load(std::memory_order_relaxed))
+        {
+            allocations.fetch_add(1, std::memory_order_relaxed);
+        }
+        void* p = malloc(size > 0 ? size : 1);
+        if(p == NULL) throw std::bad_alloc();
+        return p;
+    }
+}
+
+void AllocationCounter::start()
+{
+    allocations = 0;
+    counting = true;
+}
+
+size_t AllocationCounter::stop()
+{
+    counting = false;
+    return allocations;
+}
+
+void* operator new(size_t size)
+{
+    return allocate(size);
+}
+
+void* operator new[](size_t size)
+{
+    return allocate(size);
+}
+
+void operator delete(void* p) noexcept
+{
+    free(p);
+}
+
+void operator delete[](void* p) noexcept
+{
+    free(p);
+}
+
+void operator delete(void* p, size_t) noexcept
+{
+    free(p);
+}
+
+void operator delete[](void* p, size_t) noexcept
+{
+    free(p);
+}
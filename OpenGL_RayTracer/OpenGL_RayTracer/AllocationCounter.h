@@ -0,0 +1,24 @@
+/*----------------------------------------------------------
+* COSC363  Ray Tracer
+*
+*  The allocation counter
+*  Replaces the global operator new so that the heap
+*  allocations made between start() and stop(), on any
+*  thread, are counted. Used by --allocation-check to make
+*  sure that rendering a frame never calls the allocator.
+-------------------------------------------------------------*/
+
+#ifndef H_ALLOCATION_COUNTER
+#define H_ALLOCATION_COUNTER
+
+#include <stddef.h>
+
+class AllocationCounter
+{
+public:
+    static void start();
+    //Allocations since start()
+    static size_t stop();
+};
+
+#endif //!H_ALLOCATION_COUNTER
@@ -0,0 +1,113 @@
+/*----------------------------------------------------------
+* COSC363  Ray Tracer
+*
+*  The animation class
+-------------------------------------------------------------*/
+
+#include "Animation.h"
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+namespace
+{
+    //Interpolates a keyframe track at 'frame'
+    template<typename T, typename Lerp>
+    T sample(const std::map<int, T>& keys, int frame, Lerp lerp)
+    {
+        typename std::map<int, T>::const_iterator next = keys.lower_bound(frame);
+        if(next == keys.end()) return keys.rbegin()->second;
+        if(next->first == frame || next == keys.begin()) return next->second;
+
+        typename std::map<int, T>::const_iterator prev = next;
+        --prev;
+        float u = float(frame - prev->first) / float(next->first - prev->first);
+        return lerp(prev->second, next->second, u);
+    }
+}
+
+bool Animation::load(const char* filename)
+{
+    std::ifstream file(filename);
+    if(!file)
+    {
+        std::cerr << "*** Error opening animation file: " << filename << std::endl;
+        return false;
+    }
+
+    std::string line;
+    int lineNumber = 0;
+    while(std::getline(file, line))
+    {
+        lineNumber++;
+        size_t comment = line.find('#');
+        if(comment != std::string::npos) line.erase(comment);
+
+        std::istringstream in(line);
+        int frame;
+        std::string kind;
+        if(!(in >> frame)) continue;  //Blank line
+        in >> kind;
+
+        bool ok = false;
+        if(kind == "camera")
+        {
+            CameraKey key;
+            ok = (bool)(in >> key.eye.x >> key.eye.y >> key.eye.z >> key.target.x >> key.target.y >> key.target.z);
+            if(ok) cameraKeys_[frame] = key;
+        }
+        else if(kind == "object")
+        {
+            int index;
+            glm::vec3 offset;
+            ok = (bool)(in >> index >> offset.x >> offset.y >> offset.z);
+            if(ok) objectKeys_[index][frame] = offset;
+        }
+
+        if(!ok || frame < 0)
+        {
+            std::cerr << "*** " << filename << ":" << lineNumber << ": invalid keyframe" << std::endl;
+            return false;
+        }
+        if(frame > lastFrame_) lastFrame_ = frame;
+    }
+    return true;
+}
+
+int Animation::getLastFrame()
+{
+    return lastFrame_;
+}
+
+bool Animation::apply(Scene& scene, int frame)
+{
+    if(!cameraKeys_.empty())
+    {
+        CameraKey key = sample(cameraKeys_, frame, [](CameraKey a, CameraKey b, float u)
+        {
+            CameraKey k;
+            k.eye = glm::mix(a.eye, b.eye, u);
+            k.target = glm::mix(a.target, b.target, u);
+            return k;
+        });
+        scene.camera.lookAt(key.eye, key.target);
+    }
+
+    for(std::map<int, std::map<int, glm::vec3> >::iterator track = objectKeys_.begin(); track != objectKeys_.end(); ++track)
+    {
+        if(track->first < 0 || track->first >= (int)scene.objects.size())
+        {
+            std::cerr << "*** Animated object " << track->first << " does not exist" << std::endl;
+            return false;
+        }
+        glm::vec3 offset = sample(track->second, frame, [](glm::vec3 a, glm::vec3 b, float u) { return glm::mix(a, b, u); });
+        scene.objects[track->first]->setOffset(offset);
+    }
+
+    if(!objectKeys_.empty())
+    {
+        scene.refit();
+    }
+    return true;
+}
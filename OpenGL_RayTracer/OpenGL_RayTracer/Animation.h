@@ -0,0 +1,48 @@
+/*----------------------------------------------------------
+* COSC363  Ray Tracer
+*
+*  The animation class
+*  Keyframed camera and object motion, read from a text file
+*  with one keyframe per line ('#' starts a comment):
+*
+*    <frame> camera <eye x y z> <target x y z>
+*    <frame> object <index> <offset x y z>
+*
+*  Object offsets are translations from the position the
+*  object was built at. Values are linearly interpolated
+*  between keyframes and held before the first and after the
+*  last keyframe of each track.
+-------------------------------------------------------------*/
+
+#ifndef H_ANIMATION
+#define H_ANIMATION
+
+#include <map>
+#include <glm/glm.hpp>
+#include "Scene.h"
+
+class Animation
+{
+private:
+    struct CameraKey
+    {
+        glm::vec3 eye;
+        glm::vec3 target;
+    };
+
+    std::map<int, CameraKey> cameraKeys_;
+    std::map<int, std::map<int, glm::vec3> > objectKeys_;  //object index -> frame -> offset
+    int lastFrame_ = 0;
+
+public:
+    bool load(const char* filename);
+
+    //Last keyframe of any track
+    int getLastFrame();
+
+    //Moves the scene's camera and animated objects to their state at 'frame'
+    //and refits the acceleration structure; returns false if an object index is invalid
+    bool apply(Scene& scene, int frame);
+};
+
+#endif //!H_ANIMATION
@@ -0,0 +1,95 @@
+/*----------------------------------------------------------
+* COSC363  Ray Tracer
+*
+*  The async loader class
+-------------------------------------------------------------*/
+
+#include "AsyncLoader.h"
+#include "ParallelFor.h"
+#include <cstdio>
+
+AsyncLoader::AsyncLoader()
+    : finished_(0)
+{
+}
+
+AsyncLoader::~AsyncLoader()
+{
+    wait();
+}
+
+void AsyncLoader::add(const std::string& name, std::function<void()> work)
+{
+    Task task;
+    task.name = name;
+    task.work = work;
+    task.seconds = 0;
+    tasks_.push_back(task);
+}
+
+void AsyncLoader::setThreadCount(int threads)
+{
+    threadCount_ = threads;
+}
+
+/**
+* The tasks are mostly file reads and single-threaded decoding, so by
+* default each gets its own thread even on a machine with fewer cores.
+*/
+void AsyncLoader::start()
+{
+    finished_ = 0;
+    start_ = std::chrono::steady_clock::now();
+    int threads = threadCount_ > 0 ? threadCount_ : (int)tasks_.size();
+
+    thread_ = std::thread([this, threads]()
+    {
+        parallelFor(tasks_.size(), threads, [this](int k)
+        {
+            std::chrono::steady_clock::time_point taskStart = std::chrono::steady_clock::now();
+            tasks_[k].work();
+            std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - taskStart;
+            tasks_[k].seconds = elapsed.count();
+
+            if(++finished_ == (int)tasks_.size())
+            {
+                std::chrono::duration<double> total = std::chrono::steady_clock::now() - start_;
+                seconds_ = total.count();
+            }
+        });
+    });
+}
+
+bool AsyncLoader::isFinished()
+{
+    return finished_ == (int)tasks_.size();
+}
+
+void AsyncLoader::wait()
+{
+    if(thread_.joinable())
+    {
+        thread_.join();
+    }
+}
+
+float AsyncLoader::getProgress()
+{
+    return tasks_.empty() ? 1.0f : (float)finished_ / tasks_.size();
+}
+
+double AsyncLoader::getSeconds()
+{
+    return seconds_;
+}
+
+void AsyncLoader::printReport()
+{
+    double serial = 0;
+    for(unsigned int k = 0; k < tasks_.size(); k++)
+    {
+        printf("  %-22s %8.1f ms\n", tasks_[k].name.c_str(), tasks_[k].seconds * 1000.0);
+        serial += tasks_[k].seconds;
+    }
+    printf("Loaded in %.1f ms (%.1f ms of work)\n", seconds_ * 1000.0, serial * 1000.0);
+}
@@ -0,0 +1,69 @@
+/*----------------------------------------------------------
+* COSC363  Ray Tracer
+*
+*  The async loader class
+*  Runs independent start-up tasks (texture decoding, scene
+*  and acceleration structure building, ...) concurrently on
+*  a background pool, so that the caller can keep a window
+*  responsive and show progress while they run. Each task's
+*  time is recorded for the report.
+-------------------------------------------------------------*/
+
+#ifndef H_ASYNC_LOADER
+#define H_ASYNC_LOADER
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+
+class AsyncLoader
+{
+private:
+    struct Task
+    {
+        std::string name;
+        std::function<void()> work;
+        double seconds;
+    };
+
+    std::vector<Task> tasks_;
+    std::atomic<int> finished_;
+    std::thread thread_;
+    int threadCount_ = 0;
+    std::chrono::steady_clock::time_point start_;
+    double seconds_ = 0;
+
+    AsyncLoader(const AsyncLoader&);
+    AsyncLoader& operator=(const AsyncLoader&);
+
+public:
+    AsyncLoader();
+    ~AsyncLoader();
+
+    //Tasks must not depend on each other; add them all before start()
+    void add(const std::string& name, std::function<void()> work);
+
+    //Threads for the tasks; 0 (default): one per task
+    void setThreadCount(int threads);
+
+    //Starts the tasks and returns at once
+    void start();
+
+    bool isFinished();
+
+    //Blocks until every task has finished
+    void wait();
+
+    //Fraction of the tasks finished, 0 - 1
+    float getProgress();
+
+    //Wall time from start() to the last task finishing
+    double getSeconds();
+
+    void printReport();
+};
+
+#endif //!H_ASYNC_LOADER
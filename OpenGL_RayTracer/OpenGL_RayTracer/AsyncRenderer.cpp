@@ -0,0 +1,299 @@
+/*----------------------------------------------------------
+* COSC363  Ray Tracer
+*
+*  The async renderer class
+-------------------------------------------------------------*/
+
+#include "AsyncRenderer.h"
+#include <algorithm>
+
+namespace
+{
+    unsigned char toByte(float c)
+    {
+        c = c < 0 ? 0 : (c > 1 ? 1 : c);
+        return (unsigned char)(c * 255.0f + 0.5f);
+    }
+}
+
+RenderJob::RenderJob(AsyncRenderer* owner)
+    : owner_(owner), finishedTiles_(0), status_(RENDER_QUEUED), cancelled_(false)
+{
+}
+
+unsigned RenderJob::getId() const
+{
+    return id_;
+}
+
+int RenderJob::getWidth() const
+{
+    return request_.width;
+}
+
+int RenderJob::getHeight() const
+{
+    return request_.height;
+}
+
+const unsigned char* RenderJob::getImage() const
+{
+    return rgba_.data();
+}
+
+RenderStatus RenderJob::getStatus() const
+{
+    return (RenderStatus)status_.load();
+}
+
+bool RenderJob::isFinished() const
+{
+    int status = status_;
+    return status == RENDER_FINISHED || status == RENDER_CANCELLED;
+}
+
+float RenderJob::getProgress() const
+{
+    return tileCount_ > 0 ? (float)finishedTiles_ / tileCount_ : 1.0f;
+}
+
+double RenderJob::getSeconds() const
+{
+    return seconds_;
+}
+
+/**
+* A worker waiting for the job's last tiles is woken, so that the job is
+* retired (and the next one started) as soon as they are done.
+*/
+void RenderJob::cancel()
+{
+    cancelled_ = true;
+    std::lock_guard<std::mutex> lock(owner_->mutex_);
+    owner_->changed_.notify_all();
+}
+
+RenderStatus RenderJob::wait()
+{
+    std::unique_lock<std::mutex> lock(owner_->mutex_);
+    owner_->finished_.wait(lock, [this]() { return isFinished(); });
+    return getStatus();
+}
+
+RenderTile RenderJob::tile(int index) const
+{
+    RenderTile tile;
+    tile.x = (index % tilesX_) * request_.tileWidth;
+    tile.y = (index / tilesX_) * request_.tileHeight;
+    tile.width = std::min(request_.tileWidth, request_.width - tile.x);
+    tile.height = std::min(request_.tileHeight, request_.height - tile.y);
+    return tile;
+}
+
+AsyncRenderer::AsyncRenderer()
+{
+    threadCount_ = std::max(1, (int)std::thread::hardware_concurrency());
+}
+
+AsyncRenderer::~AsyncRenderer()
+{
+    cancelAll();
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+        changed_.notify_all();
+    }
+    for(size_t w = 0; w < workers_.size(); w++)
+    {
+        workers_[w].join();
+    }
+
+    //Jobs still queued were never started; let their handles see that
+    for(size_t q = 0; q < queue_.size(); q++)
+    {
+        queue_[q]->status_ = RENDER_CANCELLED;
+    }
+    finished_.notify_all();
+}
+
+void AsyncRenderer::setThreadCount(int threads)
+{
+    threadCount_ = std::max(1, threads);
+}
+
+/**
+* A kept job is reused once its only owner is this renderer, i.e. the
+* caller has dropped its handle; its framebuffer keeps its capacity.
+*/
+std::shared_ptr<RenderJob> AsyncRenderer::submit(const RenderRequest& request)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    while((int)workers_.size() < threadCount_)
+    {
+        workers_.push_back(std::thread(&AsyncRenderer::work, this));
+    }
+
+    std::shared_ptr<RenderJob> job;
+    for(size_t k = 0; k < kept_.size() && !job; k++)
+    {
+        if(kept_[k].use_count() == 1)
+        {
+            job = kept_[k];
+            kept_.erase(kept_.begin() + k);
+        }
+    }
+    if(!job)
+    {
+        job = std::make_shared<RenderJob>(this);
+    }
+
+    RenderJob& j = *job;
+    j.request_ = request;
+    j.request_.width = std::max(0, request.width);
+    j.request_.height = std::max(0, request.height);
+    j.request_.tileWidth = std::max(1, request.tileWidth);
+    j.request_.tileHeight = std::max(1, request.tileHeight);
+    j.rgba_.resize((size_t)j.request_.width * j.request_.height * 4);
+    j.id_ = nextId_++;
+    j.tilesX_ = (j.request_.width + j.request_.tileWidth - 1) / j.request_.tileWidth;
+    j.tileCount_ = j.tilesX_ * ((j.request_.height + j.request_.tileHeight - 1) / j.request_.tileHeight);
+    j.nextTile_ = 0;
+    j.activeTiles_ = 0;
+    j.prepared_ = false;
+    j.finishedTiles_ = 0;
+    j.status_ = RENDER_QUEUED;
+    j.cancelled_ = false;
+    j.seconds_ = 0;
+
+    queue_.push_back(job);
+    changed_.notify_all();
+    return job;
+}
+
+void AsyncRenderer::cancelAll()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    for(size_t q = 0; q < queue_.size(); q++)
+    {
+        queue_[q]->cancelled_ = true;
+    }
+    changed_.notify_all();
+}
+
+void AsyncRenderer::renderTile(RenderJob& job, int index)
+{
+    RenderTile tile = job.tile(index);
+    int width = job.request_.width;
+    int height = job.request_.height;
+    const PixelFunction& pixel = job.request_.pixel;
+
+    for(int r = 0; r < tile.height; r++)
+    {
+        int j = height - 1 - (tile.y + r);
+        unsigned char* p = job.rgba_.data() + ((size_t)(tile.y + r) * width + tile.x) * 4;
+        for(int i = tile.x; i < tile.x + tile.width; i++, p += 4)
+        {
+            glm::vec3 color = pixel(i, j);
+            p[0] = toByte(color.r);
+            p[1] = toByte(color.g);
+            p[2] = toByte(color.b);
+            p[3] = 255;
+        }
+    }
+}
+
+/**
+* Removes the first job from the queue once no worker uses it; called
+* with the mutex held.
+*/
+void AsyncRenderer::retire()
+{
+    std::shared_ptr<RenderJob> job = queue_.front();
+    queue_.erase(queue_.begin());
+
+    if(job->prepared_)
+    {
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - job->start_;
+        job->seconds_ = elapsed.count();
+    }
+    bool complete = job->finishedTiles_ == job->tileCount_;
+    job->status_ = complete ? RENDER_FINISHED : RENDER_CANCELLED;
+
+    if((int)kept_.size() < KEPT_JOBS)
+    {
+        kept_.push_back(job);
+    }
+    finished_.notify_all();
+    changed_.notify_all();
+}
+
+/**
+* Takes tiles from the first job in the queue until the renderer is
+* destroyed. One worker prepares a job while the others wait, and a job
+* whose tiles have all been taken (or that was cancelled) is retired by
+* the first worker to find it idle, which starts the next job.
+*/
+void AsyncRenderer::work()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    while(!stopping_)
+    {
+        if(queue_.empty() || preparing_)
+        {
+            changed_.wait(lock);
+            continue;
+        }
+
+        RenderJob& job = *queue_.front();
+        if(job.cancelled_ || job.nextTile_ == job.tileCount_)
+        {
+            if(job.activeTiles_ == 0)
+            {
+                retire();
+            }
+            else
+            {
+                changed_.wait(lock);
+            }
+            continue;
+        }
+
+        if(!job.prepared_)
+        {
+            preparing_ = true;
+            job.status_ = RENDER_RUNNING;
+            job.start_ = std::chrono::steady_clock::now();
+            lock.unlock();
+            if(job.request_.prepare)
+            {
+                job.request_.prepare(job);
+            }
+            lock.lock();
+            job.prepared_ = true;
+            preparing_ = false;
+            changed_.notify_all();
+            continue;
+        }
+
+        int index = job.nextTile_++;
+        job.activeTiles_++;
+        lock.unlock();
+
+        renderTile(job, index);
+        if(job.request_.onTile)
+        {
+            job.request_.onTile(job, job.tile(index));
+        }
+        int finished = ++job.finishedTiles_;
+        if(job.request_.onProgress)
+        {
+            job.request_.onProgress(job, (float)finished / job.tileCount_);
+        }
+
+        lock.lock();
+        if(--job.activeTiles_ == 0)
+        {
+            changed_.notify_all();
+        }
+    }
+}
@@ -0,0 +1,161 @@
+/*----------------------------------------------------------
+* COSC363  Ray Tracer
+*
+*  The async renderer class
+*  Renders images in the background: submit() queues a
+*  request and returns at once with a handle to the job.
+*  Worker threads trace the job's tiles into its RGBA
+*  framebuffer and report each finished tile and the
+*  progress through the request's callbacks. A job can be
+*  cancelled at any time; the workers check for it between
+*  tiles, so a cancelled job stops after the tiles already
+*  being traced. Jobs are traced one after another, so a
+*  job's preparation (setting up global render state) never
+*  overlaps another job's tiles. Finished jobs are reused by
+*  later submits, so an interactive loop that submits and
+*  cancels frame after frame does not allocate.
+-------------------------------------------------------------*/
+
+#ifndef H_ASYNC_RENDERER
+#define H_ASYNC_RENDERER
+
+#include "StreamingRenderer.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class AsyncRenderer;
+class RenderJob;
+
+//Pixels [x, x + width) of rows [y, y + height), rows counted from the top
+struct RenderTile
+{
+    int x;
+    int y;
+    int width;
+    int height;
+};
+
+typedef std::function<void(const RenderJob& job)> JobCallback;
+typedef std::function<void(const RenderJob& job, const RenderTile& tile)> TileCallback;
+typedef std::function<void(const RenderJob& job, float progress)> ProgressCallback;
+
+struct RenderRequest
+{
+    int width = 0;
+    int height = 0;
+    int tileWidth = 32;
+    int tileHeight = 32;
+    PixelFunction pixel;            //Called on the worker threads
+    JobCallback prepare;            //Optional; runs on a worker before the first tile, while no other job is traced
+    TileCallback onTile;            //Optional; runs on the worker that finished the tile
+    ProgressCallback onProgress;    //Optional; runs after each tile with the fraction of tiles finished
+};
+
+enum RenderStatus
+{
+    RENDER_QUEUED,
+    RENDER_RUNNING,
+    RENDER_FINISHED,
+    RENDER_CANCELLED
+};
+
+class RenderJob
+{
+    friend class AsyncRenderer;
+
+private:
+    AsyncRenderer* owner_;
+    RenderRequest request_;
+    std::vector<unsigned char> rgba_;
+    unsigned id_ = 0;
+    int tilesX_ = 0;
+    int tileCount_ = 0;
+
+    //Guarded by the owner's mutex
+    int nextTile_ = 0;
+    int activeTiles_ = 0;
+    bool prepared_ = false;
+
+    std::atomic<int> finishedTiles_;
+    std::atomic<int> status_;
+    std::atomic<bool> cancelled_;
+    std::chrono::steady_clock::time_point start_;
+    double seconds_ = 0;
+
+    RenderTile tile(int index) const;
+
+public:
+    explicit RenderJob(AsyncRenderer* owner);
+
+    //Different for every submit, also when the job object is reused
+    unsigned getId() const;
+    int getWidth() const;
+    int getHeight() const;
+
+    //RGBA8, top row first; a tile's pixels are final once its tile callback has run
+    const unsigned char* getImage() const;
+
+    RenderStatus getStatus() const;
+
+    //True once the job has finished or been cancelled and no worker uses it
+    bool isFinished() const;
+
+    //Fraction of the tiles finished, 0 - 1
+    float getProgress() const;
+
+    //Time from the start of the preparation to the last tile
+    double getSeconds() const;
+
+    //Stops the job after the tiles being traced; returns at once
+    void cancel();
+
+    //Blocks until the job has finished or been cancelled
+    RenderStatus wait();
+};
+
+class AsyncRenderer
+{
+    friend class RenderJob;
+
+private:
+    static const int KEPT_JOBS = 4;     //Finished jobs kept for reuse
+
+    std::mutex mutex_;
+    std::condition_variable changed_;
+    std::condition_variable finished_;
+    std::vector<std::thread> workers_;
+    std::vector<std::shared_ptr<RenderJob> > queue_;    //In submit order; the first is being traced
+    std::vector<std::shared_ptr<RenderJob> > kept_;
+    int threadCount_;
+    unsigned nextId_ = 1;
+    bool preparing_ = false;
+    bool stopping_ = false;
+
+    AsyncRenderer(const AsyncRenderer&);
+    AsyncRenderer& operator=(const AsyncRenderer&);
+
+    void work();
+    void retire();
+    void renderTile(RenderJob& job, int index);
+
+public:
+    AsyncRenderer();
+    ~AsyncRenderer();
+
+    //Takes effect when the workers are started by the first submit()
+    void setThreadCount(int threads);
+
+    //Queues the request and returns at once
+    std::shared_ptr<RenderJob> submit(const RenderRequest& request);
+
+    //Cancels every queued and running job
+    void cancelAll();
+};
+
+#endif //!H_ASYNC_RENDERER
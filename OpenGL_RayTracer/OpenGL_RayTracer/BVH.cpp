@@ -0,0 +1,221 @@
+/*----------------------------------------------------------
+* COSC363  Ray Tracer
+*
+*  The BVH class
+-------------------------------------------------------------*/
+
+#include "BVH.h"
+#include <algorithm>
+
+namespace
+{
+    //Margin added around every box so that hit points rounded just outside are kept
+    const float BOX_MARGIN = 1.e-3f;
+
+    BoundingBox objectBox(SceneObject* object)
+    {
+        BoundingBox box = object->bounds();
+        box.pad(BOX_MARGIN);
+        return box;
+    }
+}
+
+void BVH::build(std::vector<SceneObject*>& objects)
+{
+    mapping_.reset();
+    nodes_.clear();
+    objectIndices_.resize(objects.size());
+    std::vector<BoundingBox> boxes(objects.size());
+    for(uint i = 0; i < objects.size(); i++)
+    {
+        objectIndices_[i] = i;
+        boxes[i] = objectBox(objects[i]);
+    }
+    if(!objects.empty())
+    {
+        build(objects, boxes, 0, objects.size());
+    }
+}
+
+/**
+* Builds the subtree over objectIndices_[begin, end) by splitting at the
+* median centre along the longest axis. Nodes are stored in depth-first
+* order, so every child comes after its parent.
+*/
+int BVH::build(std::vector<SceneObject*>& objects, std::vector<BoundingBox>& boxes, int begin, int end)
+{
+    int nodeIndex = nodes_.size();
+    nodes_.push_back(BVHNode());
+
+    BoundingBox box;
+    BoundingBox centers;
+    for(int i = begin; i < end; i++)
+    {
+        box.expand(boxes[objectIndices_[i]]);
+        centers.expand(boxes[objectIndices_[i]].center());
+    }
+    nodes_[nodeIndex].box = box;
+
+    if(end - begin <= MAX_LEAF_SIZE)
+    {
+        nodes_[nodeIndex].first = begin;
+        nodes_[nodeIndex].count = end - begin;
+        return nodeIndex;
+    }
+
+    glm::vec3 extent = centers.max - centers.min;
+    int axis = 0;
+    if(extent.y > extent.x) axis = 1;
+    if(extent.z > extent[axis]) axis = 2;
+
+    int middle = (begin + end) / 2;
+    std::nth_element(objectIndices_.begin() + begin, objectIndices_.begin() + middle, objectIndices_.begin() + end,
+        [&boxes, axis](int a, int b) { return boxes[a].center()[axis] < boxes[b].center()[axis]; });
+
+    build(objects, boxes, begin, middle);
+    int right = build(objects, boxes, middle, end);
+    nodes_[nodeIndex].first = right;
+    nodes_[nodeIndex].count = 0;
+    return nodeIndex;
+}
+
+void BVH::adopt(std::shared_ptr<const void> mapping, const BVHNode* nodes, int nodeCount, const int* objectIndices)
+{
+    nodes_.clear();
+    objectIndices_.clear();
+    mapping_ = mapping;
+    mappedNodes_ = nodes;
+    mappedNodeCount_ = nodeCount;
+    mappedIndices_ = objectIndices;
+}
+
+void BVH::refit(std::vector<SceneObject*>& objects)
+{
+    if(mapping_)
+    {
+        nodes_.assign(mappedNodes_, mappedNodes_ + mappedNodeCount_);
+        objectIndices_.assign(mappedIndices_, mappedIndices_ + objects.size());
+        mapping_.reset();
+    }
+
+    for(int n = (int)nodes_.size() - 1; n >= 0; n--)
+    {
+        BVHNode& node = nodes_[n];
+        BoundingBox box;
+        if(node.count > 0)
+        {
+            for(int i = node.first; i < node.first + node.count; i++)
+            {
+                box.expand(objectBox(objects[objectIndices_[i]]));
+            }
+        }
+        else
+        {
+            box.expand(nodes_[n + 1].box);
+            box.expand(nodes_[node.first].box);
+        }
+        node.box = box;
+    }
+}
+
+/**
+* Finds the closest intersection with the same rules as Ray::closestPt():
+* only 0 < t < 1.e+6 counts, and among equal distances the object with the
+* lowest index wins, whatever order the tree visits them in.
+*/
+void BVH::closestPt(Ray& ray, std::vector<SceneObject*>& objects)
+{
+    if(isEmpty()) return;
+    const BVHNode* nodes = getNodes();
+    const int* objectIndices = getObjectIndices();
+
+    glm::vec3 invDir = 1.0f / ray.dir;
+    float tmin = 1.e+6;
+
+    int stack[STACK_SIZE];  //Median splits keep the depth near log2(n)
+    int top = 0;
+    stack[top++] = 0;
+    while(top > 0)
+    {
+        int nodeIndex = stack[--top];
+        const BVHNode& node = nodes[nodeIndex];
+        if(!node.box.intersects(ray.p0, invDir, tmin)) continue;
+
+        if(node.count > 0)
+        {
+            for(int k = node.first; k < node.first + node.count; k++)
+            {
+                int i = objectIndices[k];
+                int part;
+                float t = objects[i]->intersect(ray.p0, ray.dir, part);
+                if(t > 0 && (t < tmin || (t == tmin && i < ray.index)))
+                {
+                    ray.hit = ray.p0 + ray.dir * t;
+                    ray.index = i;
+                    ray.dist = t;
+                    ray.part = part;
+                    ray.hitSceneObject = objects[i];
+                    tmin = t;
+                }
+            }
+        }
+        else
+        {
+            stack[top++] = node.first;
+            stack[top++] = nodeIndex + 1;
+        }
+    }
+}
+
+bool BVH::occluded(Ray& ray, std::vector<SceneObject*>& objects, float maxDist)
+{
+    if(isEmpty()) return false;
+    const BVHNode* nodes = getNodes();
+    const int* objectIndices = getObjectIndices();
+
+    glm::vec3 invDir = 1.0f / ray.dir;
+    int stack[STACK_SIZE];
+    int top = 0;
+    stack[top++] = 0;
+    while(top > 0)
+    {
+        int nodeIndex = stack[--top];
+        const BVHNode& node = nodes[nodeIndex];
+        if(!node.box.intersects(ray.p0, invDir, maxDist)) continue;
+
+        if(node.count > 0)
+        {
+            for(int k = node.first; k < node.first + node.count; k++)
+            {
+                float t = objects[objectIndices[k]]->intersect(ray.p0, ray.dir);
+                if(t > 0 && t < maxDist) return true;
+            }
+        }
+        else
+        {
+            stack[top++] = node.first;
+            stack[top++] = nodeIndex + 1;
+        }
+    }
+    return false;
+}
+
+bool BVH::isEmpty()
+{
+    return getNodeCount() == 0;
+}
+
+int BVH::getNodeCount()
+{
+    return mapping_ ? mappedNodeCount_ : (int)nodes_.size();
+}
+
+const BVHNode* BVH::getNodes()
+{
+    return mapping_ ? mappedNodes_ : nodes_.data();
+}
+
+const int* BVH::getObjectIndices()
+{
+    return mapping_ ? mappedIndices_ : objectIndices_.data();
+}
@@ -0,0 +1,74 @@
+/*----------------------------------------------------------
+* COSC363  Ray Tracer
+*
+*  The BVH class
+*  A bounding volume hierarchy over the scene objects. Ray
+*  queries return exactly what Ray::closestPt() returns for
+*  the same object list, but only test the objects whose
+*  boxes the ray passes through. When objects move, refit()
+*  updates the boxes in place without rebuilding the tree.
+*  A tree can also be adopted from arrays that something else
+*  owns, such as a memory-mapped scene file, and is then
+*  traversed where it lies.
+-------------------------------------------------------------*/
+
+#ifndef H_BVH
+#define H_BVH
+
+#include <memory>
+#include <vector>
+#include "BoundingBox.h"
+#include "Ray.h"
+#include "SceneObject.h"
+
+struct BVHNode
+{
+    BoundingBox box;
+    int first = 0;  //Leaf: first entry in objectIndices; inner node: index of the right child
+    int count = 0;  //Number of objects in a leaf, 0 for an inner node (left child is the next node)
+};
+
+class BVH
+{
+private:
+    std::vector<BVHNode> nodes_;
+    std::vector<int> objectIndices_;
+
+    //Adopted tree: nodes_ and objectIndices_ are empty while 'mapping_' is set
+    std::shared_ptr<const void> mapping_;
+    const BVHNode* mappedNodes_ = NULL;
+    const int* mappedIndices_ = NULL;
+    int mappedNodeCount_ = 0;
+
+    int build(std::vector<SceneObject*>& objects, std::vector<BoundingBox>& boxes, int begin, int end);
+
+public:
+    static const int MAX_LEAF_SIZE = 2;
+
+    //Entries of the traversal stack; a node at depth d leaves at most d + 2 nodes on it
+    static const int STACK_SIZE = 64;
+
+    void build(std::vector<SceneObject*>& objects);
+
+    /**
+    * Uses 'nodes' and 'objectIndices' (one per object) in place instead of
+    * a built tree; 'mapping' keeps them valid for as long as it is held.
+    */
+    void adopt(std::shared_ptr<const void> mapping, const BVHNode* nodes, int nodeCount, const int* objectIndices);
+
+    //Recomputes every box bottom-up from the current object bounds (copies an adopted tree first)
+    void refit(std::vector<SceneObject*>& objects);
+
+    //Same result as ray.closestPt(objects)
+    void closestPt(Ray& ray, std::vector<SceneObject*>& objects);
+
+    //Same result as ray.occluded(objects, maxDist), but stops at the first hit found
+    bool occluded(Ray& ray, std::vector<SceneObject*>& objects, float maxDist);
+
+    bool isEmpty();
+    int getNodeCount();
+    const BVHNode* getNodes();
+    const int* getObjectIndices();
+};
+
+#endif //!H_BVH
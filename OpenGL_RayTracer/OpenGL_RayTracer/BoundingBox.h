@@ -0,0 +1,84 @@
+/*----------------------------------------------------------
+* COSC363  Ray Tracer
+*
+*  The bounding box class
+*  An axis-aligned box used by the acceleration structure.
+-------------------------------------------------------------*/
+
+#ifndef H_BOUNDING_BOX
+#define H_BOUNDING_BOX
+
+#include <glm/glm.hpp>
+
+class BoundingBox
+{
+public:
+    glm::vec3 min = glm::vec3(1.e+30f);
+    glm::vec3 max = glm::vec3(-1.e+30f);
+
+    BoundingBox() {}
+
+    BoundingBox(glm::vec3 lo, glm::vec3 hi) : min(lo), max(hi) {}
+
+    void expand(glm::vec3 p)
+    {
+        min = glm::min(min, p);
+        max = glm::max(max, p);
+    }
+
+    void expand(const BoundingBox& box)
+    {
+        min = glm::min(min, box.min);
+        max = glm::max(max, box.max);
+    }
+
+    //Grows the box by 'margin' on every side (flat objects have zero thickness)
+    void pad(float margin)
+    {
+        min = min - glm::vec3(margin);
+        max = max + glm::vec3(margin);
+    }
+
+    //True if p is inside the box grown by 'margin' on every side
+    bool contains(glm::vec3 p, float margin = 0) const
+    {
+        for(int a = 0; a < 3; a++)
+        {
+            if(p[a] < min[a] - margin || p[a] > max[a] + margin) return false;
+        }
+        return true;
+    }
+
+    glm::vec3 center() const
+    {
+        return (min + max) * 0.5f;
+    }
+
+    /**
+    * Slab test against the ray p0 + t * dir, with invDir = 1 / dir.
+    * Returns true if the ray meets the box for some t in [0, tmax].
+    */
+    bool intersects(glm::vec3 p0, glm::vec3 invDir, float tmax) const
+    {
+        float tnear = 0;
+        float tfar = tmax;
+        for(int a = 0; a < 3; a++)
+        {
+            float t1 = (min[a] - p0[a]) * invDir[a];
+            float t2 = (max[a] - p0[a]) * invDir[a];
+            if(t1 > t2)
+            {
+                float temp = t1;
+                t1 = t2;
+                t2 = temp;
+            }
+            //NaN (origin on a slab of a parallel ray) falls through both tests
+            if(t1 > tnear) tnear = t1;
+            if(t2 < tfar) tfar = t2;
+            if(tnear > tfar) return false;
+        }
+        return true;
+    }
+};
+
+#endif //!H_BOUNDING_BOX
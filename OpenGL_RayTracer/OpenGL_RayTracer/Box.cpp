@@ -0,0 +1,161 @@
+/*----------------------------------------------------------
+* COSC363  Ray Tracer
+*
+*  The box class
+*  This is a subclass of Object, and hence implements the
+*  methods intersect() and normal().
+-------------------------------------------------------------*/
+
+#include "Box.h"
+#include <math.h>
+
+namespace
+{
+    //Hits closer than this are the surface the ray starts on (as in Plane::intersect())
+    const float MIN_HIT_DISTANCE = 1.e-4f;
+
+    //(u, v) axes of the faces on each box axis: x faces use z and y, y faces x and z, z faces x and y
+    const int FACE_U[3] = {2, 0, 0};
+    const int FACE_V[3] = {1, 2, 1};
+}
+
+glm::vec3 Box::toLocal(glm::vec3 v)
+{
+    return oriented_ ? glm::transpose(axes_) * v : v;
+}
+
+void Box::setOrientation(glm::mat3 rotation)
+{
+    axes_ = rotation;
+    oriented_ = true;
+}
+
+/**
+* Slab test: the ray is inside the box between the largest of its entry
+* distances and the smallest of its exit distances over the three axes,
+* done for all axes at once as vector operations. A ray that starts
+* inside the box hits it where it leaves.
+*/
+float Box::intersect(glm::vec3 p0, glm::vec3 dir)
+{
+    glm::vec3 p = toLocal(p0 - center_);
+    glm::vec3 invDir = 1.0f / toLocal(dir);
+    glm::vec3 t1 = (-half_ - p) * invDir;
+    glm::vec3 t2 = (half_ - p) * invDir;
+    glm::vec3 tEnter = glm::min(t1, t2);
+    glm::vec3 tExit = glm::max(t1, t2);
+    float tNear = fmaxf(fmaxf(tEnter.x, tEnter.y), tEnter.z);
+    float tFar = fminf(fminf(tExit.x, tExit.y), tExit.z);
+
+    if(tNear > tFar || tFar < MIN_HIT_DISTANCE) return -1;
+    return tNear > MIN_HIT_DISTANCE ? tNear : tFar;
+}
+
+//The far slab distance: where a ray starting on or inside the box leaves it
+float Box::exitPoint(glm::vec3 p0, glm::vec3 dir)
+{
+    glm::vec3 p = toLocal(p0 - center_);
+    glm::vec3 invDir = 1.0f / toLocal(dir);
+    glm::vec3 tExit = glm::max((-half_ - p) * invDir, (half_ - p) * invDir);
+    float tFar = fminf(fminf(tExit.x, tExit.y), tExit.z);
+    return tFar > MIN_HIT_DISTANCE ? tFar : -1;
+}
+
+/**
+* The face is the one the point is relatively furthest out on, i.e. the
+* axis where |p| / half is largest.
+*/
+BoxFace Box::faceAt(glm::vec3 p)
+{
+    glm::vec3 q = toLocal(p - center_) / half_;
+    int axis = 0;
+    if(fabs(q.y) > fabs(q[axis])) axis = 1;
+    if(fabs(q.z) > fabs(q[axis])) axis = 2;
+    return (BoxFace)(2 * axis + (q[axis] > 0 ? 1 : 0));
+}
+
+/**
+* Returns the unit normal vector at a given point.
+* Assumption: The input point p lies on the box.
+*/
+glm::vec3 Box::normal(glm::vec3 p)
+{
+    int face = faceAt(p);
+    glm::vec3 n(0);
+    n[face / 2] = (face % 2) ? 1 : -1;
+    return oriented_ ? axes_ * n : n;
+}
+
+glm::vec2 Box::textureCoords(glm::vec3 p)
+{
+    int axis = faceAt(p) / 2;
+    glm::vec3 q = toLocal(p - center_) + half_;
+    return glm::vec2(q[FACE_U[axis]] / (2 * half_[FACE_U[axis]]), q[FACE_V[axis]] / (2 * half_[FACE_V[axis]]));
+}
+
+glm::vec3 Box::getColorAt(glm::vec3 p)
+{
+    BoxFace face = faceAt(p);
+    return faceColored_[face] ? faceColors_[face] : color_;
+}
+
+void Box::setFaceColor(BoxFace face, glm::vec3 color)
+{
+    faceColors_[face] = color;
+    faceColored_[face] = true;
+}
+
+void Box::setFaceTextured(BoxFace face, bool flag)
+{
+    faceTextured_[face] = flag;
+    text_ = false;
+    for(int f = 0; f < 6; f++)
+    {
+        text_ = text_ || faceTextured_[f];
+    }
+}
+
+bool Box::isFaceTextured(BoxFace face)
+{
+    return faceTextured_[face];
+}
+
+BoundingBox Box::bounds()
+{
+    //Half the box's world extent along each world axis
+    glm::vec3 extent = half_;
+    if(oriented_)
+    {
+        for(int a = 0; a < 3; a++)
+        {
+            extent[a] = fabs(axes_[0][a]) * half_.x + fabs(axes_[1][a]) * half_.y + fabs(axes_[2][a]) * half_.z;
+        }
+    }
+    return BoundingBox(center_ - extent, center_ + extent);
+}
+
+void Box::translate(glm::vec3 d)
+{
+    center_ += d;
+}
+
+SceneObject* Box::clone()
+{
+    return new Box(*this);
+}
+
+/**
+* Centre, half size, and the box's x and y axes (z is their cross product).
+*/
+ShapeKind Box::getShape(float* params)
+{
+    for(int a = 0; a < 3; a++)
+    {
+        params[a] = center_[a];
+        params[3 + a] = half_[a];
+        params[6 + a] = axes_[0][a];
+        params[9 + a] = axes_[1][a];
+    }
+    params[12] = 0;
+    return SHAPE_BOX;
+}
@@ -0,0 +1,68 @@
+/*----------------------------------------------------------
+* COSC363  Ray Tracer
+*
+*  The box class
+*  This is a subclass of Object, and hence implements the
+*  methods intersect() and normal(). The box is axis-aligned
+*  unless given an orientation, and is hit with one slab test
+*  for all six faces. Each face can have its own colour and
+*  can be marked as textured; textureCoords() gives a face's
+*  (u, v) in [0, 1].
+-------------------------------------------------------------*/
+
+#ifndef H_BOX
+#define H_BOX
+
+#include <glm/glm.hpp>
+#include "SceneObject.h"
+
+//Faces of a box, in its own (possibly rotated) axes
+enum BoxFace
+{
+    BOX_LEFT = 0,   //-x
+    BOX_RIGHT,      //+x
+    BOX_DOWN,       //-y
+    BOX_UP,         //+y
+    BOX_BACK,       //-z
+    BOX_FRONT       //+z
+};
+
+class Box : public SceneObject
+{
+private:
+    glm::vec3 center_ = glm::vec3(0);
+    glm::vec3 half_ = glm::vec3(0.5);        //half the size along each of the box's axes
+    glm::mat3 axes_ = glm::mat3(1);          //columns: the box's x, y and z axes in world space
+    bool oriented_ = false;                  //axes_ is not the identity
+    glm::vec3 faceColors_[6];
+    bool faceColored_[6] = {false, false, false, false, false, false};
+    bool faceTextured_[6] = {false, false, false, false, false, false};
+
+    glm::vec3 toLocal(glm::vec3 v);
+
+public:
+    Box() {}
+    Box(glm::vec3 min, glm::vec3 max) : center_((min + max) * 0.5f), half_((max - min) * 0.5f) {}
+
+    //Rotates the box about its centre so that its x, y and z axes are the columns of 'rotation'
+    void setOrientation(glm::mat3 rotation);
+
+    float intersect(glm::vec3 p0, glm::vec3 dir);
+    float exitPoint(glm::vec3 p0, glm::vec3 dir);
+    glm::vec3 normal(glm::vec3 p);
+    glm::vec3 getColorAt(glm::vec3 p);
+    BoundingBox bounds();
+    void translate(glm::vec3 d);
+    SceneObject* clone();
+    ShapeKind getShape(float* params);
+
+    //Face that the point p on the box lies on
+    BoxFace faceAt(glm::vec3 p);
+    glm::vec2 textureCoords(glm::vec3 p);
+
+    void setFaceColor(BoxFace face, glm::vec3 color);
+    void setFaceTextured(BoxFace face, bool flag);
+    bool isFaceTextured(BoxFace face);
+};
+
+#endif //!H_BOX
@@ -0,0 +1,55 @@
+/*----------------------------------------------------------
+* COSC363  Ray Tracer
+*
+*  The camera class
+-------------------------------------------------------------*/
+
+#include "Camera.h"
+#include <cmath>
+
+void Camera::lookAt(glm::vec3 eye, glm::vec3 target)
+{
+    eye_ = eye;
+    target_ = target;
+    forward_ = glm::normalize(target - eye);
+
+    glm::vec3 worldUp(0, 1, 0);
+    if(fabs(glm::dot(forward_, worldUp)) > 0.999f)
+    {
+        worldUp = glm::vec3(0, 0, -1);  //Looking straight up or down
+    }
+    right_ = glm::normalize(glm::cross(forward_, worldUp));
+    up_ = glm::cross(right_, forward_);
+}
+
+void Camera::setNear(float near)
+{
+    near_ = near;
+}
+
+glm::vec3 Camera::getEye()
+{
+    return eye_;
+}
+
+glm::vec3 Camera::getTarget()
+{
+    return target_;
+}
+
+/**
+* For the default camera this is exactly (x, y, -near).
+*/
+glm::vec3 Camera::direction(float x, float y)
+{
+    return x * right_ + y * up_ + near_ * forward_;
+}
+
+bool Camera::project(glm::vec3 p, glm::vec2& xy)
+{
+    glm::vec3 d = p - eye_;
+    float z = glm::dot(d, forward_);
+    if(z <= 1.e-6f) return false;
+    xy = glm::vec2(glm::dot(d, right_), glm::dot(d, up_)) * (near_ / z);
+    return true;
+}
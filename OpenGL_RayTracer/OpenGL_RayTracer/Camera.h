@@ -0,0 +1,44 @@
+/*----------------------------------------------------------
+* COSC363  Ray Tracer
+*
+*  The camera class
+*  A pinhole camera looking from 'eye' towards 'target'.
+*  Primary rays pass through the view plane at distance
+*  'near' in front of the eye; view plane coordinates (x, y)
+*  are measured along the camera's right and up vectors.
+*  The default camera is the original fixed view: eye at the
+*  origin, looking down -z.
+-------------------------------------------------------------*/
+
+#ifndef H_CAMERA
+#define H_CAMERA
+
+#include <glm/glm.hpp>
+
+class Camera
+{
+private:
+    glm::vec3 eye_ = glm::vec3(0);
+    glm::vec3 target_ = glm::vec3(0, 0, -1);
+    glm::vec3 right_ = glm::vec3(1, 0, 0);
+    glm::vec3 up_ = glm::vec3(0, 1, 0);
+    glm::vec3 forward_ = glm::vec3(0, 0, -1);
+    float near_ = 40.0;
+
+public:
+    Camera() {}
+
+    void lookAt(glm::vec3 eye, glm::vec3 target);
+    void setNear(float near);
+
+    glm::vec3 getEye();
+    glm::vec3 getTarget();
+
+    //Unnormalised direction from the eye through view plane point (x, y)
+    glm::vec3 direction(float x, float y);
+
+    //View plane point that p projects to; false if p is not in front of the eye
+    bool project(glm::vec3 p, glm::vec2& xy);
+};
+
+#endif //!H_CAMERA
@@ -1,37 +1,45 @@
-/*----------------------------------------------------------
-* COSC363  Ray Tracer
-*
-*  The sphere class
-*  This is a subclass of Object, and hence implements the
-*  methods intersect() and normal().
--------------------------------------------------------------*/
-
-#ifndef H_CONE
-#define H_CONE
-#include <glm/glm.hpp>
-#include "SceneObject.h"
-
-/**
- * Defines a simple Sphere located at 'center'
- * with the specified radius
- */
-class Cone : public SceneObject
-{
-
-private:
-    glm::vec3 center = glm::vec3(0);
-    float radius = 1;
-    float height = 1;
-
-public:
-	Cone() {};  //Default constructor creates a unit sphere
-
-	Cone(glm::vec3 c, float r, float h) : center(c), radius(r), height(h){}
-
-	float intersect(glm::vec3 p0, glm::vec3 dir);
-
-	glm::vec3 normal(glm::vec3 p);
-
-};
-
-#endif //!H_CONE
+/*----------------------------------------------------------
+* COSC363  Ray Tracer
+*
+*  The sphere class
+*  This is a subclass of Object, and hence implements the
+*  methods intersect() and normal().
+-------------------------------------------------------------*/
+
+#ifndef H_CONE
+#define H_CONE
+#include <glm/glm.hpp>
+#include "SceneObject.h"
+
+/**
+ * Defines a simple Sphere located at 'center'
+ * with the specified radius
+ */
+class Cone : public SceneObject
+{
+
+private:
+    glm::vec3 center = glm::vec3(0);
+    float radius = 1;
+    float height = 1;
+
+public:
+	Cone() {};  //Default constructor creates a unit sphere
+
+	Cone(glm::vec3 c, float r, float h) : center(c), radius(r), height(h){}
+
+	float intersect(glm::vec3 p0, glm::vec3 dir);
+
+	glm::vec3 normal(glm::vec3 p);
+	glm::vec2 textureCoords(glm::vec3 p);
+
+	BoundingBox bounds();
+
+	void translate(glm::vec3 d);
+
+	SceneObject* clone();
+	ShapeKind getShape(float* params);
+
+};
+
+#endif //!H_CONE
@@ -0,0 +1,161 @@
+/*----------------------------------------------------------
+* COSC363  Ray Tracer
+*
+*  The denoiser class
+-------------------------------------------------------------*/
+
+#include "Denoiser.h"
+#include "ParallelFor.h"
+#include <algorithm>
+#include <cstdlib>
+
+namespace
+{
+    const float KERNEL[3] = {3.0f / 8.0f, 1.0f / 4.0f, 1.0f / 16.0f};
+
+    //Albedo below this is treated as 1, so dark channels are not amplified
+    const float MIN_ALBEDO = 0.02f;
+
+    float demodulationFactor(float albedo)
+    {
+        return albedo > MIN_ALBEDO ? albedo : 1.0f;
+    }
+}
+
+void Denoiser::setIterations(int iterations)
+{
+    iterations_ = std::max(0, iterations);
+}
+
+void Denoiser::setColorSigma(float sigma)
+{
+    colorSigma_ = sigma;
+}
+
+void Denoiser::setNormalSigma(float sigma)
+{
+    normalSigma_ = sigma;
+}
+
+void Denoiser::setDepthSigma(float sigma)
+{
+    depthSigma_ = sigma;
+}
+
+void Denoiser::setThreadCount(int threads)
+{
+    threadCount_ = threads;
+}
+
+/**
+* The edge-stopping weight of a tap is h / (1 + dc/sc^2 + dn/sn + dd/sd^2),
+* a rational falloff that keeps the inner loops free of exp() so that they
+* vectorise. Every output row accumulates all 25 taps over the whole row
+* at once, with the structure-of-arrays planes read contiguously.
+*/
+void Denoiser::denoise(GBuffer& buffer)
+{
+    int width = buffer.width;
+    int height = buffer.height;
+    size_t n = (size_t)width * height;
+
+    std::vector<float> inR(n), inG(n), inB(n);
+    std::vector<float> outR(n), outG(n), outB(n);
+    for(size_t k = 0; k < n; k++)
+    {
+        inR[k] = buffer.r[k] / demodulationFactor(buffer.ar[k]);
+        inG[k] = buffer.g[k] / demodulationFactor(buffer.ag[k]);
+        inB[k] = buffer.b[k] / demodulationFactor(buffer.ab[k]);
+    }
+
+    float invNormal = 1.0f / normalSigma_;
+    float invDepth = 1.0f / (depthSigma_ * depthSigma_);
+
+    for(int iteration = 0; iteration < iterations_; iteration++)
+    {
+        int step = 1 << iteration;
+        float sigma = colorSigma_ / (1 << iteration);
+        float invColor = 1.0f / (sigma * sigma);
+
+        parallelFor(height, threadCount_, [&](int y)
+        {
+            std::vector<float> sumR(width, 0), sumG(width, 0), sumB(width, 0), sumW(width, 0);
+            size_t row = (size_t)y * width;
+            const float* cR = &inR[row];
+            const float* cG = &inG[row];
+            const float* cB = &inB[row];
+            const float* cNx = &buffer.nx[row];
+            const float* cNy = &buffer.ny[row];
+            const float* cNz = &buffer.nz[row];
+            const float* cD = &buffer.depth[row];
+            const int* cId = &buffer.objectId[row];
+
+            for(int dy = -2; dy <= 2; dy++)
+            {
+                int yy = y + dy * step;
+                if(yy < 0 || yy >= height) continue;
+
+                for(int dx = -2; dx <= 2; dx++)
+                {
+                    float h = KERNEL[abs(dx)] * KERNEL[abs(dy)];
+                    int offset = dx * step;
+                    int x0 = std::max(0, -offset);
+                    int x1 = std::min(width, width - offset);
+
+                    size_t nrow = (size_t)yy * width;
+                    const float* nR = &inR[nrow];
+                    const float* nG = &inG[nrow];
+                    const float* nB = &inB[nrow];
+                    const float* nNx = &buffer.nx[nrow];
+                    const float* nNy = &buffer.ny[nrow];
+                    const float* nNz = &buffer.nz[nrow];
+                    const float* nD = &buffer.depth[nrow];
+                    const int* nId = &buffer.objectId[nrow];
+
+                    for(int x = x0; x < x1; x++)
+                    {
+                        int xx = x + offset;
+                        float dr = cR[x] - nR[xx];
+                        float dg = cG[x] - nG[xx];
+                        float db = cB[x] - nB[xx];
+                        float dc = dr * dr + dg * dg + db * db;
+
+                        float dn = 1.0f - (cNx[x] * nNx[xx] + cNy[x] * nNy[xx] + cNz[x] * nNz[xx]);
+                        dn = dn > 0 ? dn : 0;
+
+                        float dd = (cD[x] - nD[xx]) / (cD[x] + 1.e-3f);
+                        dd = dd * dd;
+
+                        float w = h / (1.0f + dc * invColor + dn * invNormal + dd * invDepth);
+                        w = cId[x] == nId[xx] ? w : 0.0f;
+
+                        sumR[x] += w * nR[xx];
+                        sumG[x] += w * nG[xx];
+                        sumB[x] += w * nB[xx];
+                        sumW[x] += w;
+                    }
+                }
+            }
+
+            //The centre tap always has a positive weight
+            for(int x = 0; x < width; x++)
+            {
+                float inv = 1.0f / sumW[x];
+                outR[row + x] = sumR[x] * inv;
+                outG[row + x] = sumG[x] * inv;
+                outB[row + x] = sumB[x] * inv;
+            }
+        });
+
+        inR.swap(outR);
+        inG.swap(outG);
+        inB.swap(outB);
+    }
+
+    for(size_t k = 0; k < n; k++)
+    {
+        buffer.r[k] = inR[k] * demodulationFactor(buffer.ar[k]);
+        buffer.g[k] = inG[k] * demodulationFactor(buffer.ag[k]);
+        buffer.b[k] = inB[k] * demodulationFactor(buffer.ab[k]);
+    }
+}
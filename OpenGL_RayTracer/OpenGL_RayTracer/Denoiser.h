@@ -0,0 +1,41 @@
+/*----------------------------------------------------------
+* COSC363  Ray Tracer
+*
+*  The denoiser class
+*  Edge-avoiding a-trous wavelet filter (Dammertz et al.,
+*  HPG 2010) for images rendered with few samples per pixel.
+*  The colour is divided by the albedo so that texture detail
+*  is not blurred, smoothed with a 5x5 B3-spline kernel whose
+*  taps are spread 1, 2, 4, ... pixels apart, and multiplied
+*  back. Each tap is weighted down by differences in colour,
+*  normal and depth, and ignored across object boundaries.
+-------------------------------------------------------------*/
+
+#ifndef H_DENOISER
+#define H_DENOISER
+
+#include "GBuffer.h"
+
+class Denoiser
+{
+private:
+    int iterations_ = 5;
+    float colorSigma_ = 0.2;    //Illumination difference, halved every iteration
+    float normalSigma_ = 0.3;   //1 - cos of the angle between normals
+    float depthSigma_ = 0.05;   //Relative depth difference
+    int threadCount_ = 0;       //0: one per hardware thread
+
+public:
+    Denoiser() {}
+
+    void setIterations(int iterations);
+    void setColorSigma(float sigma);
+    void setNormalSigma(float sigma);
+    void setDepthSigma(float sigma);
+    void setThreadCount(int threads);
+
+    //Filters the colour planes of the buffer in place
+    void denoise(GBuffer& buffer);
+};
+
+#endif //!H_DENOISER
@@ -0,0 +1,348 @@
+/*----------------------------------------------------------
+* COSC363  Ray Tracer
+*
+*  The distributed renderer class
+-------------------------------------------------------------*/
+
+#include "DistributedRenderer.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <deque>
+#include <errno.h>
+#include <iostream>
+#include <map>
+#include <poll.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace
+{
+    //Coordinator -> worker, sent once
+    struct FrameSetup
+    {
+        int width;
+        int height;
+    };
+
+    //Coordinator -> worker; band == -1 asks the worker to exit
+    struct BandRequest
+    {
+        int band;
+        int firstRow;
+        int rows;
+    };
+
+    //Worker -> coordinator, followed by width * rows * 3 bytes of RGB
+    struct BandResult
+    {
+        int band;
+        int rows;
+    };
+
+    //Per-worker bookkeeping on the coordinator side
+    struct WorkerLink
+    {
+        int socket = -1;
+        int band = -1;  //Band currently assigned, -1 if idle
+        std::chrono::steady_clock::time_point started;
+    };
+
+    bool sendAll(int fd, const void* data, size_t size)
+    {
+        const char* p = (const char*)data;
+        while(size > 0)
+        {
+            ssize_t n = send(fd, p, size, MSG_NOSIGNAL);
+            if(n < 0 && errno == EINTR) continue;
+            if(n <= 0) return false;
+            p += n;
+            size -= n;
+        }
+        return true;
+    }
+
+    bool receiveAll(int fd, void* data, size_t size)
+    {
+        char* p = (char*)data;
+        while(size > 0)
+        {
+            ssize_t n = recv(fd, p, size, 0);
+            if(n < 0 && errno == EINTR) continue;
+            if(n <= 0) return false;
+            p += n;
+            size -= n;
+        }
+        return true;
+    }
+}
+
+DistributedRenderer::DistributedRenderer(int width, int height) : width_(width), height_(height)
+{
+}
+
+void DistributedRenderer::setWorkerCount(int workers)
+{
+    workerCount_ = std::max(1, workers);
+}
+
+void DistributedRenderer::setBandRows(int rows)
+{
+    bandRows_ = std::max(1, rows);
+}
+
+void DistributedRenderer::setMemoryLimit(size_t bytes)
+{
+    memoryLimit_ = bytes;
+}
+
+void DistributedRenderer::setFailingWorker(int worker)
+{
+    failingWorker_ = worker;
+}
+
+std::vector<WorkerStats>& DistributedRenderer::getWorkerStats()
+{
+    return stats_;
+}
+
+/**
+* Worker process main loop: receives the frame setup, then renders
+* band requests until asked to exit or the coordinator goes away.
+*/
+void DistributedRenderer::serve(int socket, PixelFunction& pixel, bool failing)
+{
+    FrameSetup setup;
+    if(!receiveAll(socket, &setup, sizeof(setup))) return;
+
+    std::vector<unsigned char> rgb;
+    int served = 0;
+    BandRequest request;
+    while(receiveAll(socket, &request, sizeof(request)) && request.band >= 0)
+    {
+        if(failing && served == 1) return;
+
+        rgb.resize((size_t)setup.width * request.rows * 3);
+        StreamingRenderer::renderRows(pixel, setup.width, setup.height, request.firstRow, request.rows, rgb.data());
+
+        BandResult result;
+        result.band = request.band;
+        result.rows = request.rows;
+        if(!sendAll(socket, &result, sizeof(result)) || !sendAll(socket, rgb.data(), rgb.size())) return;
+        served++;
+    }
+}
+
+/**
+* Bands are handed out in increasing order, but never more than the memory
+* limit allows ahead of the next band to be written, so results that arrive
+* out of order are buffered in bounded memory.
+*/
+bool DistributedRenderer::render(PixelFunction pixel, BandSink sink)
+{
+    int bandCount = (height_ + bandRows_ - 1) / bandRows_;
+    size_t bandBytes = (size_t)width_ * bandRows_ * 3;
+    int maxAhead = (int)std::max((size_t)workerCount_, memoryLimit_ / bandBytes);
+
+    stats_.assign(workerCount_, WorkerStats());
+    std::vector<WorkerLink> links(workerCount_);
+
+    fflush(stdout);
+    for(int w = 0; w < workerCount_; w++)
+    {
+        int fds[2];
+        if(socketpair(AF_UNIX, SOCK_STREAM, 0, fds) != 0)
+        {
+            perror("socketpair");
+            stats_[w].died = true;
+            continue;
+        }
+
+        pid_t pid = fork();
+        if(pid == 0)
+        {
+            close(fds[0]);
+            for(int other = 0; other < w; other++)
+            {
+                if(links[other].socket >= 0) close(links[other].socket);
+            }
+            serve(fds[1], pixel, w == failingWorker_);
+            close(fds[1]);
+            _exit(0);
+        }
+
+        close(fds[1]);
+        if(pid < 0)
+        {
+            perror("fork");
+            close(fds[0]);
+            stats_[w].died = true;
+            continue;
+        }
+
+        FrameSetup setup;
+        setup.width = width_;
+        setup.height = height_;
+        links[w].socket = fds[0];
+        stats_[w].pid = pid;
+        if(!sendAll(fds[0], &setup, sizeof(setup)))
+        {
+            stats_[w].died = true;
+        }
+    }
+
+    std::deque<int> pending;            //Bands to hand out, re-issued ones first
+    int nextNewBand = 0;
+    int nextToWrite = 0;
+    std::map<int, std::vector<unsigned char> > finished;
+    bool failed = false;
+
+    auto markDead = [&](int w)
+    {
+        if(links[w].band >= 0) pending.push_front(links[w].band);
+        std::cerr << "*** Worker " << w << " (pid " << stats_[w].pid << ") died";
+        if(links[w].band >= 0) std::cerr << ", re-issuing band " << links[w].band;
+        std::cerr << std::endl;
+        links[w].band = -1;
+        close(links[w].socket);
+        links[w].socket = -1;
+        stats_[w].died = true;
+    };
+
+    while(nextToWrite < bandCount && !failed)
+    {
+        //Hand out work to idle workers
+        for(int w = 0; w < workerCount_; w++)
+        {
+            if(stats_[w].died || links[w].band >= 0) continue;
+
+            int band;
+            if(!pending.empty())
+            {
+                band = pending.front();
+                pending.pop_front();
+            }
+            else if(nextNewBand < bandCount && nextNewBand < nextToWrite + maxAhead)
+            {
+                band = nextNewBand++;
+            }
+            else
+            {
+                break;
+            }
+
+            BandRequest request;
+            request.band = band;
+            request.firstRow = band * bandRows_;
+            request.rows = std::min(bandRows_, height_ - request.firstRow);
+            links[w].band = band;
+            links[w].started = std::chrono::steady_clock::now();
+            if(!sendAll(links[w].socket, &request, sizeof(request)))
+            {
+                markDead(w);
+            }
+        }
+
+        std::vector<pollfd> fds;
+        std::vector<int> owners;
+        for(int w = 0; w < workerCount_; w++)
+        {
+            if(stats_[w].died || links[w].band < 0) continue;
+            pollfd p;
+            p.fd = links[w].socket;
+            p.events = POLLIN;
+            p.revents = 0;
+            fds.push_back(p);
+            owners.push_back(w);
+        }
+        if(fds.empty())
+        {
+            std::cerr << "*** No workers left to render the remaining bands" << std::endl;
+            failed = true;
+            break;
+        }
+
+        if(poll(fds.data(), fds.size(), -1) < 0)
+        {
+            if(errno == EINTR) continue;
+            perror("poll");
+            failed = true;
+            break;
+        }
+
+        for(uint k = 0; k < fds.size(); k++)
+        {
+            if(fds[k].revents == 0) continue;
+            int w = owners[k];
+
+            BandResult result;
+            std::vector<unsigned char> rgb;
+            bool ok = receiveAll(links[w].socket, &result, sizeof(result)) && result.band == links[w].band;
+            if(ok)
+            {
+                rgb.resize((size_t)width_ * result.rows * 3);
+                ok = receiveAll(links[w].socket, rgb.data(), rgb.size());
+            }
+            if(!ok)
+            {
+                markDead(w);
+                continue;
+            }
+
+            std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - links[w].started;
+            stats_[w].bands++;
+            stats_[w].pixels += (long long)width_ * result.rows;
+            stats_[w].seconds += elapsed.count();
+            links[w].band = -1;
+            finished[result.band].swap(rgb);
+        }
+
+        //Write out whatever is now contiguous
+        while(!finished.empty() && finished.begin()->first == nextToWrite)
+        {
+            std::vector<unsigned char>& rgb = finished.begin()->second;
+            int firstRow = nextToWrite * bandRows_;
+            int rows = std::min(bandRows_, height_ - firstRow);
+            if(!sink(rgb.data(), firstRow, rows))
+            {
+                failed = true;
+                break;
+            }
+            finished.erase(finished.begin());
+            nextToWrite++;
+        }
+    }
+
+    for(int w = 0; w < workerCount_; w++)
+    {
+        if(links[w].socket >= 0)
+        {
+            BandRequest quit;
+            quit.band = -1;
+            quit.firstRow = 0;
+            quit.rows = 0;
+            sendAll(links[w].socket, &quit, sizeof(quit));
+            close(links[w].socket);
+        }
+        if(stats_[w].pid > 0)
+        {
+            int status = 0;
+            waitpid(stats_[w].pid, &status, 0);
+        }
+    }
+
+    return !failed;
+}
+
+void DistributedRenderer::printReport()
+{
+    for(uint w = 0; w < stats_.size(); w++)
+    {
+        WorkerStats& s = stats_[w];
+        double rate = s.seconds > 0 ? s.pixels / s.seconds : 0;
+        printf("Worker %u (pid %d): %d bands, %lld pixels, %.2f s busy, %.0f pixels/s%s\n",
+               w, (int)s.pid, s.bands, s.pixels, s.seconds, rate, s.died ? " [died]" : "");
+    }
+}
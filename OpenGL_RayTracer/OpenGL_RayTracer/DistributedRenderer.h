@@ -0,0 +1,60 @@
+/*----------------------------------------------------------
+* COSC363  Ray Tracer
+*
+*  The distributed renderer class
+*  Splits a frame across several worker processes. The
+*  coordinator forks the workers (which inherit the built
+*  scene), sends each one the frame setup once over a Unix
+*  domain socket and then hands out bands of rows. Finished
+*  bands are passed to the sink in order; bands held by a
+*  worker that dies are re-issued to the surviving workers.
+-------------------------------------------------------------*/
+
+#ifndef H_DISTRIBUTED_RENDERER
+#define H_DISTRIBUTED_RENDERER
+
+#include "StreamingRenderer.h"
+#include <vector>
+#include <sys/types.h>
+
+//Per-worker counters reported after a render
+struct WorkerStats
+{
+    pid_t pid = -1;
+    int bands = 0;          //Bands delivered
+    long long pixels = 0;   //Pixels delivered
+    double seconds = 0;     //Time between handing out and receiving its bands
+    bool died = false;
+};
+
+class DistributedRenderer
+{
+private:
+    int width_;
+    int height_;
+    int workerCount_ = 2;
+    int bandRows_ = 16;
+    size_t memoryLimit_ = 64 << 20;
+    int failingWorker_ = -1;
+    std::vector<WorkerStats> stats_;
+
+    void serve(int socket, PixelFunction& pixel, bool failing);
+
+public:
+    DistributedRenderer(int width, int height);
+
+    void setWorkerCount(int workers);
+    void setBandRows(int rows);
+    void setMemoryLimit(size_t bytes);
+
+    //Makes the given worker exit part-way through its second band (for testing re-issue)
+    void setFailingWorker(int worker);
+
+    //Renders the whole image; returns false if every worker died or the sink rejected a band
+    bool render(PixelFunction pixel, BandSink sink);
+
+    std::vector<WorkerStats>& getWorkerStats();
+    void printReport();
+};
+
+#endif //!H_DISTRIBUTED_RENDERER
@@ -0,0 +1,151 @@
+/*----------------------------------------------------------
+* COSC363  Ray Tracer
+*
+*  Fast math functions
+-------------------------------------------------------------*/
+
+#include "FastMath.h"
+#include <cstdio>
+#include <chrono>
+#include <vector>
+using namespace std;
+
+#ifdef RAYTRACER_FAST_MATH
+MathMode mathMode = MATH_FAST;
+#else
+MathMode mathMode = MATH_PRECISE;
+#endif
+
+namespace
+{
+    const int SAMPLES = 200000;
+
+    //Nanoseconds per call of f over the inputs, summing the results so they are not optimised away
+    template<typename Function>
+    double timePerCall(const vector<float>& inputs, Function f)
+    {
+        volatile float sink = 0;
+        float sum = 0;
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        for(int repeat = 0; repeat < 10; repeat++)
+        {
+            for(size_t k = 0; k < inputs.size(); k++)
+            {
+                sum += f(inputs[k]);
+            }
+        }
+        chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+        sink = sum;
+        (void)sink;
+        return elapsed.count() * 1.e9 / (10.0 * inputs.size());
+    }
+
+    bool report(const char* name, double error, double bound, const char* kind, double fastNs, double libmNs)
+    {
+        bool ok = error < bound;
+        printf("%-12s %s error %.3g (bound %.3g)   %6.2f ns vs libm %6.2f ns   %s\n",
+               name, kind, error, bound, fastNs, libmNs, ok ? "ok" : "EXCEEDED");
+        return ok;
+    }
+}
+
+/**
+* The inputs are deterministic sweeps over each function's valid range,
+* with libm evaluated in double precision as the reference.
+*/
+bool checkFastMathAccuracy()
+{
+    bool ok = true;
+
+    //pow over the specular range: bases in (0, 1], exponents 1-200
+    {
+        const float exponents[] = {1, 2, 5, 10, 20, 50, 100, 128, 200};
+        double maxError = 0;
+        vector<float> bases;
+        for(int k = 0; k < SAMPLES; k++)
+        {
+            float x = (k + 0.5f) / SAMPLES;
+            bases.push_back(x);
+            for(int e = 0; e < 9; e++)
+            {
+                double exact = pow((double)x, (double)exponents[e]);
+                if(exact < 1.e-30) continue;
+                maxError = max(maxError, fabs(fastPow(x, exponents[e]) - exact) / exact);
+            }
+        }
+        ok &= report("fastPow", maxError, 2.e-5, "relative",
+                     timePerCall(bases, [](float x) { return fastPow(x, 50.0f); }),
+                     timePerCall(bases, [](float x) { return (float)pow((double)x, 50.0); }));
+    }
+
+    //atan over [-1000, 1000], densest near 0
+    {
+        double maxError = 0;
+        vector<float> inputs;
+        for(int k = 0; k < SAMPLES; k++)
+        {
+            float u = -1.0f + 2.0f * (k + 0.5f) / SAMPLES;
+            float x = u * u * u * 1000.0f;
+            inputs.push_back(x);
+            maxError = max(maxError, fabs(fastAtan(x) - atan((double)x)));
+        }
+        ok &= report("fastAtan", maxError, 2.e-7, "absolute",
+                     timePerCall(inputs, [](float x) { return fastAtan(x); }),
+                     timePerCall(inputs, [](float x) { return atanf(x); }));
+    }
+
+    //atan2 around the circle at several radii
+    {
+        double maxError = 0;
+        vector<float> inputs;
+        for(int k = 0; k < SAMPLES; k++)
+        {
+            double angle = -M_PI + 2.0 * M_PI * (k + 0.5) / SAMPLES;
+            float radius = 0.001f * (1 + k % 7) * (k % 3 == 0 ? 1000.0f : 1.0f);
+            float y = radius * sin(angle);
+            float x = radius * cos(angle);
+            inputs.push_back(x);
+            maxError = max(maxError, fabs(fastAtan2(y, x) - atan2((double)y, (double)x)));
+        }
+        ok &= report("fastAtan2", maxError, 4.e-7, "absolute",
+                     timePerCall(inputs, [](float x) { return fastAtan2(0.5f, x); }),
+                     timePerCall(inputs, [](float x) { return atan2f(0.5f, x); }));
+    }
+
+    //sin and cos over [-1e4, 1e4], densest near 0
+    {
+        double maxError = 0;
+        vector<float> inputs;
+        for(int k = 0; k < SAMPLES; k++)
+        {
+            float u = -1.0f + 2.0f * (k + 0.5f) / SAMPLES;
+            float a = u * u * u * 1.e4f;
+            inputs.push_back(a);
+            float s, c;
+            fastSinCos(a, s, c);
+            maxError = max(maxError, max(fabs(s - sin((double)a)), fabs(c - cos((double)a))));
+        }
+        ok &= report("fastSinCos", maxError, 2.e-7, "absolute",
+                     timePerCall(inputs, [](float a) { float s, c; fastSinCos(a, s, c); return s + c; }),
+                     timePerCall(inputs, [](float a) { return sinf(a) + cosf(a); }));
+    }
+
+    //rsqrt over [1e-30, 1e30]
+    {
+        double maxError = 0;
+        vector<float> inputs;
+        for(int k = 0; k < SAMPLES; k++)
+        {
+            float x = (float)pow(10.0, -30.0 + 60.0 * (k + 0.5) / SAMPLES);
+            inputs.push_back(x);
+            double exact = 1.0 / sqrt((double)x);
+            maxError = max(maxError, fabs(fastRsqrt(x) - exact) / exact);
+        }
+        ok &= report("fastRsqrt", maxError, 5.e-6, "relative",
+                     timePerCall(inputs, [](float x) { return fastRsqrt(x); }),
+                     timePerCall(inputs, [](float x) { return 1.0f / sqrtf(x); }));
+    }
+
+    printf(ok ? "All errors within their bounds\n" : "Some errors exceed their bounds\n");
+    return ok;
+}
@@ -0,0 +1,167 @@
+/*----------------------------------------------------------
+* COSC363  Ray Tracer
+*
+*  Fast math functions
+*  Approximations of the transcendentals used by shading and
+*  intersection, built from bit manipulation and short
+*  polynomials so that they inline and contain no library
+*  calls. Errors are measured against libm by
+*  checkFastMathAccuracy() (--math-accuracy):
+*    fastPow      relative error < 2e-5 for results > 1e-30
+*                 (x > 0, |y * log2(x)| < 126); 0 for x <= 0
+*    fastAtan     absolute error < 2e-7 rad
+*    fastAtan2    absolute error < 4e-7 rad
+*    fastSinCos   absolute error < 2e-7 for |a| < 1e4
+*    fastRsqrt    relative error < 5e-6 for normal x > 0
+*  fastRsqrt is no faster than 1/sqrtf() where sqrtss exists,
+*  so normalisation keeps using glm::normalize().
+*  The math*() functions use either these or the libm
+*  functions, depending on 'mathMode'. Precise mode is the
+*  default unless RAYTRACER_FAST_MATH is defined.
+-------------------------------------------------------------*/
+
+#ifndef H_FAST_MATH
+#define H_FAST_MATH
+
+#include <glm/glm.hpp>
+#include <cmath>
+#include <cstring>
+#include <stdint.h>
+
+enum MathMode
+{
+    MATH_PRECISE,
+    MATH_FAST
+};
+
+extern MathMode mathMode;
+
+inline uint32_t floatBits(float x)
+{
+    uint32_t bits;
+    memcpy(&bits, &x, 4);
+    return bits;
+}
+
+inline float bitsFloat(uint32_t bits)
+{
+    float x;
+    memcpy(&x, &bits, 4);
+    return x;
+}
+
+//log2(x) for normal x > 0; absolute error about 1e-7
+inline float fastLog2(float x)
+{
+    //x = m * 2^e with m in [sqrt(1/2), sqrt(2)); log2(m) = 2/ln2 * atanh(z), z = (m - 1)/(m + 1)
+    uint32_t bits = floatBits(x);
+    int e = (int)((bits >> 23) & 255) - 127;
+    float m = bitsFloat((bits & 0x007fffff) | 0x3f800000);
+    if(m > 1.41421356f)
+    {
+        m *= 0.5f;
+        e++;
+    }
+    float z = (m - 1.0f) / (m + 1.0f);
+    float z2 = z * z;
+    float series = z * (2.88539008f + z2 * (0.96179669f + z2 * (0.57707801f + z2 * 0.41219858f)));
+    return e + series;
+}
+
+//2^x, clamped to the normal float range; relative error about 2e-7
+inline float fastExp2(float x)
+{
+    x = glm::clamp(x, -126.0f, 127.0f);
+    int xi = (int)x;
+    if(x < xi) xi--;    //floor
+    float g = (x - xi - 0.5f) * 0.693147181f;   //2^(x - xi) = sqrt(2) * e^g, |g| <= ln2/2
+    float eg = 1.0f + g * (1.0f + g * (0.5f + g * (0.166666667f + g * (0.0416666667f + g * (0.00833333333f + g * 0.00138888889f)))));
+    return bitsFloat((uint32_t)(xi + 127) << 23) * 1.41421356f * eg;
+}
+
+inline float fastPow(float x, float y)
+{
+    if(x <= 0) return 0;
+    return fastExp2(y * fastLog2(x));
+}
+
+//atan(x) from Abramowitz & Stegun 4.4.49 on [0, 1], and pi/2 - atan(1/x) beyond
+inline float fastAtan(float x)
+{
+    float ax = fabsf(x);
+    bool inverted = ax > 1.0f;
+    float u = inverted ? 1.0f / ax : ax;
+    float u2 = u * u;
+    float r = u * (1.0f + u2 * (-0.3333314528f + u2 * (0.1999355085f + u2 * (-0.1420889944f + u2 * (0.1065626393f
+                + u2 * (-0.0752896400f + u2 * (0.0429096138f + u2 * (-0.0161657367f + u2 * 0.0028662257f))))))));
+    if(inverted) r = 1.57079633f - r;
+    return x < 0 ? -r : r;
+}
+
+inline float fastAtan2(float y, float x)
+{
+    if(x == 0)
+    {
+        return y > 0 ? 1.57079633f : y < 0 ? -1.57079633f : 0.0f;
+    }
+    float r = fastAtan(y / x);
+    if(x > 0) return r;
+    return y >= 0 ? r + 3.14159265f : r - 3.14159265f;
+}
+
+//sin(a) and cos(a): reduction to [-pi/4, pi/4] and Taylor polynomials
+inline void fastSinCos(float a, float& s, float& c)
+{
+    int quadrant = (int)(a * 0.636619772f + (a < 0 ? -0.5f : 0.5f));
+    float k = (float)quadrant;
+    float r = (a - k * 1.5703125f) - k * 4.83826794897e-4f;   //pi/2 split into two parts
+    float r2 = r * r;
+    float sr = r * (1.0f + r2 * (-0.166666667f + r2 * (0.00833333333f + r2 * (-1.98412698e-4f + r2 * 2.75573192e-6f))));
+    float cr = 1.0f + r2 * (-0.5f + r2 * (0.0416666667f + r2 * (-0.00138888889f + r2 * (2.48015873e-5f + r2 * -2.75573192e-7f))));
+    switch(quadrant & 3)
+    {
+        case 0: s = sr;  c = cr;  break;
+        case 1: s = cr;  c = -sr; break;
+        case 2: s = -sr; c = -cr; break;
+        default: s = -cr; c = sr; break;
+    }
+}
+
+//1/sqrt(x): bit-level first guess and two Newton steps
+inline float fastRsqrt(float x)
+{
+    float y = bitsFloat(0x5f375a86 - (floatBits(x) >> 1));
+    float half = 0.5f * x;
+    y = y * (1.5f - half * y * y);
+    y = y * (1.5f - half * y * y);
+    return y;
+}
+
+inline float mathPow(float x, float y)
+{
+    return mathMode == MATH_FAST ? fastPow(x, y) : (float)std::pow((double)x, (double)y);
+}
+
+inline float mathAtan(float x)
+{
+    return mathMode == MATH_FAST ? fastAtan(x) : std::atan(x);
+}
+
+inline void mathSinCos(float a, float& s, float& c)
+{
+    if(mathMode == MATH_FAST)
+    {
+        fastSinCos(a, s, c);
+    }
+    else
+    {
+        s = sinf(a);
+        c = cosf(a);
+    }
+}
+
+//Compares the fast functions with libm over their ranges and prints the errors
+//and timings; false if an error exceeds its documented bound
+bool checkFastMathAccuracy();
+
+#endif //!H_FAST_MATH
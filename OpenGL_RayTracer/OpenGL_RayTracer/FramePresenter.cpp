@@ -0,0 +1,98 @@
+/*----------------------------------------------------------
+* COSC363  Ray Tracer
+*
+*  The frame presenter class
+-------------------------------------------------------------*/
+
+#define GL_GLEXT_PROTOTYPES
+#include "FramePresenter.h"
+#include <cstring>
+#include <vector>
+
+void FramePresenter::initialize()
+{
+    glGenTextures(1, &texture_);
+    glBindTexture(GL_TEXTURE_2D, texture_);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+    usePixelBuffers_ = glutExtensionSupported("GL_ARB_pixel_buffer_object") != 0;
+    if(usePixelBuffers_)
+    {
+        glGenBuffers(2, pixelBuffers_);
+    }
+}
+
+void FramePresenter::resize(int width, int height)
+{
+    if(width == width_ && height == height_) return;
+
+    width_ = width;
+    height_ = height;
+    std::vector<unsigned char> black((size_t)width * height * 4, 0);
+    glBindTexture(GL_TEXTURE_2D, texture_);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, black.data());
+}
+
+/**
+* Texture row 0 holds the top image row; draw() flips the texture
+* coordinates to match, so bands never need to be reordered.
+*/
+void FramePresenter::uploadRows(const unsigned char* rgba, int firstRow, int rows)
+{
+    size_t size = (size_t)width_ * rows * 4;
+    glBindTexture(GL_TEXTURE_2D, texture_);
+
+    if(usePixelBuffers_)
+    {
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pixelBuffers_[nextPixelBuffer_]);
+        nextPixelBuffer_ = 1 - nextPixelBuffer_;
+
+        //Orphan the old storage so the copy does not wait for a pending upload
+        glBufferData(GL_PIXEL_UNPACK_BUFFER, size, NULL, GL_STREAM_DRAW);
+        void* mapped = glMapBuffer(GL_PIXEL_UNPACK_BUFFER, GL_WRITE_ONLY);
+        if(mapped != NULL)
+        {
+            memcpy(mapped, rgba, size);
+            glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+            glTexSubImage2D(GL_TEXTURE_2D, 0, 0, firstRow, width_, rows, GL_RGBA, GL_UNSIGNED_BYTE, 0);
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+            return;
+        }
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    }
+
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, firstRow, width_, rows, GL_RGBA, GL_UNSIGNED_BYTE, rgba);
+}
+
+void FramePresenter::draw(float x0, float y0, float x1, float y1)
+{
+    glEnable(GL_TEXTURE_2D);
+    glTexEnvi(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_REPLACE);
+    glBindTexture(GL_TEXTURE_2D, texture_);
+    glBegin(GL_QUADS);
+        glTexCoord2f(0, 1); glVertex2f(x0, y0);
+        glTexCoord2f(1, 1); glVertex2f(x1, y0);
+        glTexCoord2f(1, 0); glVertex2f(x1, y1);
+        glTexCoord2f(0, 0); glVertex2f(x0, y1);
+    glEnd();
+    glDisable(GL_TEXTURE_2D);
+}
+
+int FramePresenter::getWidth()
+{
+    return width_;
+}
+
+int FramePresenter::getHeight()
+{
+    return height_;
+}
+
+bool FramePresenter::usesPixelBuffers()
+{
+    return usePixelBuffers_;
+}
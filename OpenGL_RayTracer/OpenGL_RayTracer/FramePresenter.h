@@ -0,0 +1,50 @@
+/*----------------------------------------------------------
+* COSC363  Ray Tracer
+*
+*  The frame presenter class
+*  Shows a packed RGBA8 framebuffer in the window as a single
+*  textured quad, instead of one GL_QUADS cell per pixel. Rows
+*  are uploaded with glTexSubImage2D as soon as they are ready,
+*  through a pair of pixel buffer objects used in turn (when
+*  the GL supports them), so the driver can copy one band while
+*  the next is being filled. The texture is stretched over the
+*  view with linear filtering, so the render resolution does
+*  not have to match the window.
+-------------------------------------------------------------*/
+
+#ifndef H_FRAME_PRESENTER
+#define H_FRAME_PRESENTER
+
+#include <GL/freeglut.h>
+
+class FramePresenter
+{
+private:
+    GLuint texture_ = 0;
+    GLuint pixelBuffers_[2] = {0, 0};
+    int nextPixelBuffer_ = 0;
+    bool usePixelBuffers_ = false;
+    int width_ = 0;
+    int height_ = 0;
+
+public:
+    FramePresenter() {}
+
+    //Creates the GL objects; needs a current GL context
+    void initialize();
+
+    //Sets the framebuffer size, clearing it to black if the size changes
+    void resize(int width, int height);
+
+    //Uploads 'rows' packed RGBA rows starting at 'firstRow' (counted from the top)
+    void uploadRows(const unsigned char* rgba, int firstRow, int rows);
+
+    //Draws the framebuffer over the rectangle (x0, y0) - (x1, y1) of the current projection
+    void draw(float x0, float y0, float x1, float y1);
+
+    int getWidth();
+    int getHeight();
+    bool usesPixelBuffers();
+};
+
+#endif //!H_FRAME_PRESENTER
@@ -0,0 +1,75 @@
+/*----------------------------------------------------------
+* COSC363  Ray Tracer
+*
+*  The G-buffer class
+*  Per-pixel colour plus the auxiliary data of the primary
+*  hit (normal, depth, object ID and albedo) that trace()
+*  can emit alongside the colour. Stored as separate planes
+*  (structure of arrays) so that post-process filters can
+*  run over whole rows with vectorisable loops. Row 0 is the
+*  bottom row, as in display().
+-------------------------------------------------------------*/
+
+#ifndef H_GBUFFER
+#define H_GBUFFER
+
+#include <vector>
+#include <glm/glm.hpp>
+
+//What the primary ray of a pixel hit; objectId is -1 for background
+struct PrimaryHit
+{
+    glm::vec3 normal = glm::vec3(0);
+    float depth = 0;
+    int objectId = -1;
+    glm::vec3 albedo = glm::vec3(0);
+};
+
+class GBuffer
+{
+public:
+    int width = 0;
+    int height = 0;
+    std::vector<float> r, g, b;
+    std::vector<float> nx, ny, nz;
+    std::vector<float> depth;
+    std::vector<int> objectId;
+    std::vector<float> ar, ag, ab;
+
+    GBuffer() {}
+
+    GBuffer(int w, int h)
+    {
+        resize(w, h);
+    }
+
+    void resize(int w, int h)
+    {
+        width = w;
+        height = h;
+        size_t n = (size_t)w * h;
+        r.assign(n, 0); g.assign(n, 0); b.assign(n, 0);
+        nx.assign(n, 0); ny.assign(n, 0); nz.assign(n, 0);
+        depth.assign(n, 0);
+        objectId.assign(n, -1);
+        ar.assign(n, 0); ag.assign(n, 0); ab.assign(n, 0);
+    }
+
+    void set(int i, int j, glm::vec3 color, const PrimaryHit& hit)
+    {
+        size_t k = (size_t)j * width + i;
+        r[k] = color.r; g[k] = color.g; b[k] = color.b;
+        nx[k] = hit.normal.x; ny[k] = hit.normal.y; nz[k] = hit.normal.z;
+        depth[k] = hit.depth;
+        objectId[k] = hit.objectId;
+        ar[k] = hit.albedo.r; ag[k] = hit.albedo.g; ab[k] = hit.albedo.b;
+    }
+
+    glm::vec3 getColor(int i, int j) const
+    {
+        size_t k = (size_t)j * width + i;
+        return glm::vec3(r[k], g[k], b[k]);
+    }
+};
+
+#endif //!H_GBUFFER
@@ -0,0 +1,115 @@
+/*----------------------------------------------------------
+* COSC363  Ray Tracer
+*
+*  The instance class
+-------------------------------------------------------------*/
+
+#include "Instance.h"
+#include <algorithm>
+#include <cstring>
+
+Instance::Instance(std::shared_ptr<SharedGeometry> geometry, glm::mat4 objectToWorld)
+    : geometry_(geometry)
+{
+    setTransform(objectToWorld);
+}
+
+void Instance::setTransform(glm::mat4 objectToWorld)
+{
+    objectToWorld_ = objectToWorld;
+    worldToObject_ = glm::inverse(objectToWorld);
+    normalMatrix_ = glm::transpose(glm::mat3(worldToObject_));
+}
+
+/**
+* The object space direction is normalised for the parts' intersect(), so
+* its distance is scaled back by the direction's length in object space.
+*/
+float Instance::intersect(glm::vec3 p0, glm::vec3 dir)
+{
+    int part;
+    return intersect(p0, dir, part);
+}
+
+float Instance::intersect(glm::vec3 p0, glm::vec3 dir, int& part)
+{
+    glm::vec3 objectP0 = glm::vec3(worldToObject_ * glm::vec4(p0, 1));
+    glm::vec3 objectDir = glm::mat3(worldToObject_) * dir;
+    float scale = glm::length(objectDir);
+    float t;
+    part = geometry_->closestPt(objectP0, objectDir / scale, t);
+    if(part < 0) return -1;
+    return t / scale;
+}
+
+glm::vec3 Instance::normal(glm::vec3 p)
+{
+    return normal(p, 0);
+}
+
+glm::vec3 Instance::normal(glm::vec3 p, int part)
+{
+    glm::vec3 objectP = glm::vec3(worldToObject_ * glm::vec4(p, 1));
+    return glm::normalize(normalMatrix_ * geometry_->getPart(std::max(0, part))->normal(objectP));
+}
+
+glm::vec2 Instance::textureCoords(glm::vec3 p)
+{
+    return textureCoords(p, 0);
+}
+
+//The (u, v) of the geometry's part, in object space
+glm::vec2 Instance::textureCoords(glm::vec3 p, int part)
+{
+    glm::vec3 objectP = glm::vec3(worldToObject_ * glm::vec4(p, 1));
+    return geometry_->getPart(std::max(0, part))->textureCoords(objectP);
+}
+
+BoundingBox Instance::bounds()
+{
+    BoundingBox objectBox = geometry_->bounds();
+    BoundingBox box;
+    for(int corner = 0; corner < 8; corner++)
+    {
+        glm::vec3 p((corner & 1) ? objectBox.max.x : objectBox.min.x,
+                    (corner & 2) ? objectBox.max.y : objectBox.min.y,
+                    (corner & 4) ? objectBox.max.z : objectBox.min.z);
+        box.expand(glm::vec3(objectToWorld_ * glm::vec4(p, 1)));
+    }
+    return box;
+}
+
+void Instance::translate(glm::vec3 d)
+{
+    glm::mat4 moved = objectToWorld_;
+    moved[3] += glm::vec4(d, 0);
+    setTransform(moved);
+}
+
+SceneObject* Instance::clone()
+{
+    return new Instance(*this);
+}
+
+/**
+* The transform's top three rows, then the geometry's hash stored bit for
+* bit in the last parameter.
+*/
+ShapeKind Instance::getShape(float* params)
+{
+    for(int column = 0; column < 4; column++)
+    {
+        for(int row = 0; row < 3; row++)
+        {
+            params[3 * column + row] = objectToWorld_[column][row];
+        }
+    }
+    uint32_t hash = geometry_->getHash();
+    memcpy(&params[12], &hash, sizeof(hash));
+    return SHAPE_INSTANCE;
+}
+
+SharedGeometry* Instance::getGeometry()
+{
+    return geometry_.get();
+}
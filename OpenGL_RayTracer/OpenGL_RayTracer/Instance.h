@@ -0,0 +1,50 @@
+/*----------------------------------------------------------
+* COSC363  Ray Tracer
+*
+*  The instance class
+*  Places a SharedGeometry in the scene with an affine
+*  transform. Rays are moved into the geometry's object space
+*  and tested against its BVH, so any number of instances
+*  cost one copy of the geometry plus a transform each. The
+*  instance is shaded with its own material, set with the
+*  usual SceneObject setters.
+-------------------------------------------------------------*/
+
+#ifndef H_INSTANCE
+#define H_INSTANCE
+
+#include <glm/glm.hpp>
+#include <memory>
+#include "SceneObject.h"
+#include "SharedGeometry.h"
+
+class Instance : public SceneObject
+{
+private:
+    std::shared_ptr<SharedGeometry> geometry_;
+    glm::mat4 objectToWorld_ = glm::mat4(1);
+    glm::mat4 worldToObject_ = glm::mat4(1);
+    glm::mat3 normalMatrix_ = glm::mat3(1);   //inverse transpose of objectToWorld_'s linear part
+
+    void setTransform(glm::mat4 objectToWorld);
+
+public:
+    Instance(std::shared_ptr<SharedGeometry> geometry, glm::mat4 objectToWorld);
+
+    float intersect(glm::vec3 p0, glm::vec3 dir);
+    float intersect(glm::vec3 p0, glm::vec3 dir, int& part);
+
+    //Normal and (u, v) of the geometry's part 'part' at p; without a part, of part 0
+    glm::vec3 normal(glm::vec3 p);
+    glm::vec3 normal(glm::vec3 p, int part);
+    glm::vec2 textureCoords(glm::vec3 p);
+    glm::vec2 textureCoords(glm::vec3 p, int part);
+    BoundingBox bounds();
+    void translate(glm::vec3 d);
+    SceneObject* clone();
+    ShapeKind getShape(float* params);
+
+    SharedGeometry* getGeometry();
+};
+
+#endif //!H_INSTANCE
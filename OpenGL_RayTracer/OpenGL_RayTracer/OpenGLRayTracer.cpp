@@ -8,6 +8,9 @@
 
 #include <iostream>
 #include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <string>
 #include <vector>
 #include <glm/glm.hpp>
 #include "Sphere.h"
@@ -18,6 +21,38 @@
 #include "TextureBMP.h"
 #include "Cylinder.h"
 #include "Cone.h"
+#include "Box.h"
+#include "Instance.h"
+#include "PPMStripWriter.h"
+#include "StreamingRenderer.h"
+#include "AsyncRenderer.h"
+#include "DistributedRenderer.h"
+#include "Scene.h"
+#include "Animation.h"
+#include "SequenceRenderer.h"
+#include "GBuffer.h"
+#include "Denoiser.h"
+#include "ParallelFor.h"
+#include "FramePresenter.h"
+#include "QualityController.h"
+#include "TileBinner.h"
+#include "PrimaryRasterizer.h"
+#include "AllocationCounter.h"
+#include "ShadingBatch.h"
+#include "RegressionSuite.h"
+#include "FastMath.h"
+#include "AsyncLoader.h"
+#include "RenderServer.h"
+#include "SceneCache.h"
+#include "SceneFile.h"
+#include "ProgressiveRenderer.h"
+#include "RayQuery.h"
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <mutex>
+#include <random>
+#include <sys/stat.h>
 
 const int CELL_COUNT = 800;
 const float Z_NEAR = 40.0;
@@ -31,32 +66,58 @@ const float X_MAX =  VIEW_WIDTH * 0.5;
 const float Y_MIN = -VIEW_HEIGHT * 0.5;
 const float Y_MAX =  VIEW_HEIGHT * 0.5;
 
-vector<SceneObject*> sceneObjects;
+const glm::vec3 BACKGROUND_COLOR(0);
+
+Scene demoScene;
+bool decoupledShading = false;  // shade each surface once per pixel, weighted by the sub-samples that see it
+const float SAME_SURFACE_COS = 0.99;   // sub-samples whose normals differ by less than this angle share rays
+const float SAME_MIRROR_COS = 0.99999;  // the same for reflective and refractive objects, which magnify the difference
 TextureBMP wallTexture;
 TextureBMP cylinderTexture;
+bool compressTextures = false;  // keep textures as BC1 blocks rather than raw pixels
+bool virtualTextures = false;   // page texture tiles in from a cache file rather than loading whole images
+size_t textureBudget = 64 << 20;    // bytes of resident tiles per virtual texture
 
 const int PROCEDURAL_PATTEN_HEIGHT = 500;
 const int PROCEDURAL_PATTEN_WIDTH = 500;
 const int PROCEDURAL_PATTEN_COLOR_DEPTH = 3;
 float proceduralPatternTexture[PROCEDURAL_PATTEN_WIDTH * PROCEDURAL_PATTEN_HEIGHT * PROCEDURAL_PATTEN_COLOR_DEPTH] = {0};
 
-glm::vec3 trace(Ray ray, int step)
-{
-    glm::vec3 backgroundColor(0);
-    glm::vec3 lightPosRight(15, 30, 10);
-    glm::vec3 lightPosLeft(-15, 30, 10);
-    glm::vec3 color(0);
-    SceneObject* obj;
+const glm::vec3 LIGHT_POSITIONS[ShadingBatch::LIGHT_COUNT] = {glm::vec3(-15, 30, 10), glm::vec3(15, 30, 10)};
 
-    ray.closestPt(sceneObjects);
-    if(ray.index == -1)
+// Finds the ray's closest hit, unless it arrives with one (a primary hit from the visibility buffer)
+bool findHit(Ray& ray, Scene& scene, const TileObjects* candidates)
+{
+    if(ray.index >= 0)
+    {
+        return true;
+    }
+    if(candidates != NULL && !candidates->all)
+    {
+        ray.closestPt(scene.objects, candidates->indices, candidates->count);
+    }
+    else
     {
-        return backgroundColor;
+        scene.closestPt(ray);
     }
+    return ray.index != -1;
+}
 
-    obj = sceneObjects[ray.index];
+/**
+* Adds the ray's hit to 'batch' with its normal and surface colour, which is
+* the texel for textured objects. Textured objects are shaded with the texel
+* colour rather than calling setColor() on the shared object, so several
+* threads can trace at once. Returns the record's index.
+*/
+template<unsigned Features>
+int addHit(ShadingBatch& batch, Ray& ray, Scene& scene)
+{
+    const bool specular = (Features & FEATURE_SPECULAR) != 0;
+    glm::vec3 color(0);
+    SceneObject* obj = scene.objects[ray.index];
+    glm::vec3 surfaceColor = obj->getColorAt(ray.hit);
 
-    switch(ray.index)
+    switch((Features & FEATURE_TEXTURES) && obj->isTextured() ? ray.index : -1)
     {
         // Floor
         case 0:
@@ -117,7 +178,7 @@ glm::vec3 trace(Ray ray, int step)
                     }
                 }
             }
-            obj->setColor(color);
+            surfaceColor = color;
             break;
         }
         // Wall
@@ -127,14 +188,21 @@ glm::vec3 trace(Ray ray, int step)
             float texcoords = (ray.hit.x + 60) / repeatTimes - int((ray.hit.x + 60) / repeatTimes);
             float texcoordt = (ray.hit.y + 60) / repeatTimes - int((ray.hit.y + 60) / repeatTimes);
             color = wallTexture.getColorAt(texcoords, texcoordt);
-            obj->setColor(color);
+            surfaceColor = color;
             break;
         }
-        case 3:
+        // Box
+        case 2:
         {
-            // Procedural patten
-            int texcoordsIndex = (int)((10 + ray.hit.x) / 4.0 * PROCEDURAL_PATTEN_WIDTH);
-            int texcoordtIndex = (int)((10 + ray.hit.y) / 4.0 * PROCEDURAL_PATTEN_HEIGHT);
+            // Procedural patten on the textured faces
+            Box *box = (Box*)obj;
+            if(!box->isFaceTextured(box->faceAt(ray.hit)))
+            {
+                break;
+            }
+            glm::vec2 texCoord = box->textureCoords(ray.hit);
+            int texcoordsIndex = min((int)(texCoord.x * PROCEDURAL_PATTEN_WIDTH), PROCEDURAL_PATTEN_WIDTH - 1);
+            int texcoordtIndex = min((int)(texCoord.y * PROCEDURAL_PATTEN_HEIGHT), PROCEDURAL_PATTEN_HEIGHT - 1);
             int index = (texcoordtIndex * PROCEDURAL_PATTEN_WIDTH + texcoordsIndex) * PROCEDURAL_PATTEN_COLOR_DEPTH;
             color.r = proceduralPatternTexture[index];
             color.g = proceduralPatternTexture[index + 1];
@@ -144,11 +212,11 @@ glm::vec3 trace(Ray ray, int step)
             color.g = color.g * 0.6;
             color.b = color.b * 0.6;
             
-            obj->setColor(color);
+            surfaceColor = color;
             break;
         }
         // Cylinder
-        case 9:
+        case 5:
         {
             Cylinder *c = (Cylinder*)obj;
             glm::vec2 texCoord = c->textureCoords(ray.hit);
@@ -174,7 +242,7 @@ glm::vec3 trace(Ray ray, int step)
             color.g = color.g * 0.6;
             color.b = color.b * 0.6;
             
-            obj->setColor(color);
+            surfaceColor = color;
             break;
         }
         default:
@@ -183,196 +251,759 @@ glm::vec3 trace(Ray ray, int step)
         }
     }
 
-    
-    if(obj->type == 2)
+    return batch.add(ray.hit, obj->normal(ray.hit, ray.part), -ray.dir, surfaceColor, obj->getShininess(), specular && obj->isSpecular());
+}
+
+template<unsigned Features>
+glm::vec3 trace(Ray ray, int step, Scene& scene, PrimaryHit* primary = NULL, const TileObjects* candidates = NULL);
+
+// What the shadow and secondary rays of a hit found, shared by the hits of a pixel on the same surface
+struct SecondaryShading
+{
+    bool traced = false;
+    unsigned shadowed = 0;
+    unsigned seeThrough = 0;
+    glm::vec3 reflected;
+    glm::vec3 transmitted;
+    glm::vec3 refracted;
+};
+
+/**
+* Returns the colour of record k of a shaded batch, the hit of 'ray': casts
+* its shadow rays, picks its lit colour accordingly, and traces the
+* reflected, transmitted and refracted rays. If 'primary' is given, the
+* hit's normal, depth, object index and surface colour are stored in it.
+* If 'shared' is given and already traced, its results are used instead of
+* casting any rays; otherwise they are stored in it.
+*/
+template<unsigned Features>
+glm::vec3 finishHit(const ShadingBatch& batch, int k, Ray& ray, int step, Scene& scene, PrimaryHit* primary,
+                    SecondaryShading* shared = NULL)
+{
+    SecondaryShading own;
+    SecondaryShading& secondary = shared != NULL ? *shared : own;
+    bool traceRays = !secondary.traced;
+    secondary.traced = true;
+
+    SceneObject* obj = scene.objects[ray.index];
+    bool twoSided = obj->type == 2;     // cylinders are lit from inside too
+
+    if(primary != NULL)
+    {
+        primary->normal = batch.getNormal(k);
+        primary->depth = ray.dist;
+        primary->objectId = ray.index;
+        primary->albedo = batch.getSurfaceColor(k);
+    }
+
+    glm::vec3 color;
+    // Objects of type 1 are never shadowed
+    if((Features & FEATURE_SHADOWS) && obj->type != 1)
     {
-        Cylinder *c = (Cylinder *)obj;
-        color = c->doubleLighting(lightPosLeft, lightPosRight, -ray.dir, ray.hit);
+        unsigned& shadowed = secondary.shadowed;
+        unsigned& seeThrough = secondary.seeThrough;
+        for(int light = 0; light < ShadingBatch::LIGHT_COUNT && traceRays; light++)
+        {
+            glm::vec3 lightVec = LIGHT_POSITIONS[light] - ray.hit;
+            Ray shadowRay(ray.hit, lightVec);
+            scene.closestPt(shadowRay);
+            if(shadowRay.index > -1 && shadowRay.dist < glm::length(lightVec) && shadowRay.hitSceneObject != obj)
+            {
+                shadowed |= 1 << light;
+                SceneObject* shadowObj = scene.objects[shadowRay.index];
+                if(shadowObj->isRefractive() || shadowObj->isTransparent())
+                {
+                    seeThrough |= 1 << light;
+                }
+            }
+        }
+        color = batch.resolveShadows(k, shadowed, seeThrough, twoSided);
     }
     else
     {
-        color = obj->doubleLighting(lightPosLeft, lightPosRight, -ray.dir, ray.hit);
+        color = batch.litByAll(k, twoSided);
+    }
+
+    if ((Features & FEATURE_REFLECTION) && obj->isReflective() && step < scene.maxSteps)
+    {
+        float rho = obj->getReflectionCoeff();
+        if(traceRays)
+        {
+            glm::vec3 normalVec = batch.getNormal(k);
+            glm::vec3 reflectedDir = glm::reflect(ray.dir, normalVec);
+            Ray reflectedRay(ray.hit, reflectedDir);
+            secondary.reflected = trace<Features>(reflectedRay, step + 1, scene);
+        }
+        glm::vec3 reflectedColor = secondary.reflected;
+        color = color + (rho * reflectedColor);
+    }
+
+    if ((Features & FEATURE_TRANSPARENCY) && obj->isTransparent() && step < scene.maxSteps)
+    {
+        float factor = obj->getTransparencyCoeff();
+        if(traceRays)
+        {
+            Ray reflectedRay(ray.hit, ray.dir);
+            secondary.transmitted = trace<Features>(reflectedRay, step + 1, scene);
+        }
+        glm::vec3 backgroundColor = secondary.transmitted;
+        color = (1 - factor) * color + factor * backgroundColor;
+    }
+
+    if ((Features & FEATURE_REFRACTION) && obj->isRefractive() && step < scene.maxSteps && !traceRays)
+    {
+        color = secondary.refracted;
+    }
+    else if ((Features & FEATURE_REFRACTION) && obj->isRefractive() && step < scene.maxSteps)
+    {
+        float eta = 0.992;
+        glm::vec3 n = batch.getNormal(k);
+        glm::vec3 g = glm::refract(ray.dir, n, eta);
+        Ray refrRayInward(ray.hit, g);
+        float exit = obj->exitPoint(ray.hit, g);
+        if(exit > 0)
+        {
+            refrRayInward.hit = ray.hit + g * exit;
+        }
+        else
+        {
+            // Open geometry: the ray leaves through whatever surface it meets next
+            scene.closestPt(refrRayInward);
+        }
+        glm::vec3 m = obj->normal(refrRayInward.hit, refrRayInward.index == ray.index ? refrRayInward.part : -1);
+        glm::vec3 h = glm::refract(g, -m, 1.0f/eta);
+
+        Ray refrRayOurward(refrRayInward.hit, h);
+        glm::vec3 refractiveColor = trace<Features>(refrRayOurward, step + 1, scene);
+        secondary.refracted = refractiveColor;
+        color = refractiveColor;
     }
-    
-    glm::vec3 lightVecRight = lightPosRight - ray.hit;
-    Ray shadowRayRight(ray.hit, lightVecRight);
-    shadowRayRight.closestPt(sceneObjects);
 
-    glm::vec3 lightVecLeft = lightPosLeft - ray.hit;
-    Ray shadowRayLeft(ray.hit, lightVecLeft);
-    shadowRayLeft.closestPt(sceneObjects);
+    // What is seen in a mirror or through glass is not modulated by the surface
+    // colour, so use the result itself as the albedo to keep the denoiser off it.
+    const unsigned recursive = FEATURE_REFLECTION | FEATURE_TRANSPARENCY | FEATURE_REFRACTION;
+    if((Features & recursive) && primary != NULL && (obj->isReflective() || obj->isTransparent() || obj->isRefractive()))
+    {
+        primary->albedo = color;
+    }
 
-    bool hasLeftShadow = shadowRayLeft.index > -1 && shadowRayLeft.dist < glm::length(lightVecLeft);
-    bool hasRightShadow = shadowRayRight.index > -1 && shadowRayRight.dist < glm::length(lightVecRight);
+    return color;
+}
 
-    if(shadowRayLeft.hitSceneObject == obj)
+/**
+* Returns the colour seen along the ray. If 'primary' is given, the primary
+* hit's normal, depth, object index and surface colour are stored in it.
+* If 'candidates' lists objects (is not 'all'), the ray is only tested against those.
+* Only the SceneFeature values in 'Features' are shaded; the tests for the
+* others are compiled out.
+*/
+template<unsigned Features>
+glm::vec3 trace(Ray ray, int step, Scene& scene, PrimaryHit* primary, const TileObjects* candidates)
+{
+    if(!findHit(ray, scene, candidates))
     {
-        hasLeftShadow = false;
+        return BACKGROUND_COLOR;
     }
+    ShadingBatch batch;
+    int k = addHit<Features>(batch, ray, scene);
+    batch.shade(LIGHT_POSITIONS);
+    return finishHit<Features>(batch, k, ray, step, scene, primary);
+}
 
-    if(shadowRayRight.hitSceneObject == obj)
+/**
+* Returns the anti-aliased colour of cell (i, j) of a width x height grid
+* covering the scene camera's view plane; j is counted from the bottom of the view.
+* The cell is sampled on an antiAliasingFactor x antiAliasingFactor grid; if
+* 'primary' is given it receives the primary hit of the first sub-sample.
+* With a binner built for this grid, primary rays only test the objects of
+* the cell's tile, and cells of empty tiles are background without tracing.
+* Primary rays leave from 'camera' if given, otherwise from the scene's.
+* With a visibility buffer rendered for this grid and camera, the primary
+* hits are taken from it instead of being searched for.
+* With decoupledShading, sub-samples that hit the same object with nearly
+* the same normal share the shadow, reflected, transmitted and refracted
+* rays cast for the first of them; each keeps its own texel and lighting.
+* A non-zero 'Samples' fixes the grid size at compile time and overrides
+* antiAliasingFactor.
+*/
+template<unsigned Features, int Samples>
+glm::vec3 renderPixelKernel(int i, int j, int width, int height, Scene& scene, int antiAliasingFactor,
+                            PrimaryHit* primary, const TileBinner* binner, Camera* camera,
+                            const PrimaryRasterizer* visibility)
+{
+    if(Samples > 0)
     {
-        hasRightShadow = false;
+        antiAliasingFactor = Samples;
     }
-    
-    if(obj->type == 1)
+
+    TileObjects tile;
+    const TileObjects* candidates = NULL;
+    if(binner != NULL)
     {
-        hasLeftShadow = false;
-        hasRightShadow = false;
+        tile = binner->candidates(i, j);
+        if(!tile.all && tile.count == 0)
+        {
+            return BACKGROUND_COLOR;
+        }
+        candidates = &tile;
     }
 
-    float factor = 1.46;
-    if(hasLeftShadow && hasRightShadow)
+    Camera& view = camera != NULL ? *camera : scene.camera;
+    glm::vec3 eye = view.getEye();
+
+    int subCellCount = antiAliasingFactor;
+    int sampleCount = subCellCount * subCellCount;
+
+    // The sub-samples' primary hits are found first and shaded together, up to a batch at a time
+    ShadingBatch batch;
+    Ray rays[ShadingBatch::CAPACITY];
+    int records[ShadingBatch::CAPACITY];
+    SecondaryShading surfaces[ShadingBatch::CAPACITY];  // decoupled shading: rays cast per surface seen
+    int surface[ShadingBatch::CAPACITY];
+    glm::vec3 color = glm::vec3(0.0);
+    for(int first = 0; first < sampleCount; first += ShadingBatch::CAPACITY)
     {
-        color = obj->shadow();
-        SceneObject* shadowObj = sceneObjects[shadowRayRight.index];
-        if (shadowObj->isRefractive() || shadowObj->isTransparent())
+        int count = min(ShadingBatch::CAPACITY, sampleCount - first);
+        batch.clear();
+        for(int n = 0; n < count; n++)
         {
-            glm::vec3 color1 = obj->lighting(lightPosRight, -ray.dir, ray.hit);
-            glm::vec3 color2 = obj->lighting(lightPosLeft, -ray.dir, ray.hit);
-            
-            color.r = (color1.r + color2.r) * factor * 0.45;
-            color.g = (color1.g + color2.g) * factor * 0.45;
-            color.b = (color1.b + color2.b) * factor * 0.45;
+            int k = (first + n) / subCellCount;
+            int h = (first + n) % subCellCount;
+            glm::vec2 xy = PrimaryRasterizer::samplePoint(i, j, k, h, width, height, antiAliasingFactor,
+                                                          X_MIN, X_MAX, Y_MIN, Y_MAX);
+            Ray& ray = rays[n];
+            ray = Ray(eye, view.direction(xy.x, xy.y));
+            records[n] = -1;
+            if(visibility != NULL)
+            {
+                const VisibilitySample& sample = visibility->at(i, j, k, h);
+                if(sample.object < 0)
+                {
+                    continue;
+                }
+                ray.index = sample.object;
+                ray.dist = sample.depth;
+                ray.part = sample.part;
+                ray.hit = ray.p0 + ray.dir * sample.depth;
+                ray.hitSceneObject = scene.objects[sample.object];
+            }
+            if(findHit(ray, scene, candidates))
+            {
+                records[n] = addHit<Features>(batch, ray, scene);
+            }
+        }
+
+        batch.shade(LIGHT_POSITIONS);
+        if(decoupledShading)
+        {
+            // Each hit joins the surface of the first earlier hit on the same object facing the same way
+            for(int n = 0; n < count; n++)
+            {
+                surface[n] = n;
+                surfaces[n] = SecondaryShading();
+                if(records[n] < 0)
+                {
+                    continue;
+                }
+                SceneObject* obj = scene.objects[rays[n].index];
+                float sameCos = obj->isReflective() || obj->isTransparent() || obj->isRefractive() ? SAME_MIRROR_COS : SAME_SURFACE_COS;
+                for(int m = 0; m < n; m++)
+                {
+                    if(surface[m] == m && records[m] >= 0 && rays[m].index == rays[n].index
+                       && glm::dot(batch.getNormal(records[m]), batch.getNormal(records[n])) > sameCos)
+                    {
+                        surface[n] = m;
+                        break;
+                    }
+                }
+            }
+        }
+        for(int n = 0; n < count; n++)
+        {
+            if(records[n] < 0)
+            {
+                color += BACKGROUND_COLOR;
+            }
+            else
+            {
+                color += finishHit<Features>(batch, records[n], rays[n], 1, scene, first + n == 0 ? primary : NULL,
+                                             decoupledShading ? &surfaces[surface[n]] : NULL);
+            }
         }
     }
-    else if(!hasLeftShadow && hasRightShadow)
+
+    return color / float(sampleCount);
+}
+
+typedef glm::vec3 (*PixelKernel)(int i, int j, int width, int height, Scene& scene, int antiAliasingFactor,
+                                 PrimaryHit* primary, const TileBinner* binner, Camera* camera,
+                                 const PrimaryRasterizer* visibility);
+
+// Kernels for every feature mask, with 1, 2 or any number of sub-samples per axis
+template<unsigned Features>
+void fillKernelTable(PixelKernel table[][3])
+{
+    table[Features][0] = renderPixelKernel<Features, 0>;
+    table[Features][1] = renderPixelKernel<Features, 1>;
+    table[Features][2] = renderPixelKernel<Features, 2>;
+    fillKernelTable<Features - 1>(table);
+}
+
+template<>
+void fillKernelTable<0>(PixelKernel table[][3])
+{
+    table[0][0] = renderPixelKernel<0, 0>;
+    table[0][1] = renderPixelKernel<0, 1>;
+    table[0][2] = renderPixelKernel<0, 2>;
+}
+
+struct KernelTable
+{
+    PixelKernel kernels[FEATURE_ALL + 1][3];
+
+    KernelTable()
+    {
+        fillKernelTable<FEATURE_ALL>(kernels);
+    }
+};
+
+const KernelTable kernelTable;
+
+/**
+* Colour of the primary ray through view plane point (x, y) of the scene
+* camera, as one sample of a progressive render.
+*/
+template<unsigned Features>
+glm::vec3 renderSampleKernel(float x, float y, Scene& scene, const TileObjects* candidates)
+{
+    Ray ray(scene.camera.getEye(), scene.camera.direction(x, y));
+    return trace<Features>(ray, 1, scene, NULL, candidates);
+}
+
+typedef glm::vec3 (*SampleKernel)(float x, float y, Scene& scene, const TileObjects* candidates);
+
+template<unsigned Features>
+void fillSampleKernels(SampleKernel* table)
+{
+    table[Features] = renderSampleKernel<Features>;
+    fillSampleKernels<Features - 1>(table);
+}
+
+template<>
+void fillSampleKernels<0>(SampleKernel* table)
+{
+    table[0] = renderSampleKernel<0>;
+}
+
+struct SampleKernelTable
+{
+    SampleKernel kernels[FEATURE_ALL + 1];
+
+    SampleKernelTable()
+    {
+        fillSampleKernels<FEATURE_ALL>(kernels);
+    }
+};
+
+const SampleKernelTable sampleKernelTable;
+unsigned enabledFeatures = FEATURE_ALL; // features the user wants rendered
+unsigned renderFeatures = FEATURE_ALL;  // features of the loaded scene that are rendered
+
+/**
+* renderPixelKernel() specialised for 'renderFeatures', which is set when
+* the scene is loaded.
+*/
+glm::vec3 renderPixel(int i, int j, int width, int height, Scene& scene, int antiAliasingFactor = 2,
+                      PrimaryHit* primary = NULL, const TileBinner* binner = NULL, Camera* camera = NULL,
+                      const PrimaryRasterizer* visibility = NULL)
+{
+    int samples = antiAliasingFactor == 1 || antiAliasingFactor == 2 ? antiAliasingFactor : 0;
+    return kernelTable.kernels[renderFeatures][samples](i, j, width, height, scene, antiAliasingFactor, primary, binner,
+                                                       camera, visibility);
+}
+
+// renderSampleKernel() specialised for 'renderFeatures'
+glm::vec3 renderSample(float x, float y, Scene& scene, const TileObjects* candidates)
+{
+    return sampleKernelTable.kernels[renderFeatures](x, y, scene, candidates);
+}
+
+double secondsSince(chrono::steady_clock::time_point start)
+{
+    chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+    return elapsed.count();
+}
+
+FramePresenter presenter;
+QualityController qualityController(MAX_STEPS);
+bool frameOutdated = true;  // the camera has moved since the last frame was rendered
+bool tileBinning = true;    // bin objects into screen tiles before tracing primary rays
+TileBinner frameBinner;
+AsyncRenderer frameRenderer;    // traces the window frames in the background, keeping its threads and jobs
+std::shared_ptr<RenderJob> frameJob;    // the frame being shown; replaced (and cancelled) on input
+bool frameTimerRunning = false;
+const int FRAME_BAND_ROWS = 8;     // the window's tiles are bands of whole rows, uploaded as they finish
+const int FRAME_REFRESH_MS = 10;
+AsyncLoader sceneLoader;    // textures and scene, loaded while the window shows progress
+bool sceneLoaded = false;
+bool firstPixelsShown = false;
+const chrono::steady_clock::time_point programStart = chrono::steady_clock::now();
+const int LOADING_REFRESH_MS = 50;
+
+const glm::vec3 CAMERA_TARGET(0, 0, -60);
+float cameraAngle = 0;      // orbit around CAMERA_TARGET, radians
+float cameraDistance = 60;
+
+// Camera and quality of the next frame, set on input and read when a frame starts
+struct FrameView
+{
+    Camera camera;
+    QualityLevel quality;
+};
+std::mutex viewMutex;
+FrameView pendingView;
+
+// Size and sampling of the frame being traced, read by the pixel function
+struct FrameSettings
+{
+    int width;
+    int height;
+    int samples;
+    const TileBinner* binner;
+};
+FrameSettings frameSettings;
+
+/**
+* Queues a frame of demoScene at the given quality and view on frameRenderer
+* and returns at once; 'onTile' is called on a worker as each band of rows is
+* finished. The scene camera, ray depth and binner are only changed when the
+* frame starts, after the previous frame's last tiles, and then from the
+* latest view submitted: a frame overtaken by a newer one is cancelled anyway.
+* The pixel function, binner and finished jobs are kept between frames, so
+* once the first frame of a size has been traced, later ones do not allocate.
+*/
+std::shared_ptr<RenderJob> submitFrame(const QualityLevel& quality, const Camera& camera, const TileCallback& onTile)
+{
+    static const PixelFunction pixel = [](int i, int j)
+    {
+        const FrameSettings& frame = frameSettings;
+        return renderPixel(i, j, frame.width, frame.height, demoScene, frame.samples, NULL, frame.binner);
+    };
+    static const JobCallback prepare = [](const RenderJob& job)
     {
-        color = obj->lighting(lightPosRight, -ray.dir, ray.hit);
-        SceneObject* shadowObj = sceneObjects[shadowRayRight.index];
-        if (shadowObj->isRefractive() || shadowObj->isTransparent())
+        FrameSettings& frame = frameSettings;
         {
-            color.r = color.r * factor > 1 ? 1 : color.r * factor;
-            color.g = color.g * factor > 1 ? 1 : color.g * factor;
-            color.b = color.b * factor > 1 ? 1 : color.b * factor;
+            lock_guard<mutex> lock(viewMutex);
+            demoScene.camera = pendingView.camera;
+            frame.samples = pendingView.quality.samples;
+            demoScene.maxSteps = pendingView.quality.maxSteps;
         }
+        frame.width = job.getWidth();
+        frame.height = job.getHeight();
+        frame.binner = NULL;
+        if(tileBinning)
+        {
+            frameBinner.build(demoScene, frame.width, frame.height, X_MIN, X_MAX, Y_MIN, Y_MAX);
+            frame.binner = &frameBinner;
+        }
+    };
+
+    {
+        lock_guard<mutex> lock(viewMutex);
+        pendingView.camera = camera;
+        pendingView.quality = quality;
+    }
+
+    RenderRequest request;
+    request.width = max(1, (int)(CELL_COUNT * quality.resolutionScale + 0.5f));
+    request.height = request.width;
+    request.tileWidth = request.width;
+    request.tileHeight = FRAME_BAND_ROWS;
+    request.pixel = pixel;
+    request.prepare = prepare;
+    request.onTile = onTile;
+    return frameRenderer.submit(request);
+}
+
+// Bands finished by the workers and not yet uploaded, with the id of their frame
+struct FinishedBand
+{
+    unsigned frame;
+    int firstRow;
+    int rows;
+};
+std::mutex bandMutex;
+vector<FinishedBand> finishedBands;
+vector<FinishedBand> uploadBands;
+Camera viewCamera;  // the window's view; demoScene.camera belongs to the frame being traced
+QualityLevel frameQuality;
+
+/**
+* Uploads the bands of the current frame finished since the last call. Bands
+* of cancelled frames are dropped; their pixels stay until overwritten.
+*/
+void presentFinishedBands()
+{
+    {
+        lock_guard<mutex> lock(bandMutex);
+        uploadBands.swap(finishedBands);
     }
-    else if(hasLeftShadow && !hasRightShadow)
+    if(uploadBands.empty())
     {
-        color = obj->lighting(lightPosLeft, -ray.dir, ray.hit);
-        SceneObject* shadowObj = sceneObjects[shadowRayLeft.index];
-        if (shadowObj->isRefractive() || shadowObj->isTransparent())
+        return;
+    }
+
+    for(size_t b = 0; b < uploadBands.size(); b++)
+    {
+        const FinishedBand& band = uploadBands[b];
+        if(frameJob && band.frame == frameJob->getId())
         {
-            color.r = color.r * factor > 1 ? 1 : color.r * factor;
-            color.g = color.g * factor > 1 ? 1 : color.g * factor;
-            color.b = color.b * factor > 1 ? 1 : color.b * factor;
+            const unsigned char* rgba = frameJob->getImage() + (size_t)band.firstRow * frameJob->getWidth() * 4;
+            presenter.uploadRows(rgba, band.firstRow, band.rows);
+            if(!firstPixelsShown)
+            {
+                firstPixelsShown = true;
+                cout << "Time to first pixel: " << secondsSince(programStart) * 1000.0 << " ms" << endl;
+            }
         }
     }
+    uploadBands.clear();
+    glutPostRedisplay();
+}
 
-    if (obj->isReflective() && step < MAX_STEPS)
+// Shows the current frame's bands as they finish, and reports the frame once it is complete
+void frameTimer(int)
+{
+    bool finished = frameJob->isFinished();     // checked first, so no band finishes unseen
+    presentFinishedBands();
+    if(!finished)
     {
-        float rho = obj->getReflectionCoeff();
-        glm::vec3 normalVec = obj->normal(ray.hit);
-        glm::vec3 reflectedDir = glm::reflect(ray.dir, normalVec);
-        Ray reflectedRay(ray.hit, reflectedDir);
-        glm::vec3 reflectedColor = trace(reflectedRay, step + 1);
-        color = color + (rho * reflectedColor);
+        glutTimerFunc(FRAME_REFRESH_MS, frameTimer, 0);
+        return;
     }
 
-    if (obj->isTransparent() && step < MAX_STEPS)
+    frameTimerRunning = false;
+    if(frameJob->getStatus() == RENDER_FINISHED)
     {
-        float factor = obj->getTransparencyCoeff();
-        Ray reflectedRay(ray.hit, ray.dir);
-        glm::vec3 backgroundColor = trace(reflectedRay, step + 1);
-        color = (1 - factor) * color + factor * backgroundColor;
+        qualityController.frameFinished(frameJob->getSeconds());
+        if(qualityController.isEnabled())
+        {
+            cout << "Frame " << frameJob->getWidth() << "x" << frameJob->getHeight() << ", "
+                 << frameQuality.samples * frameQuality.samples << " spp, depth " << frameQuality.maxSteps << ": "
+                 << frameJob->getSeconds() * 1000.0 << " ms" << endl;
+        }
     }
+}
 
-    if (obj->isRefractive() && step < MAX_STEPS)
+/**
+* Cancels the frame being traced, if any, and starts one from viewCamera
+* at the quality chosen by the quality controller. Returns at once; the
+* bands are presented by frameTimer() as they finish.
+*/
+void startFrame()
+{
+    static const TileCallback onTile = [](const RenderJob& job, const RenderTile& tile)
     {
-        float eta = 0.992;
-        glm::vec3 n = obj->normal(ray.hit);
-        glm::vec3 g = glm::refract(ray.dir, n, eta);
-        Ray refrRayInward(ray.hit, g);
-        refrRayInward.closestPt(sceneObjects);
-        glm::vec3 m = obj->normal(refrRayInward.hit);
-        glm::vec3 h = glm::refract(g, -m, 1.0f/eta);
+        FinishedBand band = {job.getId(), tile.y, tile.height};
+        lock_guard<mutex> lock(bandMutex);
+        finishedBands.push_back(band);
+    };
 
-        Ray refrRayOurward(refrRayInward.hit, h);
-        glm::vec3 refractiveColor = trace(refrRayOurward, step + 1);
-        color = refractiveColor;
+    if(frameJob)
+    {
+        frameJob->cancel();
     }
 
-    return color;
+    frameQuality = qualityController.current();
+    int size = max(1, (int)(CELL_COUNT * frameQuality.resolutionScale + 0.5f));
+    {
+        lock_guard<mutex> lock(bandMutex);
+        finishedBands.reserve((size + FRAME_BAND_ROWS - 1) / FRAME_BAND_ROWS * 2);
+    }
+    uploadBands.reserve(finishedBands.capacity());
+    presenter.resize(size, size);
+
+    frameJob = submitFrame(frameQuality, viewCamera, onTile);
+    if(!frameTimerRunning)
+    {
+        frameTimerRunning = true;
+        glutTimerFunc(FRAME_REFRESH_MS, frameTimer, 0);
+    }
 }
 
-void display()
+// A progress bar across the middle of the view, 'progress' from 0 to 1
+void drawLoadingProgress(float progress)
 {
-    float xp, yp;
-    float cellX = (X_MAX - X_MIN) / CELL_COUNT;
-    float cellY = (Y_MAX - Y_MIN) / CELL_COUNT;
+    float x0 = X_MIN + 0.2f * VIEW_WIDTH;
+    float x1 = X_MAX - 0.2f * VIEW_WIDTH;
+    float y0 = -0.02f * VIEW_HEIGHT;
+    float y1 = 0.02f * VIEW_HEIGHT;
+
+    glColor3f(0.3, 0.3, 0.3);
+    glRectf(x0, y0, x1, y1);
+    glColor3f(1, 1, 1);
+    glRectf(x0, y0, x0 + (x1 - x0) * progress, y1);
+
+    glRasterPos2f(x0, y1 + 0.02f * VIEW_HEIGHT);
+    glutBitmapString(GLUT_BITMAP_HELVETICA_18, (const unsigned char*)"Loading scene...");
+}
 
-    glm::vec3 eye(0., 0., 0.);
+// Places 'camera' on its orbit around CAMERA_TARGET
+void orbitCamera(Camera& camera)
+{
+    glm::vec3 eye = CAMERA_TARGET + cameraDistance * glm::vec3(sinf(cameraAngle), 0, cosf(cameraAngle));
+    camera.lookAt(eye, CAMERA_TARGET);
+}
 
+void display()
+{
     glClear(GL_COLOR_BUFFER_BIT);
     glMatrixMode(GL_MODELVIEW);
     glLoadIdentity();
 
-    glBegin(GL_QUADS);
-    for(int i = 0; i < CELL_COUNT; i++)
+    if(!sceneLoaded)
     {
-        xp = X_MIN + i * cellX;
-        for(int j = 0; j < CELL_COUNT; j++)
+        if(!sceneLoader.isFinished())
         {
-            yp = Y_MIN + j * cellY;
+            drawLoadingProgress(sceneLoader.getProgress());
+            glFlush();
+            return;
+        }
+        sceneLoader.wait();
+        sceneLoader.printReport();
+        sceneLoaded = true;
+        viewCamera = demoScene.camera;
+        orbitCamera(viewCamera);
+    }
 
-            int antiAliasingFactor = 2;
-            int subCellCount = antiAliasingFactor;
-            float subCellX = cellX / float(antiAliasingFactor);
-            float subCellY = cellY / float(antiAliasingFactor);
+    if(frameOutdated)
+    {
+        frameOutdated = false;
+        startFrame();
+    }
+    presenter.draw(X_MIN, Y_MIN, X_MAX, Y_MAX);
+    glFlush();
+}
 
-            vector<glm::vec3> colors;
-            for(int k = 0; k < subCellCount; k++)
-            {
-                float subxp = xp + k * subCellX;
-                for(int h = 0; h < subCellCount; h++)
-                {
-                    float subyp = yp + h * subCellY;
+void reshape(int width, int height)
+{
+    glViewport(0, 0, width, height);
+}
 
-                    glm::vec3 dir(subxp + 0.5 * subCellX, subyp + 0.5 * subCellY, -Z_NEAR);
-                    Ray ray = Ray(eye, dir);
-                    glm::vec3 col = trace(ray, 1);
-                    colors.push_back(col);
-                }
-            }
+// Redraws the progress bar until the scene has loaded
+void loadingTimer(int)
+{
+    glutPostRedisplay();
+    if(!sceneLoaded)
+    {
+        glutTimerFunc(LOADING_REFRESH_MS, loadingTimer, 0);
+    }
+}
 
-            glm::vec3 color = glm::vec3(0.0);
-            for (uint m = 0; m < colors.size(); m++)
-            {
-                glm::vec3 col = colors[m];
-                color.r += col.r;
-                color.g += col.g;
-                color.b += col.b;
-            }
+/**
+* Left/right arrows orbit the camera around the scene, up/down move it closer
+* or further. The frame being traced is cancelled and the next one queued, so
+* keys never wait for rendering.
+*/
+void special(int key, int, int)
+{
+    switch(key)
+    {
+        case GLUT_KEY_LEFT: cameraAngle -= 0.1; break;
+        case GLUT_KEY_RIGHT: cameraAngle += 0.1; break;
+        case GLUT_KEY_UP: cameraDistance = max(10.0f, cameraDistance - 5); break;
+        case GLUT_KEY_DOWN: cameraDistance += 5; break;
+        default: return;
+    }
 
-            color.r /= colors.size();
-            color.g /= colors.size();
-            color.b /= colors.size();
+    orbitCamera(viewCamera);
+    frameOutdated = true;
+    glutPostRedisplay();
+}
 
-            glColor3f(color.r, color.g, color.b);
-            glVertex2f(xp, yp);
-            glVertex2f(xp + cellX, yp);
-            glVertex2f(xp + cellX, yp + cellY);
-            glVertex2f(xp, yp + cellY);
+/**
+* Loads a BMP texture, compressed to BC1 blocks if compressTextures is set.
+* Compressed textures are cached next to the image as <filename>.bc1 and
+* reused while the cache is newer than the image. Virtual textures are
+* converted to tiles in <filename>.vt the same way.
+*/
+TextureBMP loadTexture(const char* filename)
+{
+    struct stat image, cache;
+    TextureBMP texture;
+    if(virtualTextures)
+    {
+        string cacheName = string(filename) + ".vt";
+        if(stat(filename, &image) != 0 || stat(cacheName.c_str(), &cache) != 0 || cache.st_mtime < image.st_mtime)
+        {
+            chrono::steady_clock::time_point start = chrono::steady_clock::now();
+            if(!VirtualTexture::build(filename, cacheName.c_str()))
+            {
+                return TextureBMP(filename);
+            }
+            cout << "Converted " << filename << " to tiles in " << secondsSince(start) * 1000.0 << " ms" << endl;
+        }
+        if(texture.openVirtual(cacheName.c_str(), textureBudget))
+        {
+            VirtualTexture* pages = texture.getVirtual();
+            cout << "Virtual texture " << cacheName << ": " << pages->getWidth() << "x" << pages->getHeight() << ", "
+                 << pages->getLevelCount() << " levels, " << texture.getMemorySize() << " bytes resident at most" << endl;
+            return texture;
         }
+        return TextureBMP(filename);
     }
-    glEnd();
-    glFlush();
+    if(!compressTextures)
+    {
+        return TextureBMP(filename);
+    }
+
+    string cacheName = string(filename) + ".bc1";
+    if(stat(filename, &image) == 0 && stat(cacheName.c_str(), &cache) == 0 && cache.st_mtime >= image.st_mtime
+       && texture.loadCompressed(cacheName.c_str()))
+    {
+        cout << "Compressed texture " << cacheName << " loaded, " << texture.getMemorySize() << " bytes" << endl;
+        return texture;
+    }
+
+    texture = TextureBMP(filename);
+    size_t rawSize = texture.getMemorySize();
+    double quality = texture.compress();
+    cout << "Compressed " << filename << " from " << rawSize << " to " << texture.getMemorySize()
+         << " bytes, PSNR " << quality << " dB" << endl;
+    texture.saveCompressed(cacheName.c_str());
+    return texture;
 }
 
-void initialize()
+const char* sceneFileDir = NULL;   // directory of saved scene files; NULL: build every tree at start-up
+
+// Builds the acceleration structure once all objects are added, or maps it from the scene's saved file
+void finishScene(Scene& scene, const string& name)
 {
-    glMatrixMode(GL_PROJECTION);
-    gluOrtho2D(X_MIN, X_MAX, Y_MIN, Y_MAX);
+    scene.camera.setNear(Z_NEAR);
+    if(sceneFileDir == NULL)
+    {
+        scene.build();
+        return;
+    }
 
-    glClearColor(0, 0, 0, 1);
+    string path = string(sceneFileDir) + "/" + name + ".scene";
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    bool mapped = scene.build(path.c_str());
+    cout << "Scene " << name << ": " << scene.objects.size() << " objects, tree "
+         << (mapped ? "mapped from " : "built and saved to ") << path << " in " << secondsSince(start) * 1000 << " ms" << endl;
+}
 
+// Adds the objects of the demo scene; their indices are what trace() keys the textures on
+void addDemoObjects(Scene& scene)
+{
     // Floor
     Plane *floor = new Plane (glm::vec3(-60.0, -10, -Z_NEAR + 20),
                               glm::vec3(60.0, -10, -Z_NEAR + 20),
                               glm::vec3(60.0, -10, -Z_FAR),
                               glm::vec3(-60.0, -10, -Z_FAR));
     floor->setSpecularity(false);
-    sceneObjects.push_back(floor);
+    floor->setTextured(true);
+    scene.add(floor);
 
     // Wall
     Plane *wall = new Plane (glm::vec3(-60.0, -10, -Z_FAR),
@@ -380,98 +1011,113 @@ void initialize()
                              glm::vec3(60.0, 70, -Z_FAR),
                              glm::vec3(-60.0, 70, -Z_FAR));
     wall->setSpecularity(false);
-    sceneObjects.push_back(wall);
+    wall->setTextured(true);
+    scene.add(wall);
 
-    // Box
+    // Box: green, with a red top, a yellow back and the procedural pattern on the front
     float side = 4;
     float left = -10;
-    float right = left + side;
     float down = -10;
-    float up = down + side;
     float front = -60;
-    float back = front - side;
-
-    Plane *boxUp = new Plane (glm::vec3(left, up, front),
-                              glm::vec3(right, up, front),
-                              glm::vec3(right, up, back),
-                              glm::vec3(left, up, back));
-    boxUp->setSpecularity(false);
-    boxUp->setColor(glm::vec3(1, 0, 0));
-    boxUp->type = 1;
-    sceneObjects.push_back(boxUp);
-
-    Plane *boxFront = new Plane (glm::vec3(left, down, front),
-                                glm::vec3(right, down, front),
-                                glm::vec3(right, up, front),
-                                glm::vec3(left, up, front));
-    boxFront->setSpecularity(false);
-    boxFront->setColor(glm::vec3(0, 1, 0));
-    boxFront->type = 1;
-    sceneObjects.push_back(boxFront);
-
-    Plane *boxLeft = new Plane (glm::vec3(left, down, back),
-                                glm::vec3(left, down, front),
-                                glm::vec3(left, up, front),
-                                glm::vec3(left, up, back));
-    boxLeft->setSpecularity(false);
-    boxLeft->setColor(glm::vec3(0, 1, 0));
-    boxLeft->type = 1;
-    sceneObjects.push_back(boxLeft);
-
-    Plane *boxBack = new Plane (glm::vec3(right, down, back),
-                                glm::vec3(left, down, back),
-                                glm::vec3(left, up, back),
-                                glm::vec3(right, up, back));
-    boxBack->setSpecularity(false);
-    boxBack->setColor(glm::vec3(1, 1, 0));
-    boxBack->type = 1;
-    sceneObjects.push_back(boxBack);
-
-    Plane *boxRight = new Plane (glm::vec3(right, down, front),
-                                glm::vec3(right, down, back),
-                                glm::vec3(right, up, back),
-                                glm::vec3(right, up, front));
-    boxRight->setSpecularity(false);
-    boxRight->setColor(glm::vec3(0, 1, 0));
-    boxRight->type = 1;
-    sceneObjects.push_back(boxRight);
+
+    Box *box = new Box(glm::vec3(left, down, front - side), glm::vec3(left + side, down + side, front));
+    box->setSpecularity(false);
+    box->setColor(glm::vec3(0, 1, 0));
+    box->setFaceColor(BOX_UP, glm::vec3(1, 0, 0));
+    box->setFaceColor(BOX_BACK, glm::vec3(1, 1, 0));
+    box->setFaceTextured(BOX_FRONT, true);
+    box->type = 1;     // unshadowed, as the five planes it replaced were
+    scene.add(box);
 
     Sphere *transparentSphere = new Sphere(glm::vec3(0.5, 5.0, -80.0), 10.0);
     transparentSphere->setColor(glm::vec3(1, 1, 1));
     transparentSphere->setReflectivity(true, 0.8);
     transparentSphere->setTransparency(true, 0.8);
-    sceneObjects.push_back(transparentSphere);
+    scene.add(transparentSphere);
 
     Sphere *refractiveSphere = new Sphere(glm::vec3(7.0, -2.0, -60.0), 3.0);
     refractiveSphere->setColor(glm::vec3(0.0 / 255, 100.0 / 255, 100.0 / 255));
     refractiveSphere->setRefractivity(true);
-    sceneObjects.push_back(refractiveSphere);
+    scene.add(refractiveSphere);
 
     Cylinder *cylinder = new Cylinder(glm::vec3(10, -10.0, -60.0), 2.0, 3.0);
     cylinder->setColor(glm::vec3(1, 1, 1));
-    sceneObjects.push_back(cylinder);
+    cylinder->setTextured(true);
+    scene.add(cylinder);
 
     Cone *cone = new Cone(glm::vec3(0, -10.0, -60.0), 2.0, 4.0);
     cone->setColor(glm::vec3(100.0 / 255, 100.0 / 255, 0.0));
-    sceneObjects.push_back(cone);
-
-    wallTexture = TextureBMP("Wall.bmp");
-    cylinderTexture = TextureBMP("VaseTexture.bmp");
+    scene.add(cone);
 }
 
-void generetaProceduralPatternTexture()
+void buildNamedScene(Scene& scene, const string& name);
+const char* sceneName = NULL;   // named scene to load in place of the demo scene
+
+// Builds the demo scene (or the one sceneName names) into demoScene and picks the render kernel for it
+void buildSceneObjects()
 {
-    for(int i = 0; i < PROCEDURAL_PATTEN_WIDTH * PROCEDURAL_PATTEN_HEIGHT * PROCEDURAL_PATTEN_COLOR_DEPTH; i += 3)
+    if(sceneName != NULL)
     {
-        proceduralPatternTexture[i] = 0.5;
-        proceduralPatternTexture[i + 1] = 0.5;
-        proceduralPatternTexture[i + 2] = 0.5;
+        buildNamedScene(demoScene, sceneName);
+    }
+    else
+    {
+        addDemoObjects(demoScene);
+        finishScene(demoScene, "demo");
     }
+    renderFeatures = demoScene.features() & enabledFeatures;
+}
 
-    vector<glm::vec2> colors;
+void generetaProceduralPatternTexture();
 
-    for(int i = 0; i < PROCEDURAL_PATTEN_WIDTH; i++)
-    {
+/**
+* Starts building the demo scene on sceneLoader: the textures are decoded
+* and the procedural texture generated while the objects and their
+* acceleration structure are built.
+*/
+void startLoading()
+{
+    sceneLoader.add("scene and BVH", buildSceneObjects);
+    sceneLoader.add("Wall.bmp", []() { wallTexture = loadTexture("Wall.bmp"); });
+    sceneLoader.add("VaseTexture.bmp", []() { cylinderTexture = loadTexture("VaseTexture.bmp"); });
+    sceneLoader.add("procedural texture", generetaProceduralPatternTexture);
+    sceneLoader.start();
+}
+
+// Builds the demo scene as startLoading() does, but waits for it
+void loadScene()
+{
+    startLoading();
+    sceneLoader.wait();
+    sceneLoader.printReport();
+    sceneLoaded = true;
+}
+
+void initialize()
+{
+    glMatrixMode(GL_PROJECTION);
+    gluOrtho2D(X_MIN, X_MAX, Y_MIN, Y_MAX);
+
+    glClearColor(0, 0, 0, 1);
+
+    presenter.initialize();
+    startLoading();
+    glutTimerFunc(LOADING_REFRESH_MS, loadingTimer, 0);
+}
+
+void generetaProceduralPatternTexture()
+{
+    for(int i = 0; i < PROCEDURAL_PATTEN_WIDTH * PROCEDURAL_PATTEN_HEIGHT * PROCEDURAL_PATTEN_COLOR_DEPTH; i += 3)
+    {
+        proceduralPatternTexture[i] = 0.5;
+        proceduralPatternTexture[i + 1] = 0.5;
+        proceduralPatternTexture[i + 2] = 0.5;
+    }
+
+    vector<glm::vec2> colors;
+
+    for(int i = 0; i < PROCEDURAL_PATTEN_WIDTH; i++)
+    {
         float radian = 2 * M_PI * (float)i / PROCEDURAL_PATTEN_WIDTH;
         float sina = sinf(radian + M_PI);
 
@@ -509,16 +1155,1299 @@ void generetaProceduralPatternTexture()
     }
 }
 
+// Options for rendering straight to an image file instead of the window
+struct OutputOptions
+{
+    const char* filename = NULL;
+    int width = CELL_COUNT;
+    int height = CELL_COUNT;
+    int samples = 0;    // sub-samples per pixel along each axis; 0: 2, or 1 when denoising
+    int progressive = 0;    // >0: render this many jittered samples per pixel in checkpointed passes
+    const char* checkpoint = NULL;  // checkpoint of the progressive render; NULL: <output>.checkpoint
+    float checkpointInterval = 60;  // seconds between checkpoints
+    int bandRows = 16;
+    int memoryLimitMB = 64;
+    int threads = 0;    // 0: one per hardware thread
+    int workers = 0;    // >0: render in this many worker processes instead of threads
+    int failWorker = -1;
+    const char* animation = NULL;   // keyframe file: render a sequence, 'filename' is a printf pattern
+    int firstFrame = 0;
+    int lastFrame = -1;             // -1: last keyframe
+    int framesInFlight = 2;
+    bool denoise = false;
+    int denoiseIterations = 5;
+    int targetFrameMs = 0;  // window mode: adapt quality to this frame time; 0: always full quality
+    bool tileBinning = true;
+    bool rasterPrimary = false;     // find primary hits with the rasterizer instead of primary rays
+    bool rasterBenchmark = false;   // time ray cast against rasterized primary visibility instead
+    bool allocationCheck = false;   // trace window frames headlessly and fail if they allocate
+    bool scalingBenchmark = false;  // time the generated scenes over object and thread counts instead
+    bool rayQueryBenchmark = false; // time batched ray queries against one ray at a time instead
+    long long maxPrimitives = 100000;   // largest generated scene of the scaling benchmark
+    const char* scene = NULL;       // named scene to render in place of the demo scene
+    const char* meshFile = NULL;    // OFF mesh of the meshes-<n> scenes
+    bool decoupledShading = false;
+    bool preview = false;   // diffuse and textures only: no reflection, refraction, highlights or shadows
+    bool compressTextures = false;
+    bool virtualTextures = false;
+    float textureBudgetMB = 64;     // resident tiles per virtual texture
+    const char* regression = NULL;  // golden image directory: run the regression suite instead
+    bool updateGolden = false;
+    int regressionTolerance = 25;   // percent a case may be slower than its baseline
+    int regressionRuns = 3;
+    int mathMode = -1;      // MATH_PRECISE or MATH_FAST; -1: the build's default
+    bool mathAccuracy = false;
+    const char* sceneFileDir = NULL;    // save built scenes here and map them on later runs
+    bool server = false;    // take render jobs from stdin
+    const char* serverSocket = NULL;    // take render jobs from clients of this Unix domain socket
+    int sceneCache = 4;     // scenes the server keeps built
+};
+
+// True if argv[i] is the option 'name' followed by a value; moves i to the value
+bool isOption(int argc, char *argv[], int& i, const char* name)
+{
+    if(strcmp(argv[i], name) != 0 || i + 1 >= argc) return false;
+    i++;
+    return true;
+}
+
+/**
+* Parses the command line options of the file output modes:
+*   --output <file.ppm>  --size <width>x<height>  --samples <n>  --band-rows <n>
+*   --memory-limit <MB>  --threads <n>  --workers <n>  --fail-worker <index>
+*   --animation <keyframes.txt>  --frames <first>-<last>  --frames-in-flight <n>
+*   --denoise  --denoise-iterations <n>  --no-tile-binning  --preview  --compress-textures
+*   --virtual-textures  --texture-budget <MB>  --fast-math  --precise-math  --scene-file-dir <directory>
+*   --raster-primary  --decoupled-shading  --scene <name>  --mesh <file.off>
+*   --progressive <samples>  --checkpoint <file>  --checkpoint-interval <seconds>
+* of the regression suite:
+*   --regression <directory>  --update-golden  --regression-tolerance <percent>  --regression-runs <n>
+* of the fast math accuracy check:
+*   --math-accuracy
+* of the frame allocation check:
+*   --allocation-check  --threads <n>  --no-tile-binning
+* of the scaling benchmark:
+*   --scaling-benchmark  --max-primitives <n>  --threads <n>  --size <width>x<height>  --samples <n>  --mesh <file.off>
+* of the primary visibility benchmark:
+*   --raster-benchmark  --size <width>x<height>  --samples <n>  --threads <n>
+* of the batched ray query benchmark:
+*   --ray-query-benchmark  --scene <name>  --size <width>x<height>  --threads <n>
+* of the render server:
+*   --server  --server-socket <path>  --scene-cache <n>  --threads <n>  --band-rows <n>  --scene-file-dir <directory>
+* and of the window mode:
+*   --target-frame-ms <ms>  --no-tile-binning  --preview  --compress-textures  --fast-math  --precise-math
+*   --scene-file-dir <directory>  --decoupled-shading  --virtual-textures  --texture-budget <MB>
+*   --scene <name>  --mesh <file.off>
+* Unrecognised arguments are left for glutInit.
+*/
+void parseOutputOptions(int argc, char *argv[], OutputOptions& options)
+{
+    for(int i = 1; i < argc; i++)
+    {
+        if(isOption(argc, argv, i, "--output")) options.filename = argv[i];
+        else if(isOption(argc, argv, i, "--size")) sscanf(argv[i], "%dx%d", &options.width, &options.height);
+        else if(isOption(argc, argv, i, "--samples")) options.samples = atoi(argv[i]);
+        else if(isOption(argc, argv, i, "--progressive")) options.progressive = atoi(argv[i]);
+        else if(isOption(argc, argv, i, "--checkpoint")) options.checkpoint = argv[i];
+        else if(isOption(argc, argv, i, "--checkpoint-interval")) options.checkpointInterval = atof(argv[i]);
+        else if(isOption(argc, argv, i, "--band-rows")) options.bandRows = atoi(argv[i]);
+        else if(isOption(argc, argv, i, "--memory-limit")) options.memoryLimitMB = atoi(argv[i]);
+        else if(isOption(argc, argv, i, "--threads")) options.threads = atoi(argv[i]);
+        else if(isOption(argc, argv, i, "--workers")) options.workers = atoi(argv[i]);
+        else if(isOption(argc, argv, i, "--fail-worker")) options.failWorker = atoi(argv[i]);
+        else if(isOption(argc, argv, i, "--animation")) options.animation = argv[i];
+        else if(isOption(argc, argv, i, "--frames")) sscanf(argv[i], "%d-%d", &options.firstFrame, &options.lastFrame);
+        else if(isOption(argc, argv, i, "--frames-in-flight")) options.framesInFlight = atoi(argv[i]);
+        else if(isOption(argc, argv, i, "--denoise-iterations")) options.denoiseIterations = atoi(argv[i]);
+        else if(isOption(argc, argv, i, "--target-frame-ms")) options.targetFrameMs = atoi(argv[i]);
+        else if(isOption(argc, argv, i, "--texture-budget")) options.textureBudgetMB = atof(argv[i]);
+        else if(isOption(argc, argv, i, "--max-primitives")) options.maxPrimitives = atoll(argv[i]);
+        else if(isOption(argc, argv, i, "--scene")) options.scene = argv[i];
+        else if(isOption(argc, argv, i, "--mesh")) options.meshFile = argv[i];
+        else if(isOption(argc, argv, i, "--regression")) options.regression = argv[i];
+        else if(isOption(argc, argv, i, "--regression-tolerance")) options.regressionTolerance = atoi(argv[i]);
+        else if(isOption(argc, argv, i, "--regression-runs")) options.regressionRuns = atoi(argv[i]);
+        else if(isOption(argc, argv, i, "--server-socket")) options.serverSocket = argv[i];
+        else if(isOption(argc, argv, i, "--scene-cache")) options.sceneCache = atoi(argv[i]);
+        else if(isOption(argc, argv, i, "--scene-file-dir")) options.sceneFileDir = argv[i];
+        else if(strcmp(argv[i], "--denoise") == 0) options.denoise = true;
+        else if(strcmp(argv[i], "--no-tile-binning") == 0) options.tileBinning = false;
+        else if(strcmp(argv[i], "--raster-primary") == 0) options.rasterPrimary = true;
+        else if(strcmp(argv[i], "--raster-benchmark") == 0) options.rasterBenchmark = true;
+        else if(strcmp(argv[i], "--allocation-check") == 0) options.allocationCheck = true;
+        else if(strcmp(argv[i], "--scaling-benchmark") == 0) options.scalingBenchmark = true;
+        else if(strcmp(argv[i], "--ray-query-benchmark") == 0) options.rayQueryBenchmark = true;
+        else if(strcmp(argv[i], "--decoupled-shading") == 0) options.decoupledShading = true;
+        else if(strcmp(argv[i], "--preview") == 0) options.preview = true;
+        else if(strcmp(argv[i], "--compress-textures") == 0) options.compressTextures = true;
+        else if(strcmp(argv[i], "--virtual-textures") == 0) options.virtualTextures = true;
+        else if(strcmp(argv[i], "--fast-math") == 0) options.mathMode = MATH_FAST;
+        else if(strcmp(argv[i], "--precise-math") == 0) options.mathMode = MATH_PRECISE;
+        else if(strcmp(argv[i], "--math-accuracy") == 0) options.mathAccuracy = true;
+        else if(strcmp(argv[i], "--update-golden") == 0) options.updateGolden = true;
+        else if(strcmp(argv[i], "--server") == 0) options.server = true;
+    }
+    if(options.samples <= 0)
+    {
+        options.samples = options.denoise ? 1 : 2;
+    }
+}
+
+/**
+* Renders the scene into a G-buffer: colour plus the primary hit's normal,
+* depth, object index and albedo.
+*/
+void renderGBuffer(GBuffer& buffer, Scene& scene, int antiAliasingFactor, int threads)
+{
+    parallelFor(buffer.height, threads, [&](int j)
+    {
+        for(int i = 0; i < buffer.width; i++)
+        {
+            PrimaryHit hit;
+            glm::vec3 color = renderPixel(i, j, buffer.width, buffer.height, scene, antiAliasingFactor, &hit);
+            buffer.set(i, j, color, hit);
+        }
+    });
+}
+
+// Peak signal-to-noise ratio of two images in dB, on colours clamped to [0, 1]
+double psnr(const GBuffer& a, const GBuffer& b)
+{
+    double sum = 0;
+    size_t n = a.r.size();
+    for(size_t k = 0; k < n; k++)
+    {
+        double dr = glm::clamp(a.r[k], 0.0f, 1.0f) - glm::clamp(b.r[k], 0.0f, 1.0f);
+        double dg = glm::clamp(a.g[k], 0.0f, 1.0f) - glm::clamp(b.g[k], 0.0f, 1.0f);
+        double db = glm::clamp(a.b[k], 0.0f, 1.0f) - glm::clamp(b.b[k], 0.0f, 1.0f);
+        sum += dr * dr + dg * dg + db * db;
+    }
+    double mse = sum / (3.0 * n);
+    return mse > 0 ? 10.0 * log10(1.0 / mse) : INFINITY;
+}
+
+bool writeGBufferColor(const char* filename, const GBuffer& buffer)
+{
+    PPMStripWriter writer;
+    if(!writer.open(filename, buffer.width, buffer.height)) return false;
+
+    vector<unsigned char> row(buffer.width * 3);
+    for(int j = buffer.height - 1; j >= 0; j--)
+    {
+        for(int i = 0; i < buffer.width; i++)
+        {
+            glm::vec3 color = glm::clamp(buffer.getColor(i, j), 0.0f, 1.0f);
+            row[i * 3] = (unsigned char)(color.r * 255.0f + 0.5f);
+            row[i * 3 + 1] = (unsigned char)(color.g * 255.0f + 0.5f);
+            row[i * 3 + 2] = (unsigned char)(color.b * 255.0f + 0.5f);
+        }
+        if(!writer.writeRows(row.data(), 1)) return false;
+    }
+    return writer.close();
+}
+
+/**
+* Renders at a low sample count, denoises the result using the primary-hit
+* buffers, and reports time and quality against the 4-sample reference that
+* display() produces.
+*/
+int renderDenoised(const OutputOptions& options)
+{
+    loadScene();
+
+    GBuffer reference(options.width, options.height);
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    renderGBuffer(reference, demoScene, 2, options.threads);
+    double referenceSeconds = secondsSince(start);
+
+    GBuffer buffer(options.width, options.height);
+    start = chrono::steady_clock::now();
+    renderGBuffer(buffer, demoScene, options.samples, options.threads);
+    double renderSeconds = secondsSince(start);
+    double noisyPSNR = psnr(buffer, reference);
+
+    Denoiser denoiser;
+    denoiser.setIterations(options.denoiseIterations);
+    denoiser.setThreadCount(options.threads);
+    start = chrono::steady_clock::now();
+    denoiser.denoise(buffer);
+    double denoiseSeconds = secondsSince(start);
+    double denoisedPSNR = psnr(buffer, reference);
+
+    int samples = options.samples * options.samples;
+    printf("Reference, 4 spp:        %8.3f s\n", referenceSeconds);
+    printf("%d spp:                  %8.3f s              PSNR %6.2f dB\n", samples, renderSeconds, noisyPSNR);
+    printf("%d spp + denoise:        %8.3f s + %.3f s    PSNR %6.2f dB\n", samples, renderSeconds, denoiseSeconds, denoisedPSNR);
+
+    return writeGBufferColor(options.filename, buffer) ? 0 : 1;
+}
+
+/**
+* Renders frames of a keyframed animation in one process, reusing the
+* loaded textures and refitting the scene's acceleration structure per frame.
+*/
+int renderSequence(const OutputOptions& options)
+{
+    Animation animation;
+    if(!animation.load(options.animation))
+    {
+        return 1;
+    }
+    if(strchr(options.filename, '%') == NULL)
+    {
+        cerr << "*** The output of a sequence must be a file name pattern such as frame_%04d.ppm" << endl;
+        return 1;
+    }
+
+    loadScene();
+
+    int width = options.width;
+    int height = options.height;
+    int lastFrame = options.lastFrame >= 0 ? options.lastFrame : animation.getLastFrame();
+
+    SequenceRenderer renderer(demoScene, animation, width, height);
+    renderer.setFrameRange(options.firstFrame, lastFrame);
+    renderer.setBandRows(options.bandRows);
+    renderer.setFramesInFlight(options.framesInFlight);
+    if(options.threads > 0)
+    {
+        renderer.setThreadCount(options.threads);
+    }
+
+    cout << "Rendering frames " << options.firstFrame << "-" << lastFrame << " at " << width << "x" << height
+         << " to " << options.filename << endl;
+
+    int samples = options.samples;
+    bool rendered = renderer.render(
+        [width, height, samples](Scene& scene, int i, int j) { return renderPixel(i, j, width, height, scene, samples); },
+        options.filename);
+    renderer.printReport();
+    return rendered ? 0 : 1;
+}
+
+// Paging counts of the virtual textures, if textures are virtual
+void printVirtualTextureReport()
+{
+    const char* names[2] = {"Wall.bmp", "VaseTexture.bmp"};
+    TextureBMP* textures[2] = {&wallTexture, &cylinderTexture};
+    for(int k = 0; k < 2; k++)
+    {
+        VirtualTexture* pages = textures[k]->getVirtual();
+        if(pages != NULL)
+        {
+            cout << names[k] << ": " << pages->getPageIns() << " tiles paged in, " << pages->getEvictions()
+                 << " evicted, " << pages->getFallbacks() << " samples from a coarser level" << endl;
+        }
+    }
+}
+
+// Names of the features in a SceneFeature mask
+string featureNames(unsigned features)
+{
+    const char* names[] = {"reflection", "transparency", "refraction", "specular", "textures", "shadows"};
+    string list;
+    for(int bit = 0; bit < 6; bit++)
+    {
+        if(features & (1 << bit))
+        {
+            list += list.empty() ? names[bit] : string(" ") + names[bit];
+        }
+    }
+    return list.empty() ? "diffuse only" : list;
+}
+
+const uint64_t PROGRESSIVE_SEED = 363;
+std::atomic<bool> stopRequested(false);    // set by SIGINT and SIGTERM during a progressive render
+
+void requestStop(int)
+{
+    stopRequested = true;
+}
+
+/**
+* 64-bit FNV-1a hash of everything that decides the image besides its size:
+* the objects' shapes and materials, the camera, the render settings and
+* the textures, both how they are stored and the images they come from.
+* A checkpoint is only resumed by a render with the same hash.
+*/
+uint64_t hashScene(Scene& scene)
+{
+    uint64_t h = 14695981039346656037ULL;
+    auto add = [&h](const void* data, size_t size)
+    {
+        for(size_t k = 0; k < size; k++)
+        {
+            h ^= ((const unsigned char*)data)[k];
+            h *= 1099511628211ULL;
+        }
+    };
+
+    float params[SHAPE_PARAMS];
+    for(size_t k = 0; k < scene.objects.size(); k++)
+    {
+        int32_t kind = scene.objects[k]->getShape(params);
+        MaterialRecord material = SceneFile::material(scene.objects[k]);
+        add(&kind, sizeof(kind));
+        add(params, sizeof(params));
+        add(&material, sizeof(material));
+    }
+    glm::vec3 eye = scene.camera.getEye();
+    glm::vec3 target = scene.camera.getTarget();
+    int32_t settings[5] = {(int32_t)renderFeatures, scene.maxSteps, (int32_t)mathMode, compressTextures, virtualTextures};
+    add(&eye, sizeof(eye));
+    add(&target, sizeof(target));
+    add(settings, sizeof(settings));
+
+    const char* textureNames[2] = {"Wall.bmp", "VaseTexture.bmp"};
+    for(int k = 0; k < 2; k++)
+    {
+        ifstream image(textureNames[k], ios::binary);
+        char buffer[65536];
+        while(image.read(buffer, sizeof(buffer)) || image.gcount() > 0)
+        {
+            add(buffer, image.gcount());
+        }
+    }
+    return h;
+}
+
+/**
+* Renders options.progressive jittered samples per pixel, one per pixel per
+* pass, resuming from the checkpoint file if it was saved for this scene
+* and size. The checkpoint is written every options.checkpointInterval
+* seconds, when the render is stopped with SIGINT or SIGTERM, and at the
+* end, so a later run with more samples carries on from this one.
+*/
+int renderProgressive(const OutputOptions& options)
+{
+    loadScene();
+    cout << "Shading features: " << featureNames(renderFeatures) << endl;
+
+    int width = options.width;
+    int height = options.height;
+    TileBinner tiles;
+    const TileBinner* binner = NULL;
+    if(options.tileBinning)
+    {
+        tiles.build(demoScene, width, height, X_MIN, X_MAX, Y_MIN, Y_MAX, TileBinner::DEFAULT_TILE_SIZE, options.threads);
+        binner = &tiles;
+    }
+    float cellX = (X_MAX - X_MIN) / width;
+    float cellY = (Y_MAX - Y_MIN) / height;
+    SampleFunction sample = [binner, cellX, cellY](int i, int j, float dx, float dy)
+    {
+        TileObjects tile;
+        if(binner != NULL) tile = binner->candidates(i, j);
+        return renderSample(X_MIN + (i + dx) * cellX, Y_MIN + (j + dy) * cellY, demoScene, binner != NULL ? &tile : NULL);
+    };
+
+    string checkpoint = options.checkpoint != NULL ? options.checkpoint : string(options.filename) + ".checkpoint";
+    ProgressiveRenderer renderer(width, height, hashScene(demoScene), PROGRESSIVE_SEED);
+    renderer.setThreadCount(options.threads);
+    renderer.setCheckpoint(checkpoint.c_str(), options.checkpointInterval);
+    struct stat info;
+    if(renderer.resume())
+    {
+        cout << "Resuming from " << checkpoint << " at " << renderer.getMinSamples() << " of "
+             << options.progressive << " samples per pixel" << endl;
+    }
+    else if(stat(checkpoint.c_str(), &info) == 0)
+    {
+        cerr << "*** Checkpoint " << checkpoint << " was saved for another scene or size; starting over" << endl;
+    }
+
+    cout << "Rendering " << width << "x" << height << " at " << options.progressive << " samples per pixel to "
+         << options.filename << ", checkpointing to " << checkpoint << " every " << options.checkpointInterval << " s" << endl;
+    stopRequested = false;
+    signal(SIGINT, requestStop);
+    signal(SIGTERM, requestStop);
+    bool finished = renderer.render(sample, options.progressive, &stopRequested);
+    signal(SIGINT, SIG_DFL);
+    signal(SIGTERM, SIG_DFL);
+
+    double seconds = renderer.getRenderSeconds();
+    uint64_t traced = renderer.getSamples() - renderer.getResumedSamples();
+    cout << traced << " samples in " << seconds << " s (" << traced / seconds * 1.e-6 << " Mrays/s), "
+         << renderer.getCheckpointCount() << " checkpoints in " << renderer.getCheckpointSeconds() * 1000.0 << " ms ("
+         << renderer.getCheckpointSeconds() / seconds * 100.0 << "% of the time)" << endl;
+    if(!finished)
+    {
+        if(stopRequested)
+        {
+            cout << "Stopped at " << renderer.getMinSamples() << " samples per pixel; run again to resume" << endl;
+        }
+        return 1;
+    }
+
+    PPMStripWriter writer;
+    if(!writer.open(options.filename, width, height))
+    {
+        return 1;
+    }
+    int bandRows = max(1, options.bandRows);
+    vector<unsigned char> band((size_t)width * bandRows * 3);
+    for(int row = 0; row < height; row += bandRows)
+    {
+        int rows = min(bandRows, height - row);
+        renderer.resolve(row, rows, band.data());
+        if(!writer.writeRows(band.data(), rows))
+        {
+            return 1;
+        }
+    }
+    return writer.close() ? 0 : 1;
+}
+
+/**
+* Renders the scene without a window, streaming finished bands of rows
+* into a PPM file so that memory use does not grow with the image size.
+*/
+int renderToFile(const OutputOptions& options)
+{
+    if(options.width <= 0 || options.height <= 0)
+    {
+        cerr << "*** Invalid output size" << endl;
+        return 1;
+    }
+    if(options.animation != NULL)
+    {
+        return renderSequence(options);
+    }
+    if(options.denoise)
+    {
+        return renderDenoised(options);
+    }
+    if(options.progressive > 0)
+    {
+        return renderProgressive(options);
+    }
+
+    loadScene();
+    cout << "Shading features: " << featureNames(renderFeatures) << endl;
+
+    PPMStripWriter writer;
+    if(!writer.open(options.filename, options.width, options.height))
+    {
+        return 1;
+    }
+
+    int width = options.width;
+    int height = options.height;
+    int samples = options.samples;
+    PrimaryRasterizer rasterizer;
+    const PrimaryRasterizer* visibility = NULL;
+    if(options.rasterPrimary)
+    {
+        size_t bytes = PrimaryRasterizer::memorySize(width, height, samples);
+        if(bytes > ((size_t)options.memoryLimitMB << 20))
+        {
+            cout << "Visibility buffer needs " << (bytes >> 20) << " MB, over the memory limit: casting primary rays" << endl;
+        }
+        else
+        {
+            rasterizer.render(demoScene, demoScene.camera, width, height, samples, X_MIN, X_MAX, Y_MIN, Y_MAX,
+                              TileBinner::DEFAULT_TILE_SIZE, options.threads);
+            visibility = &rasterizer;
+            cout << "Primary visibility rasterized in " << rasterizer.getSeconds() * 1000.0 << " ms, "
+                 << rasterizer.getMeanTests() << " intersection tests per sample" << endl;
+        }
+    }
+    TileBinner tiles;
+    const TileBinner* binner = NULL;
+    if(options.tileBinning && visibility == NULL)
+    {
+        tiles.build(demoScene, width, height, X_MIN, X_MAX, Y_MIN, Y_MAX, TileBinner::DEFAULT_TILE_SIZE, options.threads);
+        binner = &tiles;
+        cout << "Tile binning: " << tiles.getEmptyTileCount() << " of " << tiles.getTileCount()
+             << " tiles empty, " << tiles.getUnlistedTileCount() << " searched through the BVH, "
+             << tiles.getMeanCandidates() << " of " << demoScene.objects.size()
+             << " objects per listed tile on average" << endl;
+    }
+    PixelFunction pixel = [width, height, samples, binner, visibility](int i, int j)
+    {
+        return renderPixel(i, j, width, height, demoScene, samples, NULL, binner, NULL, visibility);
+    };
+    BandSink sink = [&writer](const unsigned char* rgb, int firstRow, int rows)
+    {
+        if(firstRow == 0)
+        {
+            cout << "Time to first pixel: " << secondsSince(programStart) * 1000.0 << " ms" << endl;
+        }
+        return writer.writeRows(rgb, rows);
+    };
+
+    if(options.workers > 0)
+    {
+        DistributedRenderer renderer(width, height);
+        renderer.setWorkerCount(options.workers);
+        renderer.setBandRows(options.bandRows);
+        renderer.setMemoryLimit((size_t)options.memoryLimitMB << 20);
+        renderer.setFailingWorker(options.failWorker);
+
+        cout << "Rendering " << width << "x" << height << " to " << options.filename
+             << " with " << options.workers << " worker processes" << endl;
+
+        bool rendered = renderer.render(pixel, sink);
+        renderer.printReport();
+        return rendered && writer.close() ? 0 : 1;
+    }
+
+    StreamingRenderer renderer(width, height);
+    renderer.setBandRows(options.bandRows);
+    renderer.setMemoryLimit((size_t)options.memoryLimitMB << 20);
+    if(options.threads > 0)
+    {
+        renderer.setThreadCount(options.threads);
+    }
+
+    cout << "Rendering " << width << "x" << height << " to " << options.filename
+         << " in " << renderer.getBandCount() << " bands of " << renderer.getBandRows() << " rows, at most "
+         << renderer.getMaxBandsInFlight() << " in flight" << endl;
+
+    bool rendered = renderer.render(pixel, sink);
+    printVirtualTextureReport();
+
+    return rendered && writer.close() ? 0 : 1;
+}
+
+// A crate with no bottom: four sides and a lid, as five planes around a unit cube standing on the origin
+std::shared_ptr<SharedGeometry> makeCrate()
+{
+    std::shared_ptr<SharedGeometry> crate = std::make_shared<SharedGeometry>();
+    glm::vec3 corners[8];
+    for(int k = 0; k < 8; k++)
+    {
+        corners[k] = glm::vec3((k & 1) ? 0.5 : -0.5, (k & 2) ? 1 : 0, (k & 4) ? -0.5 : 0.5);
+    }
+    // Corner k: bit 0 right, bit 1 up, bit 2 back; faces wound so that their normals point out
+    int faces[5][4] = {{2, 3, 7, 6}, {0, 1, 3, 2}, {4, 0, 2, 6}, {5, 4, 6, 7}, {1, 5, 7, 3}};
+    for(int f = 0; f < 5; f++)
+    {
+        crate->add(new Plane(corners[faces[f][0]], corners[faces[f][1]], corners[faces[f][2]], corners[faces[f][3]]));
+    }
+    crate->build();
+    return crate;
+}
+
+const char* meshFile = NULL;    // OFF mesh the meshes-<n> scenes place; NULL: the crate
+const unsigned GENERATED_SCENE_SEED = 363;
+
+// Random numbers for the generated scenes; mt19937's sequence is fixed by the standard, so a seed gives the same scene everywhere
+struct SceneRandom
+{
+    std::mt19937 engine;
+
+    explicit SceneRandom(unsigned seed) : engine(seed) {}
+
+    float uniform(float lo, float hi)
+    {
+        return lo + (hi - lo) * (engine() >> 8) * (1.0f / 16777216.0f);
+    }
+
+    glm::vec3 color()
+    {
+        return glm::vec3(uniform(0.1, 1), uniform(0.1, 1), uniform(0.1, 1));
+    }
+};
+
+// Splits a generated scene name, <kind>-<count>, into its parts; false if it names no generator
+bool parseGeneratedScene(const string& name, string& kind, long long& count)
+{
+    size_t dash = name.rfind('-');
+    if(dash == string::npos || dash + 1 >= name.size()) return false;
+    kind = name.substr(0, dash);
+    count = atoll(name.c_str() + dash + 1);
+    return count > 0 && (kind == "spheres" || kind == "boxes" || kind == "mirror-grid" || kind == "meshes");
+}
+
+// Corners of the volume behind the demo objects that the generated objects fill
+const glm::vec3 GENERATED_MIN(-40, -10, -190);
+const glm::vec3 GENERATED_MAX(40, 25, -85);
+
+/**
+* Adds 'count' generated objects to 'scene'. Their size shrinks with the
+* cube root of the count, so they fill the same fraction of the volume at
+* any count. Returns the recursion depth to trace them with.
+*/
+int addGeneratedObjects(Scene& scene, const string& kind, long long count)
+{
+    SceneRandom random(GENERATED_SCENE_SEED);
+    glm::vec3 extent = GENERATED_MAX - GENERATED_MIN;
+    float size = cbrtf(extent.x * extent.y * extent.z / count) * 0.3f;
+
+    if(kind == "spheres")
+    {
+        // Random spheres, a quarter of them reflective
+        for(long long n = 0; n < count; n++)
+        {
+            glm::vec3 center(random.uniform(GENERATED_MIN.x, GENERATED_MAX.x), random.uniform(GENERATED_MIN.y, GENERATED_MAX.y),
+                             random.uniform(GENERATED_MIN.z, GENERATED_MAX.z));
+            Sphere *sphere = new Sphere(center, size * random.uniform(0.5, 1));
+            sphere->setColor(random.color());
+            sphere->setReflectivity(n % 4 == 0, 0.5);
+            scene.add(sphere);
+        }
+    }
+    else if(kind == "boxes")
+    {
+        // Random boxes, each turned about the vertical axis
+        for(long long n = 0; n < count; n++)
+        {
+            glm::vec3 center(random.uniform(GENERATED_MIN.x, GENERATED_MAX.x), random.uniform(GENERATED_MIN.y, GENERATED_MAX.y),
+                             random.uniform(GENERATED_MIN.z, GENERATED_MAX.z));
+            glm::vec3 half(size * random.uniform(0.3, 0.8), size * random.uniform(0.3, 0.8), size * random.uniform(0.3, 0.8));
+            float angle = random.uniform(0, 2 * M_PI);
+            glm::mat3 rotation(1);
+            rotation[0] = glm::vec3(cosf(angle), 0, -sinf(angle));
+            rotation[2] = glm::vec3(sinf(angle), 0, cosf(angle));
+            Box *box = new Box(center - half, center + half);
+            box->setOrientation(rotation);
+            box->setColor(random.color());
+            box->setSpecularity(false);
+            scene.add(box);
+        }
+    }
+    else if(kind == "mirror-grid")
+    {
+        // Layers of square grids of spheres, mirrors and glass in turn, so most rays bounce to the depth limit
+        int side = max(1, (int)ceil(sqrt((double)count / 4)));
+        int layers = (int)((count + (long long)side * side - 1) / ((long long)side * side));
+        float spacing = min(extent.x, extent.z) / side;
+        for(long long n = 0; n < count; n++)
+        {
+            int column = n % side;
+            int row = n / side % side;
+            int layer = n / ((long long)side * side);
+            glm::vec3 center(GENERATED_MIN.x + (column + 0.5f) * spacing, GENERATED_MIN.y + (layer + 0.5f) * extent.y / layers,
+                             GENERATED_MIN.z + (row + 0.5f) * spacing);
+            Sphere *sphere = new Sphere(center, 0.4f * min(spacing, extent.y / layers));
+            sphere->setColor(glm::vec3(0.1));
+            if((column + row + layer) % 2 == 0)
+            {
+                sphere->setReflectivity(true, 0.9);
+            }
+            else
+            {
+                sphere->setRefractivity(true, 1.0, 1.5);
+            }
+            scene.add(sphere);
+        }
+        return 12;
+    }
+    else if(kind == "meshes")
+    {
+        // Instances of one mesh, turned and coloured at random and scaled to 'size'
+        std::shared_ptr<SharedGeometry> mesh;
+        if(meshFile != NULL)
+        {
+            mesh = std::make_shared<SharedGeometry>();
+            if(!mesh->loadOFF(meshFile) || mesh->getPartCount() == 0)
+            {
+                mesh.reset();
+            }
+            else
+            {
+                mesh->build();
+            }
+        }
+        if(!mesh)
+        {
+            mesh = makeCrate();
+        }
+        BoundingBox bounds = mesh->bounds();
+        glm::vec3 meshExtent = bounds.max - bounds.min;
+        float scale = 2 * size / max(meshExtent.x, max(meshExtent.y, meshExtent.z));
+        glm::vec3 meshCenter = (bounds.min + bounds.max) * 0.5f;
+
+        for(long long n = 0; n < count; n++)
+        {
+            glm::vec3 center(random.uniform(GENERATED_MIN.x, GENERATED_MAX.x), random.uniform(GENERATED_MIN.y, GENERATED_MAX.y),
+                             random.uniform(GENERATED_MIN.z, GENERATED_MAX.z));
+            float angle = random.uniform(0, 2 * M_PI);
+            glm::mat4 transform(1);
+            transform[0] = glm::vec4(cosf(angle) * scale, 0, -sinf(angle) * scale, 0);
+            transform[1] = glm::vec4(0, scale, 0, 0);
+            transform[2] = glm::vec4(sinf(angle) * scale, 0, cosf(angle) * scale, 0);
+            glm::vec3 offset = glm::vec3(transform * glm::vec4(meshCenter, 0));
+            transform[3] = glm::vec4(center - offset, 1);
+            Instance *instance = new Instance(mesh, transform);
+            instance->setColor(random.color());
+            instance->setSpecularity(false);
+            scene.add(instance);
+        }
+    }
+    return MAX_STEPS;
+}
+
+/**
+* Builds one of the named scenes into 'scene': the demo scene itself, or
+* the demo scene with extra objects or another view. Object indices 0-6
+* stay those of the demo scene, so its textures still apply. The scene's
+* maxSteps is set to the recursion depth it is meant to be traced with.
+*/
+void buildNamedScene(Scene& scene, const string& name)
+{
+    scene.clear();
+    scene.camera = Camera();
+    scene.maxSteps = MAX_STEPS;
+    addDemoObjects(scene);
+
+    string kind;
+    long long count;
+    if(parseGeneratedScene(name, kind, count))
+    {
+        scene.maxSteps = addGeneratedObjects(scene, kind, count);
+    }
+    else if(name == "many-spheres")
+    {
+        // A 10 x 10 grid of small spheres on the floor, behind the demo objects
+        for(int n = 0; n < 100; n++)
+        {
+            Sphere *sphere = new Sphere(glm::vec3(-27.0 + 6.0 * (n % 10), -8.5, -90.0 - 8.0 * (n / 10)), 1.5);
+            sphere->setColor(glm::vec3((n % 3) * 0.5, (n % 5) * 0.25, (n % 7) / 6.0));
+            sphere->setReflectivity(n % 4 == 0, 0.5);
+            scene.add(sphere);
+        }
+    }
+    else if(name == "textured")
+    {
+        // Close-up of the textured box and vase in front of the brick wall
+        scene.camera.lookAt(glm::vec3(0, 4, -22), glm::vec3(0, -7, -60));
+    }
+    else if(name == "deep-recursion")
+    {
+        // Two mirrors facing each other across the demo objects
+        Sphere *leftMirror = new Sphere(glm::vec3(-15, 8, -65), 5);
+        leftMirror->setColor(glm::vec3(0.1));
+        leftMirror->setReflectivity(true, 0.9);
+        scene.add(leftMirror);
+
+        Sphere *rightMirror = new Sphere(glm::vec3(15, 8, -65), 5);
+        rightMirror->setColor(glm::vec3(0.1));
+        rightMirror->setReflectivity(true, 0.9);
+        scene.add(rightMirror);
+        scene.maxSteps = 12;
+    }
+    else if(name == "instanced")
+    {
+        // 100,000 crates on the floor behind the demo objects, all sharing one geometry
+        std::shared_ptr<SharedGeometry> crate = makeCrate();
+        const int columns = 400;
+        const int rows = 250;
+        const glm::vec3 palette[5] = {glm::vec3(0.8, 0.2, 0.2), glm::vec3(0.2, 0.6, 0.2), glm::vec3(0.2, 0.3, 0.8),
+                                      glm::vec3(0.8, 0.7, 0.2), glm::vec3(0.6, 0.4, 0.3)};
+        for(int n = 0; n < columns * rows; n++)
+        {
+            float angle = (n * 7919 % 628) / 100.0;
+            float size = 0.15 + (n * 37 % 10) * 0.01;
+            glm::mat4 transform(1);
+            transform[0] = glm::vec4(cosf(angle) * size, 0, -sinf(angle) * size, 0);
+            transform[1] = glm::vec4(0, size * (1 + n % 3 * 0.5), 0, 0);
+            transform[2] = glm::vec4(sinf(angle) * size, 0, cosf(angle) * size, 0);
+            transform[3] = glm::vec4(-59.8 + 0.3 * (n % columns), -10, -70.0 - 0.5 * (n / columns), 1);
+            Instance *instance = new Instance(crate, transform);
+            instance->setColor(palette[(n * 7 + n / columns) % 5]);
+            instance->setSpecularity(false);
+            scene.add(instance);
+        }
+    }
+    finishScene(scene, name);
+}
+
+bool isNamedScene(const string& name)
+{
+    string kind;
+    long long count;
+    return name == "demo" || name == "many-spheres" || name == "textured" || name == "deep-recursion" || name == "instanced"
+           || parseGeneratedScene(name, kind, count);
+}
+
+// Loads a named scene into demoScene, with its recursion depth and render kernel
+void loadNamedScene(const string& name)
+{
+    buildNamedScene(demoScene, name);
+    renderFeatures = demoScene.features() & enabledFeatures;
+}
+
+/**
+* Renders the regression scenes headlessly and compares them with the golden
+* images and baseline times in options.regression, or stores new ones.
+*/
+int runRegression(const OutputOptions& options)
+{
+    generetaProceduralPatternTexture();
+    wallTexture = loadTexture("Wall.bmp");
+    cylinderTexture = loadTexture("VaseTexture.bmp");
+
+    RegressionSuite suite(options.regression);
+    suite.setTimeTolerance(options.regressionTolerance / 100.0);
+    suite.setRuns(options.regressionRuns);
+    suite.setThreadCount(options.threads);
+
+    const char* names[] = {"demo", "many-spheres", "textured", "deep-recursion"};
+    const int size = 160;
+    const int samples = 2;
+    for(int n = 0; n < 4; n++)
+    {
+        string name = names[n];
+        RegressionCase test;
+        test.name = name;
+        test.width = size;
+        test.height = size;
+        test.samples = samples;
+        test.setup = [name]() { loadNamedScene(name); };
+        test.pixel = [](int i, int j) { return renderPixel(i, j, size, size, demoScene, samples); };
+        suite.add(test);
+    }
+
+    bool passed = options.updateGolden ? suite.update() : suite.run();
+    return passed ? 0 : 1;
+}
+
+/**
+* Traces window frames headlessly while orbiting the camera, as the arrow
+* keys do, and counts the heap allocations they make. Every other frame is
+* cancelled half way, as when a key is pressed during a frame, and the time
+* until its workers stop is measured. The orbit is flown once to warm up
+* (threads started, buffers, jobs and tile lists grown) and then again
+* counted; any allocation in the second pass fails the check.
+*/
+int checkFrameAllocations(const OutputOptions& options)
+{
+    loadScene();
+    tileBinning = options.tileBinning;
+    if(options.threads > 0)
+    {
+        frameRenderer.setThreadCount(options.threads);
+    }
+
+    static std::atomic<int> bands(0);
+    static const TileCallback countBand = [](const RenderJob&, const RenderTile&)
+    {
+        bands++;
+    };
+    QualityLevel quality = {1, 2, MAX_STEPS};
+    Camera camera = demoScene.camera;
+    const int FRAMES = 4;
+
+    size_t allocations = 0;
+    double frameSeconds = 0;
+    double cancelSeconds = 0;
+    for(int pass = 0; pass < 2; pass++)
+    {
+        if(pass == 1)
+        {
+            AllocationCounter::start();
+        }
+        frameSeconds = 0;
+        cancelSeconds = 0;
+        for(int frame = 0; frame < FRAMES; frame++)
+        {
+            cameraAngle = 0.1 * frame;
+            orbitCamera(camera);
+            std::shared_ptr<RenderJob> job = submitFrame(quality, camera, countBand);
+            if(frame % 2 == 1)
+            {
+                while(job->getProgress() < 0.5f && !job->isFinished())
+                {
+                    this_thread::yield();
+                }
+                chrono::steady_clock::time_point cancelled = chrono::steady_clock::now();
+                job->cancel();
+                job->wait();
+                cancelSeconds += secondsSince(cancelled);
+            }
+            else
+            {
+                job->wait();
+                frameSeconds += job->getSeconds();
+            }
+        }
+        if(pass == 1)
+        {
+            allocations = AllocationCounter::stop();
+        }
+    }
+
+    int cancelledFrames = FRAMES / 2;
+    cout << FRAMES - cancelledFrames << " frames of " << CELL_COUNT << "x" << CELL_COUNT << " in "
+         << frameSeconds * 1000.0 / (FRAMES - cancelledFrames) << " ms each, " << cancelledFrames
+         << " cancelled half way in " << cancelSeconds * 1000.0 / cancelledFrames << " ms each, "
+         << allocations << " heap allocations" << endl;
+    if(allocations > 0)
+    {
+        cerr << "*** Tracing a frame allocated memory" << endl;
+        return 1;
+    }
+    return 0;
+}
+
+/**
+* Builds each generated scene with 10, 100, ... objects up to
+* --max-primitives and renders it on 1, 2, 4, ... threads up to --threads,
+* printing one CSV line per render for plotting. A scene whose single
+* thread render time grows faster than its object count, or whose build
+* time grows faster than n log n, fails the run; times under 20 ms are
+* too noisy to compare.
+*/
+int runScalingBenchmark(const OutputOptions& options)
+{
+    loadScene();
+    int maxThreads = options.threads > 0 ? options.threads : max(1, (int)thread::hardware_concurrency());
+    int width = options.width;
+    int height = options.height;
+    int samples = options.samples;
+    vector<unsigned char> image((size_t)width * height * 3);
+    const double MIN_SECONDS = 0.02;
+    const double SLACK = 1.25;
+
+    bool passed = true;
+    cout << "scene,objects,threads,build_s,render_s,mrays_per_s" << endl;
+    const char* kinds[] = {"spheres", "boxes", "mirror-grid", "meshes"};
+    for(int k = 0; k < 4; k++)
+    {
+        double lastBuild = 0;
+        double lastRender = 0;
+        for(long long count = 10; count <= options.maxPrimitives; count *= 10)
+        {
+            chrono::steady_clock::time_point start = chrono::steady_clock::now();
+            loadNamedScene(string(kinds[k]) + "-" + to_string(count));
+            double build = secondsSince(start);
+
+            PixelFunction pixel = [width, height, samples](int i, int j) { return renderPixel(i, j, width, height, demoScene, samples); };
+            double render = 0;
+            for(int threads = 1; threads <= maxThreads; threads = threads < maxThreads ? min(threads * 2, maxThreads) : threads + 1)
+            {
+                start = chrono::steady_clock::now();
+                parallelFor(height, threads, [&](int row)
+                {
+                    StreamingRenderer::renderRows(pixel, width, height, row, 1, &image[(size_t)row * width * 3]);
+                });
+                double seconds = secondsSince(start);
+                if(threads == 1) render = seconds;
+                cout << kinds[k] << "," << count << "," << threads << "," << build << "," << seconds << ","
+                     << (double)width * height * samples * samples / seconds * 1.e-6 << endl;
+            }
+
+            double nLogN = 10.0 * log(10.0 * count) / log((double)count);
+            if(lastRender >= MIN_SECONDS && render > SLACK * 10.0 * lastRender)
+            {
+                cerr << "*** " << kinds[k] << ": render time grew " << render / lastRender << "x from "
+                     << count / 10 << " to " << count << " objects" << endl;
+                passed = false;
+            }
+            if(lastBuild >= MIN_SECONDS && build > SLACK * nLogN * lastBuild)
+            {
+                cerr << "*** " << kinds[k] << ": build time grew " << build / lastBuild << "x from "
+                     << count / 10 << " to " << count << " objects" << endl;
+                passed = false;
+            }
+            lastBuild = build;
+            lastRender = render;
+        }
+    }
+    return passed ? 0 : 1;
+}
+
+/**
+* Renders the demo, many-spheres and instanced scenes twice, once casting
+* primary rays through the BVH and once from a rasterized visibility buffer,
+* and reports both times. The two images must match byte for byte.
+*/
+int runRasterBenchmark(const OutputOptions& options)
+{
+    generetaProceduralPatternTexture();
+    wallTexture = loadTexture("Wall.bmp");
+    cylinderTexture = loadTexture("VaseTexture.bmp");
+
+    int width = options.width;
+    int height = options.height;
+    int samples = options.samples;
+    vector<unsigned char> rayImage((size_t)width * height * 3);
+    vector<unsigned char> rasterImage(rayImage.size());
+
+    bool identical = true;
+    const char* names[] = {"demo", "many-spheres", "instanced"};
+    for(int n = 0; n < 3; n++)
+    {
+        loadNamedScene(names[n]);
+
+        PixelFunction rayPixel = [width, height, samples](int i, int j) { return renderPixel(i, j, width, height, demoScene, samples); };
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        parallelFor(height, options.threads, [&](int row)
+        {
+            StreamingRenderer::renderRows(rayPixel, width, height, row, 1, &rayImage[(size_t)row * width * 3]);
+        });
+        double raySeconds = secondsSince(start);
+
+        PrimaryRasterizer rasterizer;
+        start = chrono::steady_clock::now();
+        rasterizer.render(demoScene, demoScene.camera, width, height, samples, X_MIN, X_MAX, Y_MIN, Y_MAX,
+                          TileBinner::DEFAULT_TILE_SIZE, options.threads);
+        const PrimaryRasterizer* visibility = &rasterizer;
+        PixelFunction rasterPixel = [width, height, samples, visibility](int i, int j)
+        {
+            return renderPixel(i, j, width, height, demoScene, samples, NULL, NULL, NULL, visibility);
+        };
+        parallelFor(height, options.threads, [&](int row)
+        {
+            StreamingRenderer::renderRows(rasterPixel, width, height, row, 1, &rasterImage[(size_t)row * width * 3]);
+        });
+        double rasterSeconds = secondsSince(start);
+
+        bool match = rayImage == rasterImage;
+        identical = identical && match;
+        cout << names[n] << " (" << demoScene.objects.size() << " objects), " << width << "x" << height << ", "
+             << samples * samples << " spp: ray cast " << raySeconds * 1000.0 << " ms, rasterized "
+             << rasterSeconds * 1000.0 << " ms (visibility " << rasterizer.getSeconds() * 1000.0 << " ms, "
+             << rasterizer.getMeanTests() << " tests per sample), " << raySeconds / rasterSeconds << "x, "
+             << (match ? "identical" : "*** images differ") << endl;
+    }
+    return identical ? 0 : 1;
+}
+
+/**
+* Casts a ray through every pixel of the named scenes (the demo, many-spheres
+* and instanced scenes by default) and a shadow ray from each hit towards
+* the first light, once with a Scene::closestPt() call per ray and once
+* through RayQuery in batches, and reports both rates. The batched hits and
+* occlusion must equal the ray-at-a-time ones.
+*/
+int runRayQueryBenchmark(const OutputOptions& options)
+{
+    int width = options.width;
+    int height = options.height;
+    int count = width * height;
+    vector<float> originX(count), originY(count), originZ(count);
+    vector<float> dirX(count), dirY(count), dirZ(count);
+    vector<float> shadowX(count), shadowY(count), shadowZ(count), lightDistance(count);
+    vector<float> distance(count), referenceDistance(count);
+    vector<int> object(count), referenceObject(count);
+    vector<float> normalX(count), normalY(count), normalZ(count), u(count), v(count);
+    vector<unsigned char> occluded(count), referenceOccluded(count);
+
+    vector<string> names;
+    if(options.scene != NULL)
+    {
+        names.push_back(options.scene);
+    }
+    else
+    {
+        names.push_back("demo");
+        names.push_back("many-spheres");
+        names.push_back("instanced");
+    }
+
+    bool identical = true;
+    for(size_t n = 0; n < names.size(); n++)
+    {
+        loadNamedScene(names[n]);
+        glm::vec3 eye = demoScene.camera.getEye();
+        for(int k = 0; k < count; k++)
+        {
+            glm::vec2 xy = PrimaryRasterizer::samplePoint(k % width, k / width, 0, 0, width, height, 1, X_MIN, X_MAX, Y_MIN, Y_MAX);
+            glm::vec3 dir = demoScene.camera.direction(xy.x, xy.y);
+            originX[k] = eye.x;
+            originY[k] = eye.y;
+            originZ[k] = eye.z;
+            dirX[k] = dir.x;
+            dirY[k] = dir.y;
+            dirZ[k] = dir.z;
+        }
+
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        for(int k = 0; k < count; k++)
+        {
+            Ray ray(glm::vec3(originX[k], originY[k], originZ[k]), glm::vec3(dirX[k], dirY[k], dirZ[k]));
+            demoScene.closestPt(ray);
+            referenceDistance[k] = ray.index >= 0 ? ray.dist : -1;
+            referenceObject[k] = ray.index;
+        }
+        double singleSeconds = secondsSince(start);
+
+        RayQuery query(demoScene);
+        query.setThreadCount(options.threads);
+        RayBatch rays;
+        rays.count = count;
+        rays.originX = originX.data();
+        rays.originY = originY.data();
+        rays.originZ = originZ.data();
+        rays.dirX = dirX.data();
+        rays.dirY = dirY.data();
+        rays.dirZ = dirZ.data();
+        HitBatch hits;
+        hits.distance = distance.data();
+        hits.object = object.data();
+        hits.normalX = normalX.data();
+        hits.normalY = normalY.data();
+        hits.normalZ = normalZ.data();
+        hits.u = u.data();
+        hits.v = v.data();
+        start = chrono::steady_clock::now();
+        query.intersect(rays, hits);
+        double batchSeconds = secondsSince(start);
+        bool match = distance == referenceDistance && object == referenceObject;
+
+        // Shadow rays from each hit (or from the eye for misses) towards the first light
+        for(int k = 0; k < count; k++)
+        {
+            glm::vec3 from = eye;
+            if(object[k] >= 0)
+            {
+                from += glm::normalize(glm::vec3(dirX[k], dirY[k], dirZ[k])) * distance[k];
+            }
+            glm::vec3 toLight = LIGHT_POSITIONS[0] - from;
+            shadowX[k] = from.x;
+            shadowY[k] = from.y;
+            shadowZ[k] = from.z;
+            dirX[k] = toLight.x;
+            dirY[k] = toLight.y;
+            dirZ[k] = toLight.z;
+            lightDistance[k] = glm::length(toLight);
+        }
+        start = chrono::steady_clock::now();
+        for(int k = 0; k < count; k++)
+        {
+            Ray ray(glm::vec3(shadowX[k], shadowY[k], shadowZ[k]), glm::vec3(dirX[k], dirY[k], dirZ[k]));
+            demoScene.closestPt(ray);
+            referenceOccluded[k] = ray.index >= 0 && ray.dist < lightDistance[k] ? 1 : 0;
+        }
+        double singleShadowSeconds = secondsSince(start);
+
+        rays.originX = shadowX.data();
+        rays.originY = shadowY.data();
+        rays.originZ = shadowZ.data();
+        rays.maxDistance = lightDistance.data();
+        start = chrono::steady_clock::now();
+        query.occluded(rays, occluded.data());
+        double batchShadowSeconds = secondsSince(start);
+        match = match && occluded == referenceOccluded;
+        identical = identical && match;
+
+        cout << names[n] << " (" << demoScene.objects.size() << " objects), " << count << " rays: closest hit "
+             << count / singleSeconds * 1.e-6 << " Mrays/s one at a time, " << count / batchSeconds * 1.e-6
+             << " Mrays/s batched with normals and UVs; shadow rays " << count / singleShadowSeconds * 1.e-6 << " Mrays/s one at a time, "
+             << count / batchShadowSeconds * 1.e-6 << " Mrays/s batched any-hit, "
+             << (match ? "identical" : "*** results differ") << endl;
+    }
+    return identical ? 0 : 1;
+}
+
+/**
+* Serves render jobs for the named scenes until a client sends 'quit'. The
+* textures are loaded once, and built scenes are kept in a cache between
+* jobs. Every job is traced with the full-featured kernel, since jobs for
+* different scenes run at the same time, and its own scene's recursion depth.
+*/
+int runServer(const OutputOptions& options)
+{
+    generetaProceduralPatternTexture();
+    wallTexture = loadTexture("Wall.bmp");
+    cylinderTexture = loadTexture("VaseTexture.bmp");
+    renderFeatures = FEATURE_ALL & enabledFeatures;
+
+    SceneCache cache([](Scene& scene, const string& name)
+    {
+        if(!isNamedScene(name)) return false;
+        buildNamedScene(scene, name);
+        return true;
+    }, options.sceneCache);
+
+    RenderServer server(cache, [](Scene& scene, Camera& camera, int i, int j, int width, int height, int samples)
+    {
+        return renderPixel(i, j, width, height, scene, samples, NULL, NULL, &camera);
+    });
+    if(options.threads > 0)
+    {
+        server.setThreadCount(options.threads);
+    }
+    server.setBandRows(options.bandRows);
+    server.start();
+
+    bool served = true;
+    if(options.serverSocket != NULL)
+    {
+        served = server.serveSocket(options.serverSocket);
+    }
+    else
+    {
+        server.serveStream();
+    }
+    cerr << "Scene cache: " << cache.getHits() << " hits, " << cache.getMisses() << " misses" << endl;
+    return served ? 0 : 1;
+}
+
 int main(int argc, char *argv[])
 {
+    OutputOptions outputOptions;
+    parseOutputOptions(argc, argv, outputOptions);
+    if(outputOptions.preview)
+    {
+        enabledFeatures = FEATURE_TEXTURES;
+    }
+    compressTextures = outputOptions.compressTextures;
+    virtualTextures = outputOptions.virtualTextures;
+    textureBudget = (size_t)(max(0.0f, outputOptions.textureBudgetMB) * (1 << 20));
+    decoupledShading = outputOptions.decoupledShading;
+    sceneFileDir = outputOptions.sceneFileDir;
+    meshFile = outputOptions.meshFile;
+    if(outputOptions.scene != NULL)
+    {
+        if(!isNamedScene(outputOptions.scene))
+        {
+            cerr << "*** Unknown scene: " << outputOptions.scene << endl;
+            return 1;
+        }
+        sceneName = outputOptions.scene;
+    }
+    if(outputOptions.mathMode >= 0)
+    {
+        mathMode = (MathMode)outputOptions.mathMode;
+    }
+    if(outputOptions.mathAccuracy)
+    {
+        return checkFastMathAccuracy() ? 0 : 1;
+    }
+    if(outputOptions.regression != NULL)
+    {
+        return runRegression(outputOptions);
+    }
+    if(outputOptions.allocationCheck)
+    {
+        return checkFrameAllocations(outputOptions);
+    }
+    if(outputOptions.rasterBenchmark)
+    {
+        return runRasterBenchmark(outputOptions);
+    }
+    if(outputOptions.scalingBenchmark)
+    {
+        return runScalingBenchmark(outputOptions);
+    }
+    if(outputOptions.rayQueryBenchmark)
+    {
+        return runRayQueryBenchmark(outputOptions);
+    }
+    if(outputOptions.server || outputOptions.serverSocket != NULL)
+    {
+        return runServer(outputOptions);
+    }
+    if(outputOptions.filename != NULL)
+    {
+        return renderToFile(outputOptions);
+    }
+
     glutInit(&argc, argv);
     glutInitDisplayMode(GLUT_SINGLE | GLUT_RGB );
     glutInitWindowSize(1000, 1000);
     glutInitWindowPosition(20, 20);
     glutCreateWindow("OpenGL Ray Tracer");
-    generetaProceduralPatternTexture();
     glutDisplayFunc(display);
+    glutReshapeFunc(reshape);
+    glutSpecialFunc(special);
     initialize();
+    qualityController.setTargetFrameTime(outputOptions.targetFrameMs / 1000.0);
+    tileBinning = outputOptions.tileBinning;
 
     glutMainLoop();
     return 0;
@@ -0,0 +1,58 @@
+/*----------------------------------------------------------
+* COSC363  Ray Tracer
+*
+*  The PPM strip writer class
+-------------------------------------------------------------*/
+
+#include "PPMStripWriter.h"
+#include <iostream>
+
+PPMStripWriter::~PPMStripWriter()
+{
+    close();
+}
+
+bool PPMStripWriter::open(const char* filename, int width, int height)
+{
+    close();
+    file_ = fopen(filename, "wb");
+    if(file_ == NULL)
+    {
+        std::cerr << "*** Error opening output file: " << filename << std::endl;
+        return false;
+    }
+    width_ = width;
+    height_ = height;
+    rowsWritten_ = 0;
+    fprintf(file_, "P6\n%d %d\n255\n", width_, height_);
+    return true;
+}
+
+bool PPMStripWriter::writeRows(const unsigned char* rgb, int rows)
+{
+    if(file_ == NULL || rowsWritten_ + rows > height_) return false;
+
+    size_t size = (size_t)width_ * rows * 3;
+    if(fwrite(rgb, 1, size, file_) != size) return false;
+    rowsWritten_ += rows;
+    return true;
+}
+
+bool PPMStripWriter::close()
+{
+    if(file_ == NULL) return true;
+
+    bool complete = rowsWritten_ == height_;
+    bool flushed = fclose(file_) == 0;
+    file_ = NULL;
+    if(!complete)
+    {
+        std::cerr << "*** Output image is incomplete: " << rowsWritten_ << " of " << height_ << " rows written" << std::endl;
+    }
+    return complete && flushed;
+}
+
+int PPMStripWriter::getRowsWritten()
+{
+    return rowsWritten_;
+}
@@ -0,0 +1,37 @@
+/*----------------------------------------------------------
+* COSC363  Ray Tracer
+*
+*  The PPM strip writer class
+*  Writes a binary PPM (P6) image one horizontal strip at a
+*  time, so that an image never has to be held in memory as
+*  a whole. Strips must be supplied from top to bottom.
+-------------------------------------------------------------*/
+
+#ifndef H_PPM_STRIP_WRITER
+#define H_PPM_STRIP_WRITER
+
+#include <cstdio>
+
+class PPMStripWriter
+{
+private:
+    FILE* file_ = NULL;
+    int width_ = 0;
+    int height_ = 0;
+    int rowsWritten_ = 0;
+
+public:
+    PPMStripWriter() {}
+    ~PPMStripWriter();
+
+    bool open(const char* filename, int width, int height);
+
+    //Appends 'rows' rows of packed 8-bit RGB pixels (width * rows * 3 bytes)
+    bool writeRows(const unsigned char* rgb, int rows);
+
+    bool close();
+
+    int getRowsWritten();
+};
+
+#endif //!H_PPM_STRIP_WRITER
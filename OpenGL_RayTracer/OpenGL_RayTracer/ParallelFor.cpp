@@ -0,0 +1,95 @@
+/*----------------------------------------------------------
+* COSC363  Ray Tracer
+*
+*  parallelFor()
+-------------------------------------------------------------*/
+
+#include "ParallelFor.h"
+#include <condition_variable>
+#include <mutex>
+
+namespace
+{
+    /**
+    * Threads waiting for jobs that still want helpers. The pool grows to the
+    * largest number of helpers ever asked for and is never destroyed, so that
+    * no thread is left joinable when the program exits.
+    */
+    class HelperPool
+    {
+    private:
+        std::mutex mutex_;
+        std::condition_variable jobAdded_;
+        std::condition_variable helperDone_;
+        ParallelJob* jobs_ = nullptr;
+        int threadCount_ = 0;
+
+        void takeItems(ParallelJob& job)
+        {
+            for(int i = job.next++; i < job.count; i = job.next++) job.run(job.body, i);
+        }
+
+        ParallelJob* openJob()
+        {
+            for(ParallelJob* job = jobs_; job != nullptr; job = job->nextJob)
+            {
+                if(job->helpers < job->helpersWanted && job->next < job->count) return job;
+            }
+            return nullptr;
+        }
+
+        void help()
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            while(true)
+            {
+                ParallelJob* job;
+                jobAdded_.wait(lock, [&]() { return (job = openJob()) != nullptr; });
+                job->helpers++;
+                job->running++;
+
+                lock.unlock();
+                takeItems(*job);
+                lock.lock();
+
+                if(--job->running == 0) helperDone_.notify_all();
+            }
+        }
+
+    public:
+        void run(ParallelJob& job)
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                while(threadCount_ < job.helpersWanted)
+                {
+                    std::thread(&HelperPool::help, this).detach();
+                    threadCount_++;
+                }
+                job.nextJob = jobs_;
+                jobs_ = &job;
+            }
+            jobAdded_.notify_all();
+
+            takeItems(job);
+
+            //Unlist the job so that no more helpers join, then wait for those that did
+            std::unique_lock<std::mutex> lock(mutex_);
+            ParallelJob** link = &jobs_;
+            while(*link != &job) link = &(*link)->nextJob;
+            *link = job.nextJob;
+            helperDone_.wait(lock, [&]() { return job.running == 0; });
+        }
+    };
+
+    HelperPool& helperPool()
+    {
+        static HelperPool* pool = new HelperPool();
+        return *pool;
+    }
+}
+
+void runParallelJob(ParallelJob& job)
+{
+    helperPool().run(job);
+}
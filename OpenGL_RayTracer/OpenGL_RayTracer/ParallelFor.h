@@ -0,0 +1,63 @@
+/*----------------------------------------------------------
+* COSC363  Ray Tracer
+*
+*  parallelFor()
+*  Runs body(0) ... body(count - 1) on a number of threads.
+*  Items are handed out one at a time from a shared counter,
+*  so uneven items (e.g. rows with more reflections) balance.
+*  The calling thread takes items too, helped by threads of a
+*  pool that is started once and kept, so a call neither
+*  creates threads nor allocates. Calls may be nested or made
+*  from several threads at once: a call whose helpers are all
+*  busy elsewhere simply runs on the calling thread alone.
+-------------------------------------------------------------*/
+
+#ifndef H_PARALLEL_FOR
+#define H_PARALLEL_FOR
+
+#include <atomic>
+#include <thread>
+
+inline int defaultThreadCount()
+{
+    int threads = std::thread::hardware_concurrency();
+    return threads > 0 ? threads : 1;
+}
+
+//One parallelFor() call, on the caller's stack while it runs
+struct ParallelJob
+{
+    void (*run)(void* body, int i);
+    void* body;
+    int count;
+    std::atomic<int> next;
+    int helpersWanted;
+    int helpers = 0;        //pool threads that have joined, guarded by the pool's mutex
+    int running = 0;        //of those, the ones still taking items
+    ParallelJob* nextJob = nullptr;
+};
+
+//Runs 'job' on the calling thread and up to job.helpersWanted pool threads
+void runParallelJob(ParallelJob& job);
+
+template<class Body>
+void parallelFor(int count, int threads, Body body)
+{
+    if(threads < 1) threads = defaultThreadCount();
+    if(threads > count) threads = count;
+    if(threads <= 1)
+    {
+        for(int i = 0; i < count; i++) body(i);
+        return;
+    }
+
+    ParallelJob job;
+    job.run = [](void* b, int i) { (*static_cast<Body*>(b))(i); };
+    job.body = &body;
+    job.count = count;
+    job.next = 0;
+    job.helpersWanted = threads - 1;
+    runParallelJob(job);
+}
+
+#endif //!H_PARALLEL_FOR
@@ -1,75 +1,121 @@
-/*----------------------------------------------------------
-* COSC363  Ray Tracer
-*
-*  The Plane class
-*  This is a subclass of Object, and hence implements the
-*  methods intersect() and normal().
--------------------------------------------------------------*/
-
-#include "Plane.h"
-#include <math.h>
-
-/**
-* Plane's intersection method.  The input is a ray (p0, dir).
-* See slides Lec08-Slides 27, 29
-*/
-float Plane::intersect(glm::vec3 p0, glm::vec3 dir)
-{
-	glm::vec3 n = normal(p0);
-	glm::vec3 vdif = a_ - p0;
-	float d_dot_n = glm::dot(dir, n);
-	if(fabs(d_dot_n) < 1.e-4) return -1;
-
-    float t = glm::dot(vdif, n)/d_dot_n;
-	if(fabs(t) < 0.0001) return -1;
-	glm::vec3 q = p0 + dir*t;
-
-	if(isInside(q)) return t;
-    else return -1;
-}
-
-/**
-* Returns the unit normal vector at a given point.
-* Assumption: The input point p lies on the plane.
-*/
-glm::vec3 Plane::normal(glm::vec3 p)
-{
-	glm::vec3 v1 = c_-b_;
-	glm::vec3 v2 = a_-b_;
-	glm::vec3 n = glm::cross(v1, v2);
-	n = glm::normalize(n);
-    return n;
-}
-
-/**
-* 
-* Checks if a point q is inside the current polygon
-* See slide Lec08-Slide 29
-*/
-bool Plane::isInside(glm::vec3 q)
-{
-	glm::vec3 n = normal(q);     //Normal vector at the point of intersection
-	glm::vec3 ua = b_ - a_, ub = c_ - b_, uc = d_ - c_, ud = a_ - d_;
-	glm::vec3 va = q - a_, vb = q - b_, vc = q - c_, vd = q - d_;
-	if (nverts_ == 3) uc = a_ - c_;
-	float ka = glm::dot(glm::cross(ua, va), n);
-	float kb = glm::dot(glm::cross(ub, vb), n);
-	float kc = glm::dot(glm::cross(uc, vc), n);
-	float kd;
-	if (nverts_ == 4)
-		kd = glm::dot(glm::cross(ud, vd), n);
-	else
-		kd = ka;
-	if (ka > 0 && kb > 0 && kc > 0 && kd > 0) return true;
-	if (ka < 0 && kb < 0 && kc < 0 && kd < 0) return true;
-	else return false;
-}
-
-
-//Getter function for number of vertices
-int  Plane::getNumVerts()
-{
-	return nverts_;
-}
-
-
+/*----------------------------------------------------------
+* COSC363  Ray Tracer
+*
+*  The Plane class
+*  This is a subclass of Object, and hence implements the
+*  methods intersect() and normal().
+-------------------------------------------------------------*/
+
+#include "Plane.h"
+#include <math.h>
+
+/**
+* Plane's intersection method.  The input is a ray (p0, dir).
+* See slides Lec08-Slides 27, 29
+*/
+float Plane::intersect(glm::vec3 p0, glm::vec3 dir)
+{
+	glm::vec3 n = normal(p0);
+	glm::vec3 vdif = a_ - p0;
+	float d_dot_n = glm::dot(dir, n);
+	if(fabs(d_dot_n) < 1.e-4) return -1;
+
+    float t = glm::dot(vdif, n)/d_dot_n;
+	if(fabs(t) < 0.0001) return -1;
+	glm::vec3 q = p0 + dir*t;
+
+	if(isInside(q)) return t;
+    else return -1;
+}
+
+/**
+* Returns the unit normal vector at a given point.
+* Assumption: The input point p lies on the plane.
+*/
+glm::vec3 Plane::normal(glm::vec3 p)
+{
+	glm::vec3 v1 = c_-b_;
+	glm::vec3 v2 = a_-b_;
+	glm::vec3 n = glm::cross(v1, v2);
+	n = glm::normalize(n);
+    return n;
+}
+
+/**
+* 
+* Checks if a point q is inside the current polygon
+* See slide Lec08-Slide 29
+*/
+bool Plane::isInside(glm::vec3 q)
+{
+	glm::vec3 n = normal(q);     //Normal vector at the point of intersection
+	glm::vec3 ua = b_ - a_, ub = c_ - b_, uc = d_ - c_, ud = a_ - d_;
+	glm::vec3 va = q - a_, vb = q - b_, vc = q - c_, vd = q - d_;
+	if (nverts_ == 3) uc = a_ - c_;
+	float ka = glm::dot(glm::cross(ua, va), n);
+	float kb = glm::dot(glm::cross(ub, vb), n);
+	float kc = glm::dot(glm::cross(uc, vc), n);
+	float kd;
+	if (nverts_ == 4)
+		kd = glm::dot(glm::cross(ud, vd), n);
+	else
+		kd = ka;
+	if (ka > 0 && kb > 0 && kc > 0 && kd > 0) return true;
+	if (ka < 0 && kb < 0 && kc < 0 && kd < 0) return true;
+	else return false;
+}
+
+
+//Getter function for number of vertices
+int  Plane::getNumVerts()
+{
+	return nverts_;
+}
+
+/**
+* Position along the edges from a to b (u) and from a to d, or a to c for a
+* triangle (v); both run over [0, 1] on a rectangle.
+*/
+glm::vec2 Plane::textureCoords(glm::vec3 pt)
+{
+	glm::vec3 e1 = b_ - a_;
+	glm::vec3 e2 = (nverts_ == 4 ? d_ : c_) - a_;
+	glm::vec3 q = pt - a_;
+	return glm::vec2(glm::dot(q, e1) / glm::dot(e1, e1), glm::dot(q, e2) / glm::dot(e2, e2));
+}
+
+BoundingBox Plane::bounds()
+{
+	BoundingBox box;
+	box.expand(a_);
+	box.expand(b_);
+	box.expand(c_);
+	if (nverts_ == 4) box.expand(d_);
+	return box;
+}
+
+void Plane::translate(glm::vec3 d)
+{
+	a_ += d;
+	b_ += d;
+	c_ += d;
+	d_ += d;
+}
+
+SceneObject* Plane::clone()
+{
+	return new Plane(*this);
+}
+
+ShapeKind Plane::getShape(float* params)
+{
+    glm::vec3 vertices[4] = {a_, b_, c_, d_};
+    for(int v = 0; v < 4; v++)
+    {
+        params[3 * v] = vertices[v].x;
+        params[3 * v + 1] = vertices[v].y;
+        params[3 * v + 2] = vertices[v].z;
+    }
+    params[12] = nverts_;
+    return SHAPE_PLANE;
+}
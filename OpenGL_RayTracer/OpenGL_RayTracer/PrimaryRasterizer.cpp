@@ -0,0 +1,186 @@
+/*----------------------------------------------------------
+* COSC363  Ray Tracer
+*
+*  The primary rasterizer class
+-------------------------------------------------------------*/
+
+#include "PrimaryRasterizer.h"
+#include "ParallelFor.h"
+#include "Ray.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+namespace
+{
+    //Margin added around every box, as in BVH, so that hits rounded just outside it are kept
+    const float BOX_MARGIN = 1.e-3f;
+}
+
+size_t PrimaryRasterizer::memorySize(int width, int height, int samples)
+{
+    return (size_t)width * height * samples * samples * sizeof(VisibilitySample);
+}
+
+/**
+* The projected rectangles are found as in TileBinner, grown by a pixel
+* for rounding. An object with a box corner behind the eye covers every
+* pixel, and one wholly behind it none. Since a primary ray's hit on an
+* object lies in the object's box, its depth is never less than the box's
+* distance from the eye, which makes stopping at the first box further
+* than the closest hit exact.
+*/
+void PrimaryRasterizer::render(Scene& scene, Camera& camera, int width, int height, int samples,
+                               float xMin, float xMax, float yMin, float yMax, int tileSize, int threads)
+{
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    width_ = width;
+    height_ = height;
+    samples_ = std::max(1, samples);
+    tileSize = std::max(1, tileSize);
+    buffer_.assign((size_t)width * height * samples_ * samples_, VisibilitySample());
+
+    float cellX = (xMax - xMin) / width;
+    float cellY = (yMax - yMin) / height;
+    glm::vec3 eye = camera.getEye();
+
+    int objectCount = scene.objects.size();
+    std::vector<Fragment> fragments;
+    fragments.reserve(objectCount);
+    for(int n = 0; n < objectCount; n++)
+    {
+        BoundingBox box = scene.objects[n]->bounds();
+        box.pad(BOX_MARGIN);
+
+        bool anyInFront = false;
+        bool anyBehind = false;
+        glm::vec2 lo(1.e+30f), hi(-1.e+30f);
+        for(int c = 0; c < 8; c++)
+        {
+            glm::vec3 corner((c & 1) ? box.max.x : box.min.x,
+                             (c & 2) ? box.max.y : box.min.y,
+                             (c & 4) ? box.max.z : box.min.z);
+            glm::vec2 xy;
+            if(camera.project(corner, xy))
+            {
+                anyInFront = true;
+                lo = glm::vec2(std::min(lo.x, xy.x), std::min(lo.y, xy.y));
+                hi = glm::vec2(std::max(hi.x, xy.x), std::max(hi.y, xy.y));
+            }
+            else
+            {
+                anyBehind = true;
+            }
+        }
+        if(!anyInFront) continue;
+
+        Fragment fragment;
+        fragment.object = n;
+        glm::vec3 outside = glm::max(glm::max(box.min - eye, eye - box.max), glm::vec3(0));
+        fragment.near = glm::length(outside) * (1 - 1.e-5f);
+        if(anyBehind)
+        {
+            fragment.i0 = fragment.j0 = 0;
+            fragment.i1 = width - 1;
+            fragment.j1 = height - 1;
+        }
+        else
+        {
+            fragment.i0 = std::max(0, (int)floor((lo.x - xMin) / cellX) - 1);
+            fragment.j0 = std::max(0, (int)floor((lo.y - yMin) / cellY) - 1);
+            fragment.i1 = std::min(width - 1, (int)floor((hi.x - xMin) / cellX) + 1);
+            fragment.j1 = std::min(height - 1, (int)floor((hi.y - yMin) / cellY) + 1);
+            if(fragment.i0 > fragment.i1 || fragment.j0 > fragment.j1) continue;
+        }
+        fragments.push_back(fragment);
+    }
+
+    //Nearest first; equal depths in index order, so ties go to the lowest index as in Ray::closestPt()
+    std::sort(fragments.begin(), fragments.end(), [](const Fragment& a, const Fragment& b)
+    {
+        return a.near < b.near || (a.near == b.near && a.object < b.object);
+    });
+
+    int tilesX = (width + tileSize - 1) / tileSize;
+    int tilesY = (height + tileSize - 1) / tileSize;
+    std::vector<std::vector<int> > bins(tilesX * tilesY);
+    for(size_t f = 0; f < fragments.size(); f++)
+    {
+        const Fragment& fragment = fragments[f];
+        for(int ty = fragment.j0 / tileSize; ty <= fragment.j1 / tileSize; ty++)
+        {
+            for(int tx = fragment.i0 / tileSize; tx <= fragment.i1 / tileSize; tx++)
+            {
+                bins[ty * tilesX + tx].push_back(f);
+            }
+        }
+    }
+
+    std::vector<double> tileTests(bins.size(), 0);
+    parallelFor(bins.size(), threads, [&](int tile)
+    {
+        const std::vector<int>& bin = bins[tile];
+        if(bin.empty()) return;
+        int i0 = (tile % tilesX) * tileSize;
+        int j0 = (tile / tilesX) * tileSize;
+        int i1 = std::min(width, i0 + tileSize);
+        int j1 = std::min(height, j0 + tileSize);
+        double tests = 0;
+        for(int j = j0; j < j1; j++)
+        {
+            for(int i = i0; i < i1; i++)
+            {
+                for(int k = 0; k < samples_; k++)
+                {
+                    for(int h = 0; h < samples_; h++)
+                    {
+                        glm::vec2 xy = samplePoint(i, j, k, h, width, height, samples_, xMin, xMax, yMin, yMax);
+                        Ray ray(eye, camera.direction(xy.x, xy.y));
+                        float tmin = 1.e+6;
+                        int best = -1;
+                        int bestPart = -1;
+                        for(size_t b = 0; b < bin.size(); b++)
+                        {
+                            const Fragment& fragment = fragments[bin[b]];
+                            if(fragment.near > tmin) break;
+                            if(i < fragment.i0 || i > fragment.i1 || j < fragment.j0 || j > fragment.j1) continue;
+
+                            int part;
+                            float t = scene.objects[fragment.object]->intersect(ray.p0, ray.dir, part);
+                            tests++;
+                            if(t > 0 && (t < tmin || (t == tmin && fragment.object < best)))
+                            {
+                                tmin = t;
+                                best = fragment.object;
+                                bestPart = part;
+                            }
+                        }
+                        VisibilitySample& sample = buffer_[(((size_t)j * width + i) * samples_ + k) * samples_ + h];
+                        sample.object = best;
+                        sample.depth = tmin;
+                        sample.part = bestPart;
+                    }
+                }
+            }
+        }
+        tileTests[tile] = tests;
+    });
+
+    tests_ = 0;
+    for(size_t t = 0; t < tileTests.size(); t++)
+    {
+        tests_ += tileTests[t];
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    seconds_ = elapsed.count();
+}
+
+double PrimaryRasterizer::getMeanTests()
+{
+    return buffer_.empty() ? 0 : tests_ / buffer_.size();
+}
+
+double PrimaryRasterizer::getSeconds()
+{
+    return seconds_;
+}
@@ -0,0 +1,86 @@
+/*----------------------------------------------------------
+* COSC363  Ray Tracer
+*
+*  The primary rasterizer class
+*  Finds what every primary sample of an image sees without
+*  casting primary rays through the scene: each object's
+*  bounding box is projected and scan-converted into the
+*  screen tiles it covers, with its nearest possible depth.
+*  Each tile's objects are sorted by that depth, so a sample
+*  tests only the objects covering its pixel, nearest first,
+*  and stops once the next box is further than its hit. The
+*  result is a visibility buffer of object ID, part and depth per
+*  sample, the same hit that Scene::closestPt() would find,
+*  from which shading rays are then traced.
+-------------------------------------------------------------*/
+
+#ifndef H_PRIMARY_RASTERIZER
+#define H_PRIMARY_RASTERIZER
+
+#include <vector>
+#include "Camera.h"
+#include "Scene.h"
+
+struct VisibilitySample
+{
+    int object = -1;    //-1: background
+    float depth = 0;    //distance from the eye along the sample's unit direction
+    int part = -1;      //part of the object hit (see SceneObject::intersect())
+};
+
+class PrimaryRasterizer
+{
+private:
+    struct Fragment
+    {
+        float near;     //distance from the eye to the object's box
+        int object;
+        int i0, j0, i1, j1;     //pixels covered by the box's projection, inclusive
+    };
+
+    int width_ = 0;
+    int height_ = 0;
+    int samples_ = 1;
+    std::vector<VisibilitySample> buffer_;
+    double tests_ = 0;      //intersection tests made by the last render()
+    double seconds_ = 0;
+
+public:
+    /**
+    * View plane point of sub-sample (k, h) of pixel (i, j) of a width x height
+    * image with samples x samples sub-samples per pixel. renderPixelKernel()
+    * aims its primary rays with the same arithmetic.
+    */
+    static glm::vec2 samplePoint(int i, int j, int k, int h, int width, int height, int samples,
+                                 float xMin, float xMax, float yMin, float yMax)
+    {
+        float cellX = (xMax - xMin) / width;
+        float cellY = (yMax - yMin) / height;
+        float subCellX = cellX / float(samples);
+        float subCellY = cellY / float(samples);
+        float subxp = (xMin + i * cellX) + k * subCellX;
+        float subyp = (yMin + j * cellY) + h * subCellY;
+        return glm::vec2(subxp + 0.5 * subCellX, subyp + 0.5 * subCellY);
+    }
+
+    //Bytes the visibility buffer of such an image takes
+    static size_t memorySize(int width, int height, int samples);
+
+    /**
+    * Fills the visibility buffer for the view plane rectangle (xMin, yMin) -
+    * (xMax, yMax) seen through 'camera', in tiles on 'threads' threads.
+    */
+    void render(Scene& scene, Camera& camera, int width, int height, int samples,
+                float xMin, float xMax, float yMin, float yMax, int tileSize = 16, int threads = 0);
+
+    //Sub-sample (k, h) of pixel (i, j); j counted from the bottom
+    const VisibilitySample& at(int i, int j, int k, int h) const
+    {
+        return buffer_[(((size_t)j * width_ + i) * samples_ + k) * samples_ + h];
+    }
+
+    double getMeanTests();
+    double getSeconds();
+};
+
+#endif //!H_PRIMARY_RASTERIZER
@@ -0,0 +1,306 @@
+/*----------------------------------------------------------
+* COSC363  Ray Tracer
+*
+*  The progressive renderer class
+-------------------------------------------------------------*/
+
+#include "ProgressiveRenderer.h"
+#include "ParallelFor.h"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+
+namespace
+{
+    const char CHECKPOINT_MAGIC[4] = {'R', 'T', 'C', 'P'};
+    const uint32_t BYTE_ORDER_MARK = 0x01020304;
+    const uint64_t SECTION_ALIGNMENT = 16;
+
+    uint64_t align(uint64_t offset)
+    {
+        return (offset + SECTION_ALIGNMENT - 1) / SECTION_ALIGNMENT * SECTION_ALIGNMENT;
+    }
+
+    //The splitmix64 finaliser
+    uint64_t mix(uint64_t x)
+    {
+        x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+        return x ^ (x >> 31);
+    }
+
+    unsigned char toByte(float c)
+    {
+        c = c < 0 ? 0 : (c > 1 ? 1 : c);
+        return (unsigned char)(c * 255.0f + 0.5f);
+    }
+
+    bool writeAll(int fd, const void* data, size_t size)
+    {
+        const char* p = (const char*)data;
+        while(size > 0)
+        {
+            ssize_t n = write(fd, p, size);
+            if(n < 0 && errno == EINTR) continue;
+            if(n <= 0) return false;
+            p += n;
+            size -= n;
+        }
+        return true;
+    }
+
+    double secondsSince(chrono::steady_clock::time_point start)
+    {
+        chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+        return elapsed.count();
+    }
+}
+
+ProgressiveRenderer::ProgressiveRenderer(int width, int height, uint64_t sceneHash, uint64_t seed)
+    : width_(max(0, width)), height_(max(0, height)), sceneHash_(sceneHash), seed_(seed)
+{
+    reset();
+}
+
+/**
+* Maps a zeroed anonymous buffer with the file's layout, so that a fresh
+* and a resumed render accumulate the same way.
+*/
+void ProgressiveRenderer::reset()
+{
+    size_t pixels = (size_t)width_ * height_;
+    uint64_t sumsOffset = align(sizeof(CheckpointHeader));
+    uint64_t countsOffset = align(sumsOffset + pixels * 3 * sizeof(float));
+    size_t size = countsOffset + pixels * sizeof(uint32_t);
+
+    void* base = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if(base == MAP_FAILED)
+    {
+        cerr << "*** Out of memory for a " << width_ << "x" << height_ << " accumulation buffer" << endl;
+        width_ = height_ = 0;
+        reset();
+        return;
+    }
+    storage_ = shared_ptr<void>(base, [size](void* p) { munmap(p, size); });
+    size_ = size;
+
+    header_ = (CheckpointHeader*)base;
+    memcpy(header_->magic, CHECKPOINT_MAGIC, 4);
+    header_->version = VERSION;
+    header_->byteOrder = BYTE_ORDER_MARK;
+    header_->width = width_;
+    header_->height = height_;
+    header_->sceneHash = sceneHash_;
+    header_->seed = seed_;
+    header_->samples = 0;
+    header_->sumsOffset = sumsOffset;
+    header_->countsOffset = countsOffset;
+    header_->fileSize = size;
+    sums_ = (float*)((char*)base + sumsOffset);
+    counts_ = (uint32_t*)((char*)base + countsOffset);
+    resumedSamples_ = 0;
+}
+
+void ProgressiveRenderer::setThreadCount(int threads)
+{
+    threadCount_ = threads;
+}
+
+void ProgressiveRenderer::setBlockRows(int rows)
+{
+    blockRows_ = max(1, rows);
+}
+
+void ProgressiveRenderer::setCheckpoint(const char* path, double seconds)
+{
+    checkpointPath_ = path;
+    checkpointInterval_ = seconds;
+}
+
+/**
+* The file is mapped copy-on-write: its pages are only read in as the
+* render touches them, and later checkpoints replace the file without
+* disturbing the mapping.
+*/
+bool ProgressiveRenderer::resume()
+{
+    if(checkpointPath_ == NULL) return false;
+    int fd = open(checkpointPath_, O_RDONLY);
+    if(fd < 0) return false;
+    struct stat info;
+    if(fstat(fd, &info) != 0 || (size_t)info.st_size != size_)
+    {
+        close(fd);
+        return false;
+    }
+    void* base = mmap(NULL, size_, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if(base == MAP_FAILED) return false;
+    size_t size = size_;
+    shared_ptr<void> mapping(base, [size](void* p) { munmap(p, size); });
+
+    const CheckpointHeader& header = *(const CheckpointHeader*)base;
+    if(memcmp(header.magic, CHECKPOINT_MAGIC, 4) != 0 || header.version != VERSION || header.byteOrder != BYTE_ORDER_MARK
+       || header.width != header_->width || header.height != header_->height || header.sceneHash != sceneHash_
+       || header.seed != seed_ || header.sumsOffset != header_->sumsOffset || header.countsOffset != header_->countsOffset
+       || header.fileSize != size_)
+    {
+        return false;
+    }
+
+    storage_ = mapping;
+    header_ = (CheckpointHeader*)base;
+    sums_ = (float*)((char*)base + header_->sumsOffset);
+    counts_ = (uint32_t*)((char*)base + header_->countsOffset);
+    resumedSamples_ = header_->samples;
+    return true;
+}
+
+/**
+* Passes are traced a block of rows at a time; between blocks no sample
+* is being added, so that is where checkpoints are written and stop
+* requests honoured. Within a pass only pixels still short of it are
+* sampled, as a render resumed from the middle of a pass has some rows
+* one sample ahead.
+*/
+bool ProgressiveRenderer::render(const SampleFunction& sample, uint32_t samplesPerPixel, const atomic<bool>* stop)
+{
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    chrono::steady_clock::time_point lastCheckpoint = start;
+    int width = width_;
+    int height = height_;
+    bool stopped = false;
+
+    for(uint32_t pass = getMinSamples(); pass < samplesPerPixel && !stopped; pass++)
+    {
+        for(int firstRow = 0; firstRow < height && !stopped; firstRow += blockRows_)
+        {
+            int rows = min(blockRows_, height - firstRow);
+            parallelFor(rows, threadCount_, [&](int r)
+            {
+                int row = firstRow + r;
+                int j = height - 1 - row;
+                for(int i = 0; i < width; i++)
+                {
+                    size_t p = (size_t)row * width + i;
+                    uint32_t n = counts_[p];
+                    if(n > pass) continue;
+                    glm::vec2 offset = sampleOffset(seed_, i, j, n);
+                    glm::vec3 color = sample(i, j, offset.x, offset.y);
+                    sums_[p * 3] += color.r;
+                    sums_[p * 3 + 1] += color.g;
+                    sums_[p * 3 + 2] += color.b;
+                    counts_[p] = n + 1;
+                }
+            });
+
+            stopped = stop != NULL && *stop;
+            if(!stopped && checkpointPath_ != NULL && secondsSince(lastCheckpoint) >= checkpointInterval_)
+            {
+                if(!checkpoint())
+                {
+                    renderSeconds_ += secondsSince(start);
+                    return false;
+                }
+                lastCheckpoint = chrono::steady_clock::now();
+            }
+        }
+    }
+
+    bool saved = checkpointPath_ == NULL || checkpoint();
+    renderSeconds_ += secondsSince(start);
+    return saved && !stopped;
+}
+
+/**
+* Written to a temporary file, flushed to disk and renamed over the old
+* checkpoint, so a render killed at any moment leaves one whole file.
+*/
+bool ProgressiveRenderer::checkpoint()
+{
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    header_->samples = getSamples();
+
+    string temporary = string(checkpointPath_) + ".tmp";
+    int fd = open(temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    bool written = fd >= 0 && writeAll(fd, storage_.get(), size_) && fsync(fd) == 0;
+    if(fd >= 0) close(fd);
+    if(!written || rename(temporary.c_str(), checkpointPath_) != 0)
+    {
+        cerr << "*** Error writing checkpoint: " << checkpointPath_ << endl;
+        unlink(temporary.c_str());
+        return false;
+    }
+
+    checkpoints_++;
+    checkpointSeconds_ += secondsSince(start);
+    return true;
+}
+
+void ProgressiveRenderer::resolve(int firstRow, int rows, unsigned char* rgb) const
+{
+    for(size_t p = (size_t)firstRow * width_; p < (size_t)(firstRow + rows) * width_; p++, rgb += 3)
+    {
+        float scale = counts_[p] > 0 ? 1.0f / counts_[p] : 0.0f;
+        rgb[0] = toByte(sums_[p * 3] * scale);
+        rgb[1] = toByte(sums_[p * 3 + 1] * scale);
+        rgb[2] = toByte(sums_[p * 3 + 2] * scale);
+    }
+}
+
+/**
+* Integer hashing only, so a checkpoint resumes to the same samples on
+* any machine.
+*/
+glm::vec2 ProgressiveRenderer::sampleOffset(uint64_t seed, int i, int j, uint32_t n)
+{
+    uint64_t h = mix(mix(mix(seed) ^ ((uint64_t)(uint32_t)i << 32 | (uint32_t)j)) ^ n);
+    const float scale = 1.0f / (1 << 24);
+    return glm::vec2((h >> 40) * scale, ((h >> 16) & 0xFFFFFF) * scale);
+}
+
+uint32_t ProgressiveRenderer::getMinSamples() const
+{
+    size_t pixels = (size_t)width_ * height_;
+    return pixels > 0 ? *min_element(counts_, counts_ + pixels) : 0;
+}
+
+uint64_t ProgressiveRenderer::getSamples() const
+{
+    uint64_t samples = 0;
+    for(size_t p = 0; p < (size_t)width_ * height_; p++)
+    {
+        samples += counts_[p];
+    }
+    return samples;
+}
+
+uint64_t ProgressiveRenderer::getResumedSamples() const
+{
+    return resumedSamples_;
+}
+
+int ProgressiveRenderer::getCheckpointCount() const
+{
+    return checkpoints_;
+}
+
+double ProgressiveRenderer::getCheckpointSeconds() const
+{
+    return checkpointSeconds_;
+}
+
+double ProgressiveRenderer::getRenderSeconds() const
+{
+    return renderSeconds_;
+}
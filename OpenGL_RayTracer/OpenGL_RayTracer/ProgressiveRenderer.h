@@ -0,0 +1,123 @@
+/*----------------------------------------------------------
+* COSC363  Ray Tracer
+*
+*  The progressive renderer class
+*  Renders an image one jittered sample per pixel per pass,
+*  summing the samples of every pixel, and periodically saves
+*  the sums, the per-pixel sample counts, the random seed and
+*  a hash of the scene to a checkpoint file. The accumulation
+*  buffer is laid out exactly like the file, so a checkpoint is
+*  one write of the buffer to a temporary file that is then
+*  renamed over the old one, and resuming maps the file
+*  privately and carries on accumulating in the mapping.
+*  Sample n of a pixel is placed by a hash of the seed, the
+*  pixel and n, and is added after samples 0 ... n - 1, so a
+*  resumed render gives the same image, bit for bit, as one
+*  that was never interrupted.
+-------------------------------------------------------------*/
+
+#ifndef H_PROGRESSIVE_RENDERER
+#define H_PROGRESSIVE_RENDERER
+
+#include <glm/glm.hpp>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <stdint.h>
+
+//Colour of a sample at (i + dx, j + dy); i is the column, j the row counted from the bottom, dx and dy in [0, 1)
+typedef std::function<glm::vec3(int i, int j, float dx, float dy)> SampleFunction;
+
+struct CheckpointHeader
+{
+    char magic[4];
+    uint32_t version;
+    uint32_t byteOrder;     //BYTE_ORDER_MARK as written by the saving machine
+    uint32_t width;
+    uint32_t height;
+    uint32_t reserved;
+    uint64_t sceneHash;
+    uint64_t seed;
+    uint64_t samples;       //Samples taken over all pixels
+    uint64_t sumsOffset;    //3 floats per pixel: the sum of its samples' colours, rows from the top
+    uint64_t countsOffset;  //uint32 per pixel: its number of samples
+    uint64_t fileSize;
+};
+
+class ProgressiveRenderer
+{
+private:
+    int width_;
+    int height_;
+    uint64_t sceneHash_;
+    uint64_t seed_;
+    int threadCount_ = 0;
+    int blockRows_ = 16;
+    const char* checkpointPath_ = NULL;
+    double checkpointInterval_ = 60;
+
+    //The accumulation buffer: a private mapping laid out as a checkpoint file
+    std::shared_ptr<void> storage_;
+    size_t size_ = 0;
+    CheckpointHeader* header_ = NULL;
+    float* sums_ = NULL;
+    uint32_t* counts_ = NULL;
+
+    uint64_t resumedSamples_ = 0;
+    int checkpoints_ = 0;
+    double checkpointSeconds_ = 0;
+    double renderSeconds_ = 0;
+
+    ProgressiveRenderer(const ProgressiveRenderer&);
+    ProgressiveRenderer& operator=(const ProgressiveRenderer&);
+
+    void reset();
+
+public:
+    static const uint32_t VERSION = 1;
+
+    ProgressiveRenderer(int width, int height, uint64_t sceneHash, uint64_t seed);
+
+    void setThreadCount(int threads);
+
+    //Rows traced between checks for a due checkpoint or a stop request
+    void setBlockRows(int rows);
+
+    //Save to 'path' every 'seconds' while rendering, and when stopped
+    void setCheckpoint(const char* path, double seconds);
+
+    /**
+    * Maps the checkpoint file and carries on from it. False, starting from
+    * no samples, if the file is missing, damaged, of another version or
+    * machine, or saved for another image size, scene or seed.
+    */
+    bool resume();
+
+    /**
+    * Traces passes until every pixel has 'samplesPerPixel' samples. Stops
+    * early, after saving a checkpoint, once 'stop' becomes true; returns
+    * false if stopped or if a checkpoint could not be written.
+    */
+    bool render(const SampleFunction& sample, uint32_t samplesPerPixel, const std::atomic<bool>* stop = NULL);
+
+    //Writes the checkpoint file now
+    bool checkpoint();
+
+    //Mean colour of 'rows' image rows from 'firstRow' (counted from the top) as packed 8-bit RGB
+    void resolve(int firstRow, int rows, unsigned char* rgb) const;
+
+    //Sub-pixel position of sample n of pixel (i, j)
+    static glm::vec2 sampleOffset(uint64_t seed, int i, int j, uint32_t n);
+
+    //Fewest samples of any pixel
+    uint32_t getMinSamples() const;
+    uint64_t getSamples() const;
+    uint64_t getResumedSamples() const;
+    int getCheckpointCount() const;
+    double getCheckpointSeconds() const;
+
+    //Time spent in render(), checkpoints included
+    double getRenderSeconds() const;
+};
+
+#endif //!H_PROGRESSIVE_RENDERER
@@ -0,0 +1,92 @@
+/*----------------------------------------------------------
+* COSC363  Ray Tracer
+*
+*  The quality controller class
+-------------------------------------------------------------*/
+
+#include "QualityController.h"
+#include <algorithm>
+
+namespace
+{
+    const double SLOW = 1.15;   //Frame slower than target * SLOW counts as slow
+    const double FAST = 0.8;    //Better level predicted under target * FAST counts as fast
+}
+
+QualityController::QualityController(int maxSteps)
+{
+    QualityLevel ladder[] = {
+        {1.0f,  2, maxSteps},
+        {1.0f,  1, maxSteps},
+        {0.75f, 1, maxSteps},
+        {0.5f,  1, std::min(maxSteps, 3)},
+        {0.35f, 1, std::min(maxSteps, 2)},
+        {0.25f, 1, 1},
+    };
+    levels_.assign(ladder, ladder + sizeof(ladder) / sizeof(ladder[0]));
+}
+
+void QualityController::setTargetFrameTime(double seconds)
+{
+    targetSeconds_ = seconds;
+    level_ = 0;
+    slowFrames_ = 0;
+    fastFrames_ = 0;
+}
+
+bool QualityController::isEnabled()
+{
+    return targetSeconds_ > 0;
+}
+
+const QualityLevel& QualityController::current()
+{
+    return levels_[level_];
+}
+
+int QualityController::getLevel()
+{
+    return level_;
+}
+
+/**
+* Primary ray count of a level; recursion depth is left out because
+* its cost depends on what the rays hit.
+*/
+double QualityController::relativeCost(int level)
+{
+    const QualityLevel& q = levels_[level];
+    return q.resolutionScale * q.resolutionScale * q.samples * q.samples;
+}
+
+void QualityController::frameFinished(double seconds)
+{
+    if(!isEnabled()) return;
+
+    if(seconds > targetSeconds_ * SLOW)
+    {
+        fastFrames_ = 0;
+        if(++slowFrames_ >= SLOW_FRAMES_TO_DROP && level_ + 1 < (int)levels_.size())
+        {
+            level_++;
+            slowFrames_ = 0;
+        }
+        return;
+    }
+    slowFrames_ = 0;
+
+    if(level_ == 0) return;
+    double predicted = seconds * relativeCost(level_ - 1) / relativeCost(level_);
+    if(predicted < targetSeconds_ * FAST)
+    {
+        if(++fastFrames_ >= FAST_FRAMES_TO_RISE)
+        {
+            level_--;
+            fastFrames_ = 0;
+        }
+    }
+    else
+    {
+        fastFrames_ = 0;
+    }
+}
@@ -0,0 +1,56 @@
+/*----------------------------------------------------------
+* COSC363  Ray Tracer
+*
+*  The quality controller class
+*  Picks the render resolution, samples per pixel and maximum
+*  ray depth for the next frame so that frames take about a
+*  target time. Quality moves along a fixed ladder of levels.
+*  It drops a level after two consecutive slow frames, and
+*  rises a level only after several consecutive frames whose
+*  time, scaled by the cost of the better level, would still
+*  fit comfortably within the target. The gap between the two
+*  thresholds keeps the quality from oscillating.
+-------------------------------------------------------------*/
+
+#ifndef H_QUALITY_CONTROLLER
+#define H_QUALITY_CONTROLLER
+
+#include <vector>
+
+struct QualityLevel
+{
+    float resolutionScale;  //Fraction of the full render resolution along each axis
+    int samples;            //Sub-samples per pixel along each axis
+    int maxSteps;           //Maximum recursion depth of trace()
+};
+
+class QualityController
+{
+private:
+    std::vector<QualityLevel> levels_;
+    int level_ = 0;
+    double targetSeconds_ = 0;
+    int slowFrames_ = 0;
+    int fastFrames_ = 0;
+
+    double relativeCost(int level);
+
+public:
+    static const int SLOW_FRAMES_TO_DROP = 2;
+    static const int FAST_FRAMES_TO_RISE = 4;
+
+    //Ladder from full quality (maxSteps, 2x2 samples, full resolution) downwards
+    QualityController(int maxSteps);
+
+    //0 disables the controller, which then stays at full quality
+    void setTargetFrameTime(double seconds);
+    bool isEnabled();
+
+    const QualityLevel& current();
+    int getLevel();
+
+    //Reports how long the frame rendered at current() took
+    void frameFinished(double seconds);
+};
+
+#endif //!H_QUALITY_CONTROLLER
@@ -1,31 +1,67 @@
-/*----------------------------------------------------------
-* COSC363  Ray Tracer
-*
-*  The ray class
--------------------------------------------------------------*/
-#include "Ray.h"
-
-//Finds the closest point of intersection of the current ray with scene objects
-void Ray::closestPt(std::vector<SceneObject*> &sceneObjects)
-{
-    glm::vec3 point(0,0,0);
-    float tmin = 1.e+6;
-    for(uint i = 0;  i < sceneObjects.size();  i++)
-    {
-        float t = sceneObjects[i]->intersect(p0, dir);
-        if(t > 0)        //Intersects the object
-        {
-            point = p0 + dir*t;
-            if(t < tmin)
-            {
-                hit = point;
-                index = i;
-                dist = t;
-                tmin = t;
-                hitSceneObject = sceneObjects[i];
-            }
-        }
-    }
-
-}
-
+/*----------------------------------------------------------
+* COSC363  Ray Tracer
+*
+*  The ray class
+-------------------------------------------------------------*/
+#include "Ray.h"
+
+//Finds the closest point of intersection of the current ray with scene objects
+void Ray::closestPt(std::vector<SceneObject*> &sceneObjects)
+{
+    glm::vec3 point(0,0,0);
+    float tmin = 1.e+6;
+    for(uint i = 0;  i < sceneObjects.size();  i++)
+    {
+        int hitPart;
+        float t = sceneObjects[i]->intersect(p0, dir, hitPart);
+        if(t > 0)        //Intersects the object
+        {
+            point = p0 + dir*t;
+            if(t < tmin)
+            {
+                hit = point;
+                index = i;
+                dist = t;
+                part = hitPart;
+                tmin = t;
+                hitSceneObject = sceneObjects[i];
+            }
+        }
+    }
+
+}
+
+//Finds the closest point of intersection of the current ray with the listed scene objects
+void Ray::closestPt(std::vector<SceneObject*> &sceneObjects, const int* candidates, int count)
+{
+    float tmin = 1.e+6;
+    for(int k = 0;  k < count;  k++)
+    {
+        int i = candidates[k];
+        int hitPart;
+        float t = sceneObjects[i]->intersect(p0, dir, hitPart);
+        if(t > 0 && t < tmin)
+        {
+            hit = p0 + dir*t;
+            index = i;
+            dist = t;
+            part = hitPart;
+            tmin = t;
+            hitSceneObject = sceneObjects[i];
+        }
+    }
+}
+
+//Checks whether the ray hits any scene object before maxDist
+bool Ray::occluded(std::vector<SceneObject*> &sceneObjects, float maxDist)
+{
+    for(uint i = 0;  i < sceneObjects.size();  i++)
+    {
+        float t = sceneObjects[i]->intersect(p0, dir);
+        if(t > 0 && t < maxDist)
+        {
+            return true;
+        }
+    }
+    return false;
+}
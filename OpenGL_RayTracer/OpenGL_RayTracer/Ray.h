@@ -1,36 +1,43 @@
-/*----------------------------------------------------------
-* COSC363  Ray Tracer
-*
-*  The ray class
--------------------------------------------------------------*/
-
-#ifndef H_RAY
-#define H_RAY
-#include <glm/glm.hpp>
-#include <vector>
-#include "SceneObject.h"
-
-class Ray
-{
-
-public:
-	glm::vec3 p0 = glm::vec3(0);		//The source point of the ray
-	glm::vec3 dir = glm::vec3(0,0,-1);	//The UNIT direction of the ray
-	glm::vec3 hit = glm::vec3(0);		//The closest point of intersection on the ray
-	int index = -1;						//The index of the object that gives the closet point of intersection
-	float dist = 0;						//The distance from the p0 to hit along the ray.
-    SceneObject* hitSceneObject = NULL;
-
-	Ray() {}		//Default constructor
-
-
-	Ray(glm::vec3 source, glm::vec3 direction)
-	{
-		p0 = source;
-		dir = glm::normalize(direction);
-	}
-
-	void closestPt(std::vector<SceneObject*>& sceneObjects);
-
-};
-#endif
+/*----------------------------------------------------------
+* COSC363  Ray Tracer
+*
+*  The ray class
+-------------------------------------------------------------*/
+
+#ifndef H_RAY
+#define H_RAY
+#include <glm/glm.hpp>
+#include <vector>
+#include "SceneObject.h"
+
+class Ray
+{
+
+public:
+	glm::vec3 p0 = glm::vec3(0);		//The source point of the ray
+	glm::vec3 dir = glm::vec3(0,0,-1);	//The UNIT direction of the ray
+	glm::vec3 hit = glm::vec3(0);		//The closest point of intersection on the ray
+	int index = -1;						//The index of the object that gives the closet point of intersection
+	float dist = 0;						//The distance from the p0 to hit along the ray.
+	int part = -1;						//The part of that object hit (see SceneObject::intersect()), -1 if it has none
+    SceneObject* hitSceneObject = NULL;
+
+	Ray() {}		//Default constructor
+
+
+	Ray(glm::vec3 source, glm::vec3 direction)
+	{
+		p0 = source;
+		dir = glm::normalize(direction);
+	}
+
+	void closestPt(std::vector<SceneObject*>& sceneObjects);
+
+	//As above, but only tests the objects whose indices (ascending) are listed
+	void closestPt(std::vector<SceneObject*>& sceneObjects, const int* candidates, int count);
+
+	//True if any object is hit at a distance 0 < t < maxDist
+	bool occluded(std::vector<SceneObject*>& sceneObjects, float maxDist);
+
+};
+#endif
@@ -0,0 +1,90 @@
+/*----------------------------------------------------------
+* COSC363  Ray Tracer
+*
+*  The ray query class
+-------------------------------------------------------------*/
+
+#include "RayQuery.h"
+#include "ParallelFor.h"
+#include <algorithm>
+
+const float RayQuery::NO_LIMIT = 1.e+6;    //The farthest hit Scene::closestPt() reports
+
+namespace
+{
+    Ray batchRay(const RayBatch& rays, int k)
+    {
+        return Ray(glm::vec3(rays.originX[k], rays.originY[k], rays.originZ[k]),
+                   glm::vec3(rays.dirX[k], rays.dirY[k], rays.dirZ[k]));
+    }
+}
+
+RayQuery::RayQuery(Scene& scene)
+    : scene_(scene)
+{
+}
+
+void RayQuery::setThreadCount(int threads)
+{
+    threadCount_ = threads;
+}
+
+void RayQuery::setChunkSize(int rays)
+{
+    chunkSize_ = std::max(1, rays);
+}
+
+void RayQuery::intersect(const RayBatch& rays, HitBatch& hits)
+{
+    int chunks = (rays.count + chunkSize_ - 1) / chunkSize_;
+    parallelFor(chunks, threadCount_, [&](int chunk)
+    {
+        int end = std::min(rays.count, (chunk + 1) * chunkSize_);
+        for(int k = chunk * chunkSize_; k < end; k++)
+        {
+            Ray ray = batchRay(rays, k);
+            scene_.closestPt(ray);
+            if(ray.index >= 0 && rays.maxDistance != NULL && ray.dist >= rays.maxDistance[k])
+            {
+                ray.index = -1;
+            }
+
+            glm::vec3 n(0);
+            glm::vec2 uv(0);
+            if(ray.index >= 0)
+            {
+                SceneObject* obj = scene_.objects[ray.index];
+                if(hits.normalX != NULL || hits.normalY != NULL || hits.normalZ != NULL)
+                {
+                    n = glm::normalize(obj->normal(ray.hit, ray.part));
+                }
+                if(hits.u != NULL || hits.v != NULL)
+                {
+                    uv = obj->textureCoords(ray.hit, ray.part);
+                }
+            }
+            hits.distance[k] = ray.index >= 0 ? ray.dist : -1;
+            hits.object[k] = ray.index;
+            if(hits.normalX != NULL) hits.normalX[k] = n.x;
+            if(hits.normalY != NULL) hits.normalY[k] = n.y;
+            if(hits.normalZ != NULL) hits.normalZ[k] = n.z;
+            if(hits.u != NULL) hits.u[k] = uv.x;
+            if(hits.v != NULL) hits.v[k] = uv.y;
+        }
+    });
+}
+
+void RayQuery::occluded(const RayBatch& rays, unsigned char* occluded)
+{
+    int chunks = (rays.count + chunkSize_ - 1) / chunkSize_;
+    parallelFor(chunks, threadCount_, [&](int chunk)
+    {
+        int end = std::min(rays.count, (chunk + 1) * chunkSize_);
+        for(int k = chunk * chunkSize_; k < end; k++)
+        {
+            Ray ray = batchRay(rays, k);
+            float maxDistance = rays.maxDistance != NULL ? std::min(rays.maxDistance[k], NO_LIMIT) : NO_LIMIT;
+            occluded[k] = scene_.occluded(ray, maxDistance) ? 1 : 0;
+        }
+    });
+}
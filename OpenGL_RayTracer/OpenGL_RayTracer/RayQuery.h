@@ -0,0 +1,75 @@
+/*----------------------------------------------------------
+* COSC363  Ray Tracer
+*
+*  The ray query class
+*  Answers batches of ray queries against a built scene, for
+*  tools that need the ray tracer's geometry but not its
+*  renderer (lightmap baking, collision, visibility). Rays and
+*  results are passed as one array per component (structure
+*  of arrays), and a batch is split into chunks that are
+*  traced on several threads. intersect() finds each ray's
+*  closest hit with the same rules as Scene::closestPt();
+*  occluded() only asks whether anything is hit before a
+*  given distance and stops at the first hit it finds.
+-------------------------------------------------------------*/
+
+#ifndef H_RAY_QUERY
+#define H_RAY_QUERY
+
+#include "Scene.h"
+
+//Rays k = 0 ... count - 1; directions must not be zero but need not be unit length
+struct RayBatch
+{
+    int count = 0;
+    const float* originX = NULL;
+    const float* originY = NULL;
+    const float* originZ = NULL;
+    const float* dirX = NULL;
+    const float* dirY = NULL;
+    const float* dirZ = NULL;
+    const float* maxDistance = NULL;    //Optional: hits at or beyond it are ignored; NULL: no limit
+};
+
+//Results of RayBatch::count rays; any array except distance and object may be NULL to skip it
+struct HitBatch
+{
+    float* distance = NULL;     //Along the normalised direction, -1 if nothing is hit
+    int* object = NULL;         //Index into the scene's objects, -1 if nothing is hit
+    float* normalX = NULL;      //The object's unit normal at the hit (not turned towards the ray), 0 if no hit
+    float* normalY = NULL;
+    float* normalZ = NULL;
+    float* u = NULL;            //The object's textureCoords() at the hit, 0 if no hit
+    float* v = NULL;
+};
+
+class RayQuery
+{
+private:
+    Scene& scene_;
+    int threadCount_ = 0;
+    int chunkSize_ = DEFAULT_CHUNK_SIZE;
+
+    RayQuery(const RayQuery&);
+    RayQuery& operator=(const RayQuery&);
+
+public:
+    static const int DEFAULT_CHUNK_SIZE = 256;
+    static const float NO_LIMIT;
+
+    //The scene must be built and must not change while queries run
+    explicit RayQuery(Scene& scene);
+
+    //0: one thread per hardware thread
+    void setThreadCount(int threads);
+
+    //Rays a thread takes at a time
+    void setChunkSize(int rays);
+
+    void intersect(const RayBatch& rays, HitBatch& hits);
+
+    //occluded[k] = 1 if ray k hits anything closer than its maximum distance, 0 otherwise
+    void occluded(const RayBatch& rays, unsigned char* occluded);
+};
+
+#endif //!H_RAY_QUERY
@@ -0,0 +1,215 @@
+/*----------------------------------------------------------
+* COSC363  Ray Tracer
+*
+*  The regression suite class
+-------------------------------------------------------------*/
+
+#include "RegressionSuite.h"
+#include "PPMStripWriter.h"
+#include "ParallelFor.h"
+#include <iostream>
+#include <fstream>
+#include <map>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <chrono>
+using namespace std;
+
+namespace
+{
+    const char* BASELINE_FILE = "baseline.txt";
+
+    bool loadBaseline(const string& filename, map<string, double>& seconds)
+    {
+        ifstream file(filename.c_str());
+        if(!file) return false;
+
+        string line;
+        while(getline(file, line))
+        {
+            if(line.empty() || line[0] == '#') continue;
+            char name[128];
+            double time;
+            if(sscanf(line.c_str(), "%127s %lf", name, &time) == 2)
+            {
+                seconds[name] = time;
+            }
+        }
+        return true;
+    }
+}
+
+RegressionSuite::RegressionSuite(const string& directory)
+    : directory_(directory)
+{
+}
+
+void RegressionSuite::add(const RegressionCase& test)
+{
+    cases_.push_back(test);
+}
+
+void RegressionSuite::setImageThresholds(double minPSNR, int maxError)
+{
+    minPSNR_ = minPSNR;
+    maxError_ = maxError;
+}
+
+void RegressionSuite::setTimeTolerance(double tolerance)
+{
+    timeTolerance_ = tolerance;
+}
+
+void RegressionSuite::setRuns(int runs)
+{
+    runs_ = max(1, runs);
+}
+
+void RegressionSuite::setThreadCount(int threads)
+{
+    threadCount_ = threads;
+}
+
+double RegressionSuite::render(RegressionCase& test, vector<unsigned char>& rgb)
+{
+    test.setup();
+    rgb.assign((size_t)test.width * test.height * 3, 0);
+
+    double best = INFINITY;
+    for(int run = 0; run < runs_; run++)
+    {
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        parallelFor(test.height, threadCount_, [&](int row)
+        {
+            StreamingRenderer::renderRows(test.pixel, test.width, test.height, row, 1, &rgb[(size_t)row * test.width * 3]);
+        });
+        chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+        best = min(best, elapsed.count());
+    }
+    return best;
+}
+
+/**
+* Every case is rendered and reported even after a failure, so one run
+* shows all the regressions at once.
+*/
+bool RegressionSuite::run()
+{
+    map<string, double> baseline;
+    if(!loadBaseline(directory_ + "/" + BASELINE_FILE, baseline))
+    {
+        cerr << "*** No " << BASELINE_FILE << " in " << directory_ << "; render times are not checked" << endl;
+    }
+
+    int failures = 0;
+    for(uint c = 0; c < cases_.size(); c++)
+    {
+        RegressionCase& test = cases_[c];
+        vector<unsigned char> rgb;
+        double seconds = render(test, rgb);
+        double raysPerSecond = (double)test.width * test.height * test.samples * test.samples / seconds;
+
+        bool passed = true;
+        int width, height;
+        vector<unsigned char> golden;
+        if(!loadPPM(directory_ + "/" + test.name + ".ppm", width, height, golden))
+        {
+            passed = false;
+        }
+        else if(width != test.width || height != test.height)
+        {
+            cerr << "*** " << test.name << ": golden image is " << width << "x" << height << endl;
+            passed = false;
+        }
+
+        double psnr = 0;
+        int maxError = 0;
+        if(passed)
+        {
+            double sum = 0;
+            for(size_t k = 0; k < rgb.size(); k++)
+            {
+                int error = abs((int)rgb[k] - (int)golden[k]);
+                maxError = max(maxError, error);
+                sum += error * error;
+            }
+            double mse = sum / (rgb.size() * 255.0 * 255.0);
+            psnr = mse > 0 ? 10.0 * log10(1.0 / mse) : INFINITY;
+            passed = psnr >= minPSNR_ && maxError <= maxError_;
+        }
+
+        double baselineSeconds = baseline.count(test.name) ? baseline[test.name] : 0;
+        bool slow = baselineSeconds > 0 && seconds > baselineSeconds * (1.0 + timeTolerance_);
+
+        printf("%-14s PSNR %6.2f dB  max error %3d  %8.4f s (baseline %8.4f s)  %7.3f Mrays/s  %s\n",
+               test.name.c_str(), psnr, maxError, seconds, baselineSeconds, raysPerSecond * 1.e-6,
+               !passed ? "IMAGE CHANGED" : slow ? "SLOWER" : "ok");
+
+        if(!passed || slow)
+        {
+            failures++;
+        }
+    }
+
+    printf("%d of %d cases passed\n", (int)cases_.size() - failures, (int)cases_.size());
+    return failures == 0;
+}
+
+bool RegressionSuite::update()
+{
+    string baselineName = directory_ + "/" + BASELINE_FILE;
+    ofstream baseline(baselineName.c_str());
+    if(!baseline)
+    {
+        cerr << "*** Could not write " << baselineName << endl;
+        return false;
+    }
+    baseline << "# case  best render time (s)" << endl;
+
+    for(uint c = 0; c < cases_.size(); c++)
+    {
+        RegressionCase& test = cases_[c];
+        vector<unsigned char> rgb;
+        double seconds = render(test, rgb);
+        if(!savePPM(directory_ + "/" + test.name + ".ppm", test.width, test.height, rgb))
+        {
+            return false;
+        }
+        baseline << test.name << " " << seconds << endl;
+        printf("%-14s %8.4f s  stored\n", test.name.c_str(), seconds);
+    }
+    return true;
+}
+
+bool RegressionSuite::loadPPM(const string& filename, int& width, int& height, vector<unsigned char>& rgb)
+{
+    FILE* file = fopen(filename.c_str(), "rb");
+    if(file == NULL)
+    {
+        cerr << "*** Could not open " << filename << endl;
+        return false;
+    }
+
+    int maxValue = 0;
+    bool loaded = fscanf(file, "P6 %d %d %d", &width, &height, &maxValue) == 3 && maxValue == 255
+                  && width > 0 && height > 0 && fgetc(file) != EOF;
+    if(loaded)
+    {
+        rgb.resize((size_t)width * height * 3);
+        loaded = fread(rgb.data(), 1, rgb.size(), file) == rgb.size();
+    }
+    fclose(file);
+
+    if(!loaded)
+    {
+        cerr << "*** " << filename << " is not an 8-bit binary PPM image" << endl;
+    }
+    return loaded;
+}
+
+bool RegressionSuite::savePPM(const string& filename, int width, int height, const vector<unsigned char>& rgb)
+{
+    PPMStripWriter writer;
+    return writer.open(filename.c_str(), width, height) && writer.writeRows(rgb.data(), height) && writer.close();
+}
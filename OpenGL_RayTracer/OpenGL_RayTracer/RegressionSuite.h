@@ -0,0 +1,68 @@
+/*----------------------------------------------------------
+* COSC363  Ray Tracer
+*
+*  The regression suite class
+*  Renders a set of reference scenes headlessly and checks
+*  each against a stored golden image (PSNR and largest
+*  channel error) and its render time against a stored
+*  baseline. A directory holds one <name>.ppm per case and a
+*  baseline.txt of render times; update() rewrites both.
+-------------------------------------------------------------*/
+
+#ifndef H_REGRESSION_SUITE
+#define H_REGRESSION_SUITE
+
+#include <string>
+#include <vector>
+#include <functional>
+#include "StreamingRenderer.h"
+
+struct RegressionCase
+{
+    std::string name;
+    int width;
+    int height;
+    int samples;                    //sub-samples per pixel along each axis (for the ray count)
+    std::function<void()> setup;    //loads the case's scene
+    PixelFunction pixel;
+};
+
+class RegressionSuite
+{
+private:
+    std::string directory_;
+    std::vector<RegressionCase> cases_;
+    double minPSNR_ = 40.0;
+    int maxError_ = 16;
+    double timeTolerance_ = 0.25;
+    int runs_ = 3;
+    int threadCount_ = 0;
+
+    //Best time of runs_ renders; 'rgb' receives the image, top row first
+    double render(RegressionCase& test, std::vector<unsigned char>& rgb);
+
+public:
+    RegressionSuite(const std::string& directory);
+
+    void add(const RegressionCase& test);
+
+    //Images pass if their PSNR is at least minPSNR dB and no channel is off by more than maxError
+    void setImageThresholds(double minPSNR, int maxError);
+
+    //Times fail if slower than the baseline by more than this fraction (0.25: 25%)
+    void setTimeTolerance(double tolerance);
+
+    void setRuns(int runs);
+    void setThreadCount(int threads);
+
+    //Renders every case and compares it with the stored results; true if all pass
+    bool run();
+
+    //Renders every case and stores the images and times as the new reference
+    bool update();
+
+    static bool loadPPM(const std::string& filename, int& width, int& height, std::vector<unsigned char>& rgb);
+    static bool savePPM(const std::string& filename, int width, int height, const std::vector<unsigned char>& rgb);
+};
+
+#endif //!H_REGRESSION_SUITE
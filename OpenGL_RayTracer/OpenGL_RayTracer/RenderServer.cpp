@@ -0,0 +1,374 @@
+/*----------------------------------------------------------
+* COSC363  Ray Tracer
+*
+*  The render server class
+-------------------------------------------------------------*/
+
+#include "RenderServer.h"
+#include "PPMStripWriter.h"
+#include "StreamingRenderer.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <errno.h>
+#include <iostream>
+#include <sstream>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+struct RenderServer::Job
+{
+    int id;
+    std::string scene;
+    int width;
+    int height;
+    int samples;
+    std::string output;
+    ReplyFunction reply;
+
+    std::shared_ptr<Scene> resident;
+    Camera camera;
+    bool cacheHit;
+    double sceneSeconds;
+
+    std::vector<unsigned char> rgb;
+    int bandCount;
+    int nextBand = 0;
+    int bandsDone = 0;
+    bool started = false;
+    std::chrono::steady_clock::time_point submitted;
+    std::chrono::steady_clock::time_point firstBand;
+};
+
+namespace
+{
+    double millisecondsBetween(std::chrono::steady_clock::time_point from, std::chrono::steady_clock::time_point to)
+    {
+        std::chrono::duration<double, std::milli> elapsed = to - from;
+        return elapsed.count();
+    }
+
+    bool sendLine(int fd, const std::string& line)
+    {
+        std::string data = line + "\n";
+        const char* p = data.data();
+        size_t size = data.size();
+        while(size > 0)
+        {
+            ssize_t n = send(fd, p, size, MSG_NOSIGNAL);
+            if(n < 0 && errno == EINTR) continue;
+            if(n <= 0) return false;
+            p += n;
+            size -= n;
+        }
+        return true;
+    }
+}
+
+RenderServer::RenderServer(SceneCache& cache, JobPixelFunction pixel)
+    : cache_(cache), pixel_(pixel)
+{
+    threadCount_ = std::max(1, (int)std::thread::hardware_concurrency());
+}
+
+RenderServer::~RenderServer()
+{
+    stop();
+}
+
+void RenderServer::setThreadCount(int threads)
+{
+    threadCount_ = std::max(1, threads);
+}
+
+void RenderServer::setBandRows(int rows)
+{
+    bandRows_ = std::max(1, rows);
+}
+
+void RenderServer::start()
+{
+    stopping_ = false;
+    for(int t = 0; t < threadCount_; t++)
+    {
+        workers_.push_back(std::thread(&RenderServer::work, this));
+    }
+}
+
+/**
+* Jobs are parsed and their scenes fetched from the cache on the caller's
+* thread, so a scene build delays only the client that asked for it.
+*/
+bool RenderServer::submit(const std::string& line, ReplyFunction reply)
+{
+    std::istringstream in(line);
+    std::string command;
+    if(!(in >> command)) return true;
+    if(command == "quit") return false;
+    if(command != "render")
+    {
+        reply("error: unknown command '" + command + "'");
+        return true;
+    }
+
+    std::shared_ptr<Job> job = std::make_shared<Job>();
+    std::string size;
+    glm::vec3 eye, target;
+    if(!(in >> job->scene >> size >> job->samples >> job->output)
+       || sscanf(size.c_str(), "%dx%d", &job->width, &job->height) != 2
+       || job->width <= 0 || job->height <= 0 || job->samples <= 0)
+    {
+        reply("error: expected render <scene> <width>x<height> <samples> <output.ppm> [<eye x y z> <target x y z>]");
+        return true;
+    }
+    bool hasView = (bool)(in >> eye.x >> eye.y >> eye.z >> target.x >> target.y >> target.z);
+
+    job->submitted = std::chrono::steady_clock::now();
+    job->resident = cache_.get(job->scene, job->cacheHit);
+    job->sceneSeconds = millisecondsBetween(job->submitted, std::chrono::steady_clock::now()) / 1000.0;
+    if(!job->resident)
+    {
+        reply("error: unknown scene '" + job->scene + "'");
+        return true;
+    }
+
+    job->camera = job->resident->camera;
+    if(hasView)
+    {
+        job->camera.lookAt(eye, target);
+    }
+    job->reply = reply;
+    job->rgb.assign((size_t)job->width * job->height * 3, 0);
+    job->bandCount = (job->height + bandRows_ - 1) / bandRows_;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        job->id = ++jobCount_;
+        active_.push_back(job);
+    }
+    changed_.notify_all();
+
+    std::ostringstream queued;
+    queued << "job " << job->id << " queued";
+    reply(queued.str());
+    return true;
+}
+
+/**
+* Each thread takes one band at a time, from the active jobs in turn, so
+* every job advances at the same rate whatever its size.
+*/
+void RenderServer::work()
+{
+    while(true)
+    {
+        std::shared_ptr<Job> job;
+        int band = -1;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            while(true)
+            {
+                for(size_t n = 0; n < active_.size() && band < 0; n++)
+                {
+                    size_t k = (nextJob_ + n) % active_.size();
+                    if(active_[k]->nextBand < active_[k]->bandCount)
+                    {
+                        job = active_[k];
+                        band = job->nextBand++;
+                        nextJob_ = k + 1;
+                    }
+                }
+                if(band >= 0 || (stopping_ && active_.empty())) break;
+                changed_.wait(lock);
+            }
+            if(band < 0) return;
+            if(!job->started)
+            {
+                job->started = true;
+                job->firstBand = std::chrono::steady_clock::now();
+            }
+        }
+
+        int firstRow = band * bandRows_;
+        int rows = std::min(bandRows_, job->height - firstRow);
+        Job* current = job.get();
+        PixelFunction pixel = [this, current](int i, int j)
+        {
+            return pixel_(*current->resident, current->camera, i, j, current->width, current->height, current->samples);
+        };
+        StreamingRenderer::renderRows(pixel, job->width, job->height, firstRow, rows, &job->rgb[(size_t)firstRow * job->width * 3]);
+
+        bool done = false;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if(++job->bandsDone == job->bandCount)
+            {
+                active_.erase(std::find(active_.begin(), active_.end(), job));
+                done = true;
+            }
+        }
+        if(done)
+        {
+            finish(*job);
+            changed_.notify_all();
+        }
+    }
+}
+
+void RenderServer::finish(Job& job)
+{
+    std::chrono::steady_clock::time_point rendered = std::chrono::steady_clock::now();
+    PPMStripWriter writer;
+    bool written = writer.open(job.output.c_str(), job.width, job.height)
+                   && writer.writeRows(job.rgb.data(), job.height) && writer.close();
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+
+    double renderMs = millisecondsBetween(job.firstBand, rendered);
+    double rays = (double)job.width * job.height * job.samples * job.samples;
+    char report[512];
+    snprintf(report, sizeof(report),
+             "job %d %s: %s %dx%d %d spp -> %s; scene %s %.1f ms, queued %.1f ms, rendered %.1f ms, "
+             "latency %.1f ms, %.3f Mrays/s",
+             job.id, written ? "done" : "failed", job.scene.c_str(), job.width, job.height, job.samples * job.samples,
+             job.output.c_str(), job.cacheHit ? "cached" : "built", job.sceneSeconds * 1000.0,
+             millisecondsBetween(job.submitted, job.firstBand), renderMs, millisecondsBetween(job.submitted, now),
+             renderMs > 0 ? rays / renderMs * 1.e-3 : 0.0);
+    job.reply(report);
+
+    job.rgb.clear();
+    job.rgb.shrink_to_fit();
+}
+
+void RenderServer::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    changed_.notify_all();
+    for(size_t t = 0; t < workers_.size(); t++)
+    {
+        workers_[t].join();
+    }
+    workers_.clear();
+}
+
+void RenderServer::serveStream()
+{
+    std::mutex outputMutex;
+    ReplyFunction reply = [&outputMutex](const std::string& line)
+    {
+        std::lock_guard<std::mutex> lock(outputMutex);
+        std::cout << line << std::endl;
+    };
+
+    std::string line;
+    while(std::getline(std::cin, line))
+    {
+        if(!submit(line, reply)) break;
+    }
+    stop();
+}
+
+/**
+* Each client gets a thread that reads its lines. The replies of a client's
+* jobs go back over its own connection, which is closed once the client
+* has hung up and all of its jobs have been answered. On 'quit' the other
+* clients' sockets are shut down for reading, which wakes their threads.
+*/
+bool RenderServer::serveSocket(const char* path)
+{
+    sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if(strlen(path) >= sizeof(address.sun_path))
+    {
+        std::cerr << "*** Socket path too long: " << path << std::endl;
+        return false;
+    }
+    strcpy(address.sun_path, path);
+
+    int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+    unlink(path);
+    if(listener < 0 || bind(listener, (sockaddr*)&address, sizeof(address)) != 0 || listen(listener, 16) != 0)
+    {
+        std::cerr << "*** Could not listen on " << path << std::endl;
+        if(listener >= 0) close(listener);
+        return false;
+    }
+    std::cout << "Listening on " << path << std::endl;
+
+    std::atomic<bool> quit(false);
+    std::mutex readersMutex;
+    std::vector<int> readers;   //sockets whose lines are still being read, guarded by readersMutex
+    std::vector<std::thread> clients;
+    while(!quit)
+    {
+        int client = accept(listener, NULL, NULL);
+        if(client < 0)
+        {
+            if(errno == EINTR) continue;
+            break;      //The listener was shut down by 'quit'
+        }
+        {
+            std::lock_guard<std::mutex> lock(readersMutex);
+            if(quit) shutdown(client, SHUT_RD);
+            readers.push_back(client);
+        }
+
+        clients.push_back(std::thread([this, client, listener, &quit, &readersMutex, &readers]()
+        {
+            //Shared by the replies of this client's jobs; the last one closes the socket
+            std::shared_ptr<int> connection(new int(client), [](int* fd) { close(*fd); delete fd; });
+            std::shared_ptr<std::mutex> sendMutex = std::make_shared<std::mutex>();
+            ReplyFunction reply = [connection, sendMutex](const std::string& line)
+            {
+                std::lock_guard<std::mutex> lock(*sendMutex);
+                sendLine(*connection, line);
+            };
+
+            std::string pending;
+            char buffer[4096];
+            bool reading = true;
+            while(reading)
+            {
+                ssize_t n = recv(client, buffer, sizeof(buffer), 0);
+                if(n < 0 && errno == EINTR) continue;
+                if(n <= 0) break;
+                pending.append(buffer, n);
+
+                size_t end;
+                while(reading && (end = pending.find('\n')) != std::string::npos)
+                {
+                    std::string line = pending.substr(0, end);
+                    pending.erase(0, end + 1);
+                    reading = submit(line, reply);
+                }
+            }
+
+            //Leave the list before the socket can be closed, so 'quit' never shuts down a reused descriptor
+            std::lock_guard<std::mutex> lock(readersMutex);
+            readers.erase(std::find(readers.begin(), readers.end(), client));
+            if(!reading && !quit)
+            {
+                quit = true;
+                shutdown(listener, SHUT_RDWR);
+                for(size_t r = 0; r < readers.size(); r++)
+                {
+                    shutdown(readers[r], SHUT_RD);
+                }
+            }
+        }));
+    }
+
+    for(size_t c = 0; c < clients.size(); c++)
+    {
+        clients[c].join();
+    }
+    close(listener);
+    unlink(path);
+    stop();
+    return true;
+}
@@ -0,0 +1,84 @@
+/*----------------------------------------------------------
+* COSC363  Ray Tracer
+*
+*  The render server class
+*  A long-running renderer that takes jobs as text lines, one
+*  per line, from stdin or from clients of a Unix domain
+*  socket:
+*    render <scene> <width>x<height> <samples> <output.ppm>
+*           [<eye x y z> <target x y z>]
+*    quit
+*  Scenes come from a SceneCache, so repeated views of a
+*  scene skip building it. Jobs run at the same time on one
+*  pool of threads that take bands of rows from the active
+*  jobs in turn, so a small job is not stuck behind a large
+*  one. Each job is answered with a line reporting its
+*  latency and throughput.
+-------------------------------------------------------------*/
+
+#ifndef H_RENDER_SERVER
+#define H_RENDER_SERVER
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "SceneCache.h"
+
+//Colour of pixel (i, j) of a width x height image of 'scene' seen from 'camera'
+typedef std::function<glm::vec3(Scene& scene, Camera& camera, int i, int j, int width, int height, int samples)> JobPixelFunction;
+
+//Sends one line back to the client that submitted a job
+typedef std::function<void(const std::string& line)> ReplyFunction;
+
+class RenderServer
+{
+private:
+    struct Job;
+
+    SceneCache& cache_;
+    JobPixelFunction pixel_;
+    int threadCount_ = 1;
+    int bandRows_ = 16;
+
+    std::vector<std::shared_ptr<Job> > active_;  //jobs with bands left to hand out or finish
+    size_t nextJob_ = 0;                        //round-robin position in active_
+    int jobCount_ = 0;
+    bool stopping_ = false;
+    std::mutex mutex_;
+    std::condition_variable changed_;
+    std::vector<std::thread> workers_;
+
+    void work();
+    void finish(Job& job);
+
+public:
+    RenderServer(SceneCache& cache, JobPixelFunction pixel);
+    ~RenderServer();
+
+    void setThreadCount(int threads);
+    void setBandRows(int rows);
+
+    void start();
+
+    /**
+    * Handles one line of the protocol; returns false for 'quit'. A job is
+    * queued and this returns at once; its report goes to 'reply' later.
+    */
+    bool submit(const std::string& line, ReplyFunction reply);
+
+    //Waits for every queued job, then stops the threads
+    void stop();
+
+    //Serves jobs from stdin, answering on stdout, until 'quit' or end of input
+    void serveStream();
+
+    //Serves jobs from clients of a Unix domain socket at 'path' until a client sends 'quit'
+    bool serveSocket(const char* path);
+};
+
+#endif //!H_RENDER_SERVER
@@ -0,0 +1,109 @@
+/*----------------------------------------------------------
+* COSC363  Ray Tracer
+*
+*  The scene class
+-------------------------------------------------------------*/
+
+#include "Scene.h"
+#include "SceneFile.h"
+
+Scene::~Scene()
+{
+    clear();
+}
+
+void Scene::add(SceneObject* object)
+{
+    objects.push_back(object);
+}
+
+void Scene::clear()
+{
+    for(uint i = 0; i < objects.size(); i++)
+    {
+        delete objects[i];
+    }
+    objects.clear();
+    bvh_ = BVH();
+}
+
+void Scene::build()
+{
+    bvh_.build(objects);
+}
+
+bool Scene::build(const char* path)
+{
+    if(SceneFile::load(path, objects, bvh_)) return true;
+    bvh_.build(objects);
+    SceneFile::save(path, objects, bvh_);
+    return false;
+}
+
+void Scene::refit()
+{
+    bvh_.refit(objects);
+}
+
+BVH& Scene::getBVH()
+{
+    return bvh_;
+}
+
+/**
+* The copy shares nothing with this scene, but keeps the tree layout, so
+* it only needs refit() after its objects are moved.
+*/
+Scene* Scene::clone()
+{
+    Scene* copy = new Scene();
+    for(uint i = 0; i < objects.size(); i++)
+    {
+        copy->objects.push_back(objects[i]->clone());
+    }
+    copy->camera = camera;
+    copy->maxSteps = maxSteps;
+    copy->bvh_ = bvh_;
+    return copy;
+}
+
+/**
+* Objects of type 1 are never shadowed, so a scene made only of them
+* needs no shadow rays.
+*/
+unsigned Scene::features()
+{
+    unsigned mask = 0;
+    for(uint i = 0; i < objects.size(); i++)
+    {
+        SceneObject* object = objects[i];
+        if(object->isReflective()) mask |= FEATURE_REFLECTION;
+        if(object->isTransparent()) mask |= FEATURE_TRANSPARENCY;
+        if(object->isRefractive()) mask |= FEATURE_REFRACTION;
+        if(object->isSpecular()) mask |= FEATURE_SPECULAR;
+        if(object->isTextured()) mask |= FEATURE_TEXTURES;
+        if(object->type != 1) mask |= FEATURE_SHADOWS;
+    }
+    return mask;
+}
+
+void Scene::closestPt(Ray& ray)
+{
+    if(bvh_.isEmpty())
+    {
+        ray.closestPt(objects);
+    }
+    else
+    {
+        bvh_.closestPt(ray, objects);
+    }
+}
+
+bool Scene::occluded(Ray& ray, float maxDist)
+{
+    if(bvh_.isEmpty())
+    {
+        return ray.occluded(objects, maxDist);
+    }
+    return bvh_.occluded(ray, objects, maxDist);
+}
@@ -0,0 +1,80 @@
+/*----------------------------------------------------------
+* COSC363  Ray Tracer
+*
+*  The scene class
+*  Holds the scene objects together with their acceleration
+*  structure and the camera. A scene owns its objects; clone()
+*  makes an independent copy that can be moved and rendered
+*  at the same time as the original (e.g. another frame of an
+*  animation), while textures stay shared.
+-------------------------------------------------------------*/
+
+#ifndef H_SCENE
+#define H_SCENE
+
+#include <vector>
+#include "BVH.h"
+#include "Camera.h"
+#include "Ray.h"
+#include "SceneObject.h"
+
+//Shading features a scene can use; renderers specialise on the combination in use
+enum SceneFeature
+{
+    FEATURE_REFLECTION   = 1 << 0,
+    FEATURE_TRANSPARENCY = 1 << 1,
+    FEATURE_REFRACTION   = 1 << 2,
+    FEATURE_SPECULAR     = 1 << 3,
+    FEATURE_TEXTURES     = 1 << 4,
+    FEATURE_SHADOWS      = 1 << 5,
+    FEATURE_ALL          = (1 << 6) - 1
+};
+
+class Scene
+{
+private:
+    BVH bvh_;
+
+    Scene(const Scene&);
+    Scene& operator=(const Scene&);
+
+public:
+    std::vector<SceneObject*> objects;
+    Camera camera;
+    int maxSteps = 5;   //recursion limit of trace() the scene is meant to be rendered with
+
+    Scene() {}
+    ~Scene();
+
+    void add(SceneObject* object);
+    void clear();
+
+    //Builds the acceleration structure; call once all objects are added
+    void build();
+
+    /**
+    * Same as build(), but maps the tree from the scene file 'path' if that
+    * was saved for these same objects, and builds and saves it otherwise.
+    * True if the tree was mapped.
+    */
+    bool build(const char* path);
+
+    //Updates the acceleration structure after objects have moved
+    void refit();
+
+    //The acceleration structure, for walking its boxes; empty until built
+    BVH& getBVH();
+
+    Scene* clone();
+
+    //Mask of the SceneFeature values used by at least one object
+    unsigned features();
+
+    //Closest intersection of the ray with the scene objects (see Ray::closestPt)
+    void closestPt(Ray& ray);
+
+    //True if the ray hits any object at a distance 0 < t < maxDist (see Ray::occluded)
+    bool occluded(Ray& ray, float maxDist);
+};
+
+#endif //!H_SCENE
@@ -0,0 +1,97 @@
+/*----------------------------------------------------------
+* COSC363  Ray Tracer
+*
+*  The scene cache class
+-------------------------------------------------------------*/
+
+#include "SceneCache.h"
+
+SceneCache::SceneCache(SceneBuilder builder, size_t capacity)
+    : builder_(builder), capacity_(capacity > 0 ? capacity : 1)
+{
+}
+
+uint64_t SceneCache::hash(const std::string& description)
+{
+    uint64_t h = 14695981039346656037ULL;
+    for(size_t k = 0; k < description.size(); k++)
+    {
+        h ^= (unsigned char)description[k];
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+/**
+* A miss enters the scene as a future before building it, with the cache
+* unlocked; callers that ask for the same scene meanwhile find the entry
+* and wait on it, so two jobs that miss on a scene at once build it only
+* once. An entry whose build fails is removed again.
+*/
+std::shared_ptr<Scene> SceneCache::get(const std::string& description, bool& hit)
+{
+    uint64_t key = hash(description);
+    hit = false;
+    std::promise<std::shared_ptr<Scene> > built;
+    std::shared_future<std::shared_ptr<Scene> > scene;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for(std::list<Entry>::iterator it = entries_.begin(); it != entries_.end(); ++it)
+        {
+            if(it->key == key && it->description == description)
+            {
+                entries_.splice(entries_.begin(), entries_, it);
+                hits_++;
+                hit = true;
+                scene = entries_.front().scene;
+                break;
+            }
+        }
+        if(!hit)
+        {
+            misses_++;
+            Entry entry;
+            entry.key = key;
+            entry.description = description;
+            entry.scene = scene = built.get_future().share();
+            entries_.push_front(entry);
+            while(entries_.size() > capacity_)
+            {
+                entries_.pop_back();
+            }
+        }
+    }
+    if(hit)
+    {
+        return scene.get();
+    }
+
+    std::shared_ptr<Scene> result = std::make_shared<Scene>();
+    if(!builder_(*result, description))
+    {
+        result.reset();
+        std::lock_guard<std::mutex> lock(mutex_);
+        for(std::list<Entry>::iterator it = entries_.begin(); it != entries_.end(); ++it)
+        {
+            if(it->key == key && it->description == description)
+            {
+                entries_.erase(it);
+                break;
+            }
+        }
+    }
+    built.set_value(result);
+    return result;
+}
+
+int SceneCache::getHits()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return hits_;
+}
+
+int SceneCache::getMisses()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return misses_;
+}
@@ -0,0 +1,63 @@
+/*----------------------------------------------------------
+* COSC363  Ray Tracer
+*
+*  The scene cache class
+*  Keeps built scenes (objects and acceleration structure)
+*  resident between renders, keyed by the scene's description,
+*  and evicts the least recently used scene once more than
+*  'capacity' are held. Scenes are shared, so one that is
+*  evicted while a render uses it lives on until that render
+*  finishes. A scene is built outside the cache's lock, so a
+*  slow build only holds up the callers asking for that scene.
+-------------------------------------------------------------*/
+
+#ifndef H_SCENE_CACHE
+#define H_SCENE_CACHE
+
+#include <functional>
+#include <future>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <stdint.h>
+#include "Scene.h"
+
+//Builds the scene a description names into an empty scene; false if it names none
+typedef std::function<bool(Scene& scene, const std::string& description)> SceneBuilder;
+
+class SceneCache
+{
+private:
+    struct Entry
+    {
+        uint64_t key;               //hash(description), to skip most string comparisons
+        std::string description;
+        std::shared_future<std::shared_ptr<Scene> > scene;     //ready once built; NULL if the build failed
+    };
+
+    SceneBuilder builder_;
+    size_t capacity_;
+    std::list<Entry> entries_;  //most recently used first
+    std::mutex mutex_;
+    int hits_ = 0;
+    int misses_ = 0;
+
+public:
+    SceneCache(SceneBuilder builder, size_t capacity = 4);
+
+    //64-bit FNV-1a hash of the description
+    static uint64_t hash(const std::string& description);
+
+    /**
+    * The built scene for 'description', building it on a miss (NULL if the
+    * builder fails). 'hit' tells whether it was resident or being built by
+    * another caller, whose build this one then waits for.
+    */
+    std::shared_ptr<Scene> get(const std::string& description, bool& hit);
+
+    int getHits();
+    int getMisses();
+};
+
+#endif //!H_SCENE_CACHE
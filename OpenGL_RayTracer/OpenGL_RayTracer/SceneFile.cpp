@@ -0,0 +1,243 @@
+/*----------------------------------------------------------
+* COSC363  Ray Tracer
+*
+*  The scene file class
+-------------------------------------------------------------*/
+
+#include "SceneFile.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+
+namespace
+{
+    const char SCENE_FILE_MAGIC[4] = {'R', 'T', 'S', 'C'};
+    const uint32_t BYTE_ORDER_MARK = 0x01020304;
+    const uint64_t SECTION_ALIGNMENT = 16;
+    const int MAX_TREE_DEPTH = BVH::STACK_SIZE - 4;  //deepest inner node whose children still fit on BVH's traversal stack
+
+    enum MaterialFlag
+    {
+        MATERIAL_REFLECTIVE  = 1 << 0,
+        MATERIAL_REFRACTIVE  = 1 << 1,
+        MATERIAL_SPECULAR    = 1 << 2,
+        MATERIAL_TRANSPARENT = 1 << 3,
+        MATERIAL_TEXTURED    = 1 << 4
+    };
+
+    struct MaterialLess
+    {
+        bool operator()(const MaterialRecord& a, const MaterialRecord& b) const
+        {
+            return memcmp(&a, &b, sizeof(MaterialRecord)) < 0;
+        }
+    };
+
+    uint64_t align(uint64_t offset)
+    {
+        return (offset + SECTION_ALIGNMENT - 1) / SECTION_ALIGNMENT * SECTION_ALIGNMENT;
+    }
+
+    //True if 'count' items of 'size' bytes at 'offset' are aligned and inside the file
+    bool validSection(const SceneFileHeader& header, uint64_t offset, uint64_t count, uint64_t size)
+    {
+        return offset % SECTION_ALIGNMENT == 0 && offset >= sizeof(SceneFileHeader)
+               && offset <= header.fileSize && count * size <= header.fileSize - offset;
+    }
+
+    void writeSection(ofstream& file, uint64_t offset, const void* data, uint64_t size)
+    {
+        static const char padding[SECTION_ALIGNMENT] = {0};
+        file.write(padding, offset - (uint64_t)file.tellp());
+        file.write((const char*)data, size);
+    }
+}
+
+MaterialRecord SceneFile::material(SceneObject* object)
+{
+    MaterialRecord record;
+    memset(&record, 0, sizeof(record));
+    glm::vec3 color = object->getColor();
+    record.color[0] = color.r;
+    record.color[1] = color.g;
+    record.color[2] = color.b;
+    if(object->isReflective()) record.flags |= MATERIAL_REFLECTIVE;
+    if(object->isRefractive()) record.flags |= MATERIAL_REFRACTIVE;
+    if(object->isSpecular()) record.flags |= MATERIAL_SPECULAR;
+    if(object->isTransparent()) record.flags |= MATERIAL_TRANSPARENT;
+    if(object->isTextured()) record.flags |= MATERIAL_TEXTURED;
+    record.reflectionCoeff = object->getReflectionCoeff();
+    record.refractionCoeff = object->getRefractionCoeff();
+    record.transparencyCoeff = object->getTransparencyCoeff();
+    record.refractiveIndex = object->getRefractiveIndex();
+    record.shininess = object->getShininess();
+    record.type = object->type;
+    return record;
+}
+
+/**
+* The temporary file is made by mkstemp() next to 'path', so that saves of
+* the same file from several threads or processes never write to one
+* another's temporary, and the rename stays within one file system.
+*/
+bool SceneFile::save(const char* path, std::vector<SceneObject*>& objects, BVH& bvh)
+{
+    uint32_t n = objects.size();
+    vector<int32_t> kinds(n);
+    vector<int32_t> materials(n);
+    vector<float> params((size_t)n * SHAPE_PARAMS);
+    vector<MaterialRecord> table;
+    map<MaterialRecord, int32_t, MaterialLess> tableIndex;
+    for(uint32_t i = 0; i < n; i++)
+    {
+        kinds[i] = objects[i]->getShape(&params[(size_t)i * SHAPE_PARAMS]);
+        MaterialRecord record = material(objects[i]);
+        map<MaterialRecord, int32_t, MaterialLess>::iterator found = tableIndex.find(record);
+        if(found == tableIndex.end())
+        {
+            found = tableIndex.insert(make_pair(record, (int32_t)table.size())).first;
+            table.push_back(record);
+        }
+        materials[i] = found->second;
+    }
+
+    SceneFileHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, SCENE_FILE_MAGIC, 4);
+    header.version = VERSION;
+    header.byteOrder = BYTE_ORDER_MARK;
+    header.nodeSize = sizeof(BVHNode);
+    header.shapeParams = SHAPE_PARAMS;
+    header.objectCount = n;
+    header.materialCount = table.size();
+    header.nodeCount = bvh.getNodeCount();
+    header.kindsOffset = align(sizeof(header));
+    header.materialsOffset = align(header.kindsOffset + n * sizeof(int32_t));
+    header.paramsOffset = align(header.materialsOffset + n * sizeof(int32_t));
+    header.tableOffset = align(header.paramsOffset + params.size() * sizeof(float));
+    header.nodesOffset = align(header.tableOffset + table.size() * sizeof(MaterialRecord));
+    header.indicesOffset = align(header.nodesOffset + (uint64_t)header.nodeCount * sizeof(BVHNode));
+    header.fileSize = header.indicesOffset + n * sizeof(int32_t);
+
+    string temporary = string(path) + ".XXXXXX";
+    int fd = mkstemp(&temporary[0]);
+    if(fd < 0)
+    {
+        cerr << "*** Error writing scene file: " << temporary << endl;
+        return false;
+    }
+    fchmod(fd, 0644);   //mkstemp() makes the file private to its owner
+    close(fd);
+    ofstream file(temporary.c_str(), ios::out | ios::binary);
+    if(!file)
+    {
+        cerr << "*** Error writing scene file: " << temporary << endl;
+        unlink(temporary.c_str());
+        return false;
+    }
+    file.write((const char*)&header, sizeof(header));
+    writeSection(file, header.kindsOffset, kinds.data(), n * sizeof(int32_t));
+    writeSection(file, header.materialsOffset, materials.data(), n * sizeof(int32_t));
+    writeSection(file, header.paramsOffset, params.data(), params.size() * sizeof(float));
+    writeSection(file, header.tableOffset, table.data(), table.size() * sizeof(MaterialRecord));
+    writeSection(file, header.nodesOffset, bvh.getNodes(), (uint64_t)header.nodeCount * sizeof(BVHNode));
+    writeSection(file, header.indicesOffset, bvh.getObjectIndices(), n * sizeof(int32_t));
+    file.close();
+    if(!file || rename(temporary.c_str(), path) != 0)
+    {
+        cerr << "*** Error writing scene file: " << path << endl;
+        unlink(temporary.c_str());
+        return false;
+    }
+    return true;
+}
+
+/**
+* The header, section bounds and every BVH link are checked before the
+* tree is adopted, so a damaged file is rejected rather than traversed.
+*/
+bool SceneFile::load(const char* path, std::vector<SceneObject*>& objects, BVH& bvh)
+{
+    int fd = open(path, O_RDONLY);
+    if(fd < 0) return false;
+    struct stat info;
+    if(fstat(fd, &info) != 0 || (uint64_t)info.st_size < sizeof(SceneFileHeader))
+    {
+        close(fd);
+        return false;
+    }
+    size_t size = info.st_size;
+    void* base = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if(base == MAP_FAILED) return false;
+    shared_ptr<const void> mapping(base, [size](const void* p) { munmap((void*)p, size); });
+
+    const char* bytes = (const char*)base;
+    const SceneFileHeader& header = *(const SceneFileHeader*)bytes;
+    uint32_t n = objects.size();
+    if(memcmp(header.magic, SCENE_FILE_MAGIC, 4) != 0 || header.version != VERSION || header.byteOrder != BYTE_ORDER_MARK
+       || header.nodeSize != sizeof(BVHNode) || header.shapeParams != SHAPE_PARAMS || header.fileSize != size
+       || header.objectCount != n || header.nodeCount == 0
+       || !validSection(header, header.kindsOffset, n, sizeof(int32_t))
+       || !validSection(header, header.materialsOffset, n, sizeof(int32_t))
+       || !validSection(header, header.paramsOffset, (uint64_t)n * SHAPE_PARAMS, sizeof(float))
+       || !validSection(header, header.tableOffset, header.materialCount, sizeof(MaterialRecord))
+       || !validSection(header, header.nodesOffset, header.nodeCount, sizeof(BVHNode))
+       || !validSection(header, header.indicesOffset, n, sizeof(int32_t)))
+    {
+        return false;
+    }
+
+    const int32_t* kinds = (const int32_t*)(bytes + header.kindsOffset);
+    const int32_t* materials = (const int32_t*)(bytes + header.materialsOffset);
+    const float* params = (const float*)(bytes + header.paramsOffset);
+    const MaterialRecord* table = (const MaterialRecord*)(bytes + header.tableOffset);
+    float shape[SHAPE_PARAMS];
+    for(uint32_t i = 0; i < n; i++)
+    {
+        if(objects[i]->getShape(shape) != kinds[i] || memcmp(shape, params + (size_t)i * SHAPE_PARAMS, sizeof(shape)) != 0
+           || materials[i] < 0 || (uint32_t)materials[i] >= header.materialCount)
+        {
+            return false;
+        }
+        MaterialRecord record = material(objects[i]);
+        if(memcmp(&record, &table[materials[i]], sizeof(record)) != 0) return false;
+    }
+
+    const BVHNode* nodes = (const BVHNode*)(bytes + header.nodesOffset);
+    const int32_t* indices = (const int32_t*)(bytes + header.indicesOffset);
+    for(uint32_t k = 0; k < n; k++)
+    {
+        if(indices[k] < 0 || (uint32_t)indices[k] >= n) return false;
+    }
+    //Children come after their parents, so one pass finds every node's depth; a node linked from several
+    //parents (only in a damaged file) takes the deepest, so no path can outgrow the traversal stack
+    vector<unsigned char> depth(header.nodeCount, 0);
+    for(uint32_t m = 0; m < header.nodeCount; m++)
+    {
+        const BVHNode& node = nodes[m];
+        bool leafOk = node.count > 0 && node.first >= 0 && (uint32_t)node.first + node.count <= n;
+        bool innerOk = node.count == 0 && (uint32_t)node.first > m + 1 && (uint32_t)node.first < header.nodeCount
+                       && depth[m] < MAX_TREE_DEPTH;
+        if(!leafOk && !innerOk) return false;
+        if(innerOk)
+        {
+            depth[m + 1] = max(depth[m + 1], (unsigned char)(depth[m] + 1));
+            depth[node.first] = max(depth[node.first], (unsigned char)(depth[m] + 1));
+        }
+    }
+
+    bvh.adopt(mapping, nodes, header.nodeCount, indices);
+    return true;
+}
@@ -0,0 +1,74 @@
+/*----------------------------------------------------------
+* COSC363  Ray Tracer
+*
+*  The scene file class
+*  Saves a built scene - its objects' shapes as arrays of
+*  kinds, material indices and parameters, the material table
+*  and the flattened BVH - to a binary file, and maps that
+*  file back in on later runs. Sections are located by offsets
+*  from the start of the file, so the mapped BVH is traversed
+*  where it lies, with nothing parsed or copied. A file is only
+*  used if its shapes and materials equal those of the objects
+*  the scene was built with, so it goes stale by itself when
+*  the scene changes.
+-------------------------------------------------------------*/
+
+#ifndef H_SCENE_FILE
+#define H_SCENE_FILE
+
+#include <stdint.h>
+#include <vector>
+#include "BVH.h"
+#include "SceneObject.h"
+
+struct SceneFileHeader
+{
+    char magic[4];
+    uint32_t version;
+    uint32_t byteOrder;     //BYTE_ORDER_MARK as written by the saving machine
+    uint32_t nodeSize;      //sizeof(BVHNode)
+    uint32_t shapeParams;   //SHAPE_PARAMS
+    uint32_t objectCount;
+    uint32_t materialCount;
+    uint32_t nodeCount;
+    uint64_t kindsOffset;       //int32 per object: ShapeKind
+    uint64_t materialsOffset;   //int32 per object: index into the material table
+    uint64_t paramsOffset;      //SHAPE_PARAMS floats per object
+    uint64_t tableOffset;       //MaterialRecord per material
+    uint64_t nodesOffset;       //BVHNode per node
+    uint64_t indicesOffset;     //int32 per object: the BVH's object order
+    uint64_t fileSize;
+};
+
+//Every field that shading reads from a SceneObject
+struct MaterialRecord
+{
+    float color[3];
+    uint32_t flags;     //MATERIAL_* bits
+    float reflectionCoeff;
+    float refractionCoeff;
+    float transparencyCoeff;
+    float refractiveIndex;
+    float shininess;
+    int32_t type;
+};
+
+class SceneFile
+{
+public:
+    static const uint32_t VERSION = 1;
+
+    //Writes the objects and their built tree to 'path' (via a temporary file, so readers never see half a file)
+    static bool save(const char* path, std::vector<SceneObject*>& objects, BVH& bvh);
+
+    /**
+    * Maps 'path' and lets 'bvh' adopt its tree if the file was saved for
+    * objects equal to 'objects'. False, with 'bvh' untouched, if the file is
+    * missing, of another version or machine, damaged or stale.
+    */
+    static bool load(const char* path, std::vector<SceneObject*>& objects, BVH& bvh);
+
+    static MaterialRecord material(SceneObject* object);
+};
+
+#endif //!H_SCENE_FILE
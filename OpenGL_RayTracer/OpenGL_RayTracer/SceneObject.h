@@ -1,63 +1,93 @@
-/*----------------------------------------------------------
-* COSC363  Ray Tracer
-* CSSE, University of Canterbury.
-*
-*  The object class
-*  This is a generic type for storing objects in the scene.
-*  Being an abstract class, this class cannot be instantiated.
-*  Sphere, Plane etc, must be defined as subclasses of Object
-*      and provide implementations for the virtual functions
-*      intersect()  and normal().
--------------------------------------------------------------*/
-
-#ifndef H_SOBJECT
-#define H_SOBJECT
-#include <glm/glm.hpp>
-
-
-class SceneObject 
-{
-protected:
-	glm::vec3 color_ = glm::vec3(1);  //material color
-	bool refl_ = false;  //reflectivity: true/false
-	bool refr_ = false;  //refractivity: true/false
-	bool spec_ = true;   //specularity: true/false
-	bool tran_ = false;  //transparency: true/false
-	float reflc_ = 0.8;  //coefficient of reflection
-	float refrc_ = 0.8;  //coefficient of refraction
-	float tranc_ = 0.8;  //coefficient of transparency
-	float refri_ = 1.0;  //refractive index
-	float shin_ = 50.0; //shininess
-public:
-	SceneObject() {}
-    int type = 0;
-    virtual float intersect(glm::vec3 p0, glm::vec3 dir) = 0;
-	virtual glm::vec3 normal(glm::vec3 pos) = 0;
-	virtual ~SceneObject() {}
-
-	glm::vec3 lighting(glm::vec3 lightPos, glm::vec3 viewVec, glm::vec3 hit);
-    glm::vec3 doubleLighting(glm::vec3 lightPos1, glm::vec3 lightPos2, glm::vec3 viewVec, glm::vec3 hit);
-    glm::vec3 shadow();
-
-	void setColor(glm::vec3 col);
-	void setReflectivity(bool flag);
-	void setReflectivity(bool flag, float refl_coeff);
-	void setRefractivity(bool flag);
-	void setRefractivity(bool flag, float refr_coeff, float refr_indx);
-	void setShininess(float shininess);
-	void setSpecularity(bool flag);
-	void setTransparency(bool flag);
-	void setTransparency(bool flag, float tran_coeff);
-	glm::vec3 getColor();
-	float getReflectionCoeff();
-	float getRefractionCoeff();
-	float getTransparencyCoeff();
-	float getRefractiveIndex();
-	float getShininess();
-	bool isReflective();
-	bool isRefractive();
-	bool isSpecular();
-	bool isTransparent();
-};
-
-#endif
+/*----------------------------------------------------------
+* COSC363  Ray Tracer
+* CSSE, University of Canterbury.
+*
+*  The object class
+*  This is a generic type for storing objects in the scene.
+*  Being an abstract class, this class cannot be instantiated.
+*  Sphere, Plane etc, must be defined as subclasses of Object
+*      and provide implementations for the virtual functions
+*      intersect()  and normal().
+-------------------------------------------------------------*/
+
+#ifndef H_SOBJECT
+#define H_SOBJECT
+#include <glm/glm.hpp>
+#include "BoundingBox.h"
+
+//Kinds of geometry; getShape() describes an object by one of these and SHAPE_PARAMS numbers
+enum ShapeKind
+{
+    SHAPE_SPHERE = 1,
+    SHAPE_PLANE,
+    SHAPE_CYLINDER,
+    SHAPE_CONE,
+    SHAPE_INSTANCE,
+    SHAPE_BOX
+};
+const int SHAPE_PARAMS = 13;
+
+class SceneObject 
+{
+protected:
+	glm::vec3 color_ = glm::vec3(1);  //material color
+	bool refl_ = false;  //reflectivity: true/false
+	bool refr_ = false;  //refractivity: true/false
+	bool spec_ = true;   //specularity: true/false
+	bool tran_ = false;  //transparency: true/false
+	bool text_ = false;  //textured: the colour is looked up when shading, not color_
+	float reflc_ = 0.8;  //coefficient of reflection
+	float refrc_ = 0.8;  //coefficient of refraction
+	float tranc_ = 0.8;  //coefficient of transparency
+	float refri_ = 1.0;  //refractive index
+	float shin_ = 50.0; //shininess
+	glm::vec3 offset_ = glm::vec3(0);  //translation applied since construction
+public:
+	SceneObject() {}
+    int type = 0;
+    virtual float intersect(glm::vec3 p0, glm::vec3 dir) = 0;
+	virtual glm::vec3 normal(glm::vec3 pos) = 0;
+	virtual BoundingBox bounds() = 0;         //box enclosing every point intersect() can return
+	//As intersect(), also reporting which part of the object is hit, for objects made of parts
+	//(-1 for the others); normal() and textureCoords() take it back at that hit
+	virtual float intersect(glm::vec3 p0, glm::vec3 dir, int& part);
+	virtual glm::vec3 normal(glm::vec3 pos, int part);
+	virtual void translate(glm::vec3 d) = 0;  //moves the object by d
+	virtual SceneObject* clone() = 0;         //copy of the object, including its material
+	virtual ShapeKind getShape(float* params) = 0;  //fills params[0, SHAPE_PARAMS), unused ones with 0
+	//Distance along dir at which a ray from p0, on or inside the object, leaves it;
+	//-1 if the object is not closed, so the caller must search the scene instead
+	virtual float exitPoint(glm::vec3 p0, glm::vec3 dir);
+	virtual ~SceneObject() {}
+
+	//Moves the object so that it is displaced by 'offset' from where it was built
+	void setOffset(glm::vec3 offset);
+	glm::vec3 getOffset();
+
+	void setColor(glm::vec3 col);
+	void setReflectivity(bool flag);
+	void setReflectivity(bool flag, float refl_coeff);
+	void setRefractivity(bool flag);
+	void setRefractivity(bool flag, float refr_coeff, float refr_indx);
+	void setShininess(float shininess);
+	void setSpecularity(bool flag);
+	void setTransparency(bool flag);
+	void setTransparency(bool flag, float tran_coeff);
+	void setTextured(bool flag);
+	glm::vec3 getColor();
+	virtual glm::vec3 getColorAt(glm::vec3 pos);  //material color at a point on the object (e.g. per face)
+	virtual glm::vec2 textureCoords(glm::vec3 pos);  //(u, v) of a point on the object; (0, 0) if it has no mapping
+	virtual glm::vec2 textureCoords(glm::vec3 pos, int part);
+	float getReflectionCoeff();
+	float getRefractionCoeff();
+	float getTransparencyCoeff();
+	float getRefractiveIndex();
+	float getShininess();
+	bool isReflective();
+	bool isRefractive();
+	bool isSpecular();
+	bool isTransparent();
+	bool isTextured();
+};
+
+#endif
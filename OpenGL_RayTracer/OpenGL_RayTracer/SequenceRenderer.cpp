@@ -0,0 +1,215 @@
+/*----------------------------------------------------------
+* COSC363  Ray Tracer
+*
+*  The sequence renderer class
+-------------------------------------------------------------*/
+
+#include "SequenceRenderer.h"
+#include "PPMStripWriter.h"
+#include "StreamingRenderer.h"
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <iostream>
+#include <mutex>
+#include <thread>
+
+namespace
+{
+    typedef std::chrono::steady_clock Clock;
+
+    struct FrameSlot
+    {
+        Scene* scene = NULL;
+        int frame = -1;         //Frame held, -1 if the slot is free
+        bool preparing = false; //Animation being applied
+        int nextBand = 0;
+        int bandsDone = 0;
+        std::vector<unsigned char> rgb;
+        Clock::time_point started;
+        double setupSeconds = 0;
+    };
+
+    double secondsSince(Clock::time_point start)
+    {
+        std::chrono::duration<double> elapsed = Clock::now() - start;
+        return elapsed.count();
+    }
+}
+
+SequenceRenderer::SequenceRenderer(Scene& baseScene, Animation& animation, int width, int height)
+    : baseScene_(baseScene), animation_(animation), width_(width), height_(height)
+{
+    threadCount_ = std::max(1, (int)std::thread::hardware_concurrency());
+}
+
+void SequenceRenderer::setFrameRange(int first, int last)
+{
+    firstFrame_ = first;
+    lastFrame_ = std::max(first, last);
+}
+
+void SequenceRenderer::setBandRows(int rows)
+{
+    bandRows_ = std::max(1, rows);
+}
+
+void SequenceRenderer::setThreadCount(int threads)
+{
+    threadCount_ = std::max(1, threads);
+}
+
+void SequenceRenderer::setFramesInFlight(int frames)
+{
+    framesInFlight_ = std::max(1, frames);
+}
+
+std::vector<FrameStats>& SequenceRenderer::getFrameStats()
+{
+    return stats_;
+}
+
+bool SequenceRenderer::render(ScenePixelFunction pixel, const char* filenamePattern)
+{
+    int frameCount = lastFrame_ - firstFrame_ + 1;
+    int bandCount = (height_ + bandRows_ - 1) / bandRows_;
+    int slotCount = std::min(framesInFlight_, frameCount);
+
+    stats_.assign(frameCount, FrameStats());
+    std::vector<FrameSlot> slots(slotCount);
+    for(int s = 0; s < slotCount; s++)
+    {
+        slots[s].scene = baseScene_.clone();
+        slots[s].rgb.resize((size_t)width_ * height_ * 3);
+    }
+
+    std::mutex mutex;
+    std::condition_variable changed;
+    int nextFrame = firstFrame_;
+    bool failed = false;
+
+    auto worker = [&]()
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        while(!failed)
+        {
+            //Oldest frame with bands left to claim
+            int slot = -1;
+            for(int s = 0; s < slotCount; s++)
+            {
+                FrameSlot& fs = slots[s];
+                if(fs.frame >= 0 && !fs.preparing && fs.nextBand < bandCount && (slot < 0 || fs.frame < slots[slot].frame))
+                {
+                    slot = s;
+                }
+            }
+
+            if(slot >= 0)
+            {
+                FrameSlot& fs = slots[slot];
+                int band = fs.nextBand++;
+                if(band == 0) fs.started = Clock::now();
+                int firstRow = band * bandRows_;
+                int rows = std::min(bandRows_, height_ - firstRow);
+                Scene* scene = fs.scene;
+                PixelFunction scenePixel = [&pixel, scene](int i, int j) { return pixel(*scene, i, j); };
+
+                lock.unlock();
+                StreamingRenderer::renderRows(scenePixel, width_, height_, firstRow, rows, fs.rgb.data() + (size_t)firstRow * width_ * 3);
+                lock.lock();
+
+                if(++fs.bandsDone < bandCount) continue;
+
+                //Last band of the frame: write it out and free the slot
+                FrameStats& stats = stats_[fs.frame - firstFrame_];
+                stats.frame = fs.frame;
+                stats.setupSeconds = fs.setupSeconds;
+                stats.renderSeconds = secondsSince(fs.started);
+
+                char filename[1024];
+                snprintf(filename, sizeof(filename), filenamePattern, fs.frame);
+                lock.unlock();
+                PPMStripWriter writer;
+                bool written = writer.open(filename, width_, height_) && writer.writeRows(fs.rgb.data(), height_) && writer.close();
+                lock.lock();
+
+                if(!written) failed = true;
+                fs.frame = -1;
+                changed.notify_all();
+                continue;
+            }
+
+            //Start the next frame in a free slot
+            int freeSlot = -1;
+            for(int s = 0; s < slotCount && freeSlot < 0; s++)
+            {
+                if(slots[s].frame < 0) freeSlot = s;
+            }
+            if(freeSlot >= 0 && nextFrame <= lastFrame_)
+            {
+                FrameSlot& fs = slots[freeSlot];
+                fs.frame = nextFrame++;
+                fs.preparing = true;
+                fs.nextBand = 0;
+                fs.bandsDone = 0;
+
+                lock.unlock();
+                Clock::time_point setupStart = Clock::now();
+                bool applied = animation_.apply(*fs.scene, fs.frame);
+                double setupSeconds = secondsSince(setupStart);
+                lock.lock();
+
+                fs.setupSeconds = setupSeconds;
+                fs.preparing = false;
+                if(!applied) failed = true;
+                changed.notify_all();
+                continue;
+            }
+
+            //Nothing to claim: finished, or wait for a frame to be prepared or freed
+            bool busy = false;
+            for(int s = 0; s < slotCount; s++)
+            {
+                if(slots[s].frame >= 0) busy = true;
+            }
+            if(!busy && nextFrame > lastFrame_) break;
+            changed.wait(lock);
+        }
+        changed.notify_all();
+    };
+
+    std::vector<std::thread> workers;
+    for(int t = 0; t < threadCount_; t++)
+    {
+        workers.push_back(std::thread(worker));
+    }
+    for(uint t = 0; t < workers.size(); t++)
+    {
+        workers[t].join();
+    }
+
+    for(int s = 0; s < slotCount; s++)
+    {
+        delete slots[s].scene;
+    }
+    return !failed;
+}
+
+void SequenceRenderer::printReport()
+{
+    double setup = 0;
+    double render = 0;
+    for(uint f = 0; f < stats_.size(); f++)
+    {
+        FrameStats& s = stats_[f];
+        printf("Frame %d: setup %.3f ms, render %.3f s\n", s.frame, s.setupSeconds * 1000.0, s.renderSeconds);
+        setup += s.setupSeconds;
+        render += s.renderSeconds;
+    }
+    if(!stats_.empty())
+    {
+        printf("%d frames: mean setup %.3f ms, mean render %.3f s\n",
+               (int)stats_.size(), setup * 1000.0 / stats_.size(), render / stats_.size());
+    }
+}
@@ -0,0 +1,63 @@
+/*----------------------------------------------------------
+* COSC363  Ray Tracer
+*
+*  The sequence renderer class
+*  Renders the frames of an animation in one process. Each of
+*  a few frame slots owns a copy of the scene; a slot is moved
+*  to its next frame by applying the animation and refitting
+*  the acceleration structure, so textures and the tree are
+*  never rebuilt. Worker threads take bands from the oldest
+*  frame that still has work and start the next frame as soon
+*  as a slot is free, so frames overlap instead of the pool
+*  idling at the end of each one.
+-------------------------------------------------------------*/
+
+#ifndef H_SEQUENCE_RENDERER
+#define H_SEQUENCE_RENDERER
+
+#include <functional>
+#include <vector>
+#include <glm/glm.hpp>
+#include "Animation.h"
+#include "Scene.h"
+
+//Colour of pixel (i, j) of the given frame's scene; j is counted from the bottom
+typedef std::function<glm::vec3(Scene& scene, int i, int j)> ScenePixelFunction;
+
+struct FrameStats
+{
+    int frame = 0;
+    double setupSeconds = 0;   //Applying the animation and refitting
+    double renderSeconds = 0;  //First band started to last band finished
+};
+
+class SequenceRenderer
+{
+private:
+    Scene& baseScene_;
+    Animation& animation_;
+    int width_;
+    int height_;
+    int firstFrame_ = 0;
+    int lastFrame_ = 0;
+    int bandRows_ = 16;
+    int threadCount_ = 1;
+    int framesInFlight_ = 2;
+    std::vector<FrameStats> stats_;
+
+public:
+    SequenceRenderer(Scene& baseScene, Animation& animation, int width, int height);
+
+    void setFrameRange(int first, int last);
+    void setBandRows(int rows);
+    void setThreadCount(int threads);
+    void setFramesInFlight(int frames);
+
+    //Writes frame f to the file named by printf(filenamePattern, f), e.g. "frame_%04d.ppm"
+    bool render(ScenePixelFunction pixel, const char* filenamePattern);
+
+    std::vector<FrameStats>& getFrameStats();
+    void printReport();
+};
+
+#endif //!H_SEQUENCE_RENDERER
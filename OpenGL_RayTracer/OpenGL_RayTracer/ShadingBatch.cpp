@@ -0,0 +1,206 @@
+/*----------------------------------------------------------
+* COSC363  Ray Tracer
+*
+*  The shading batch class
+-------------------------------------------------------------*/
+
+#include "ShadingBatch.h"
+#include "FastMath.h"
+#include <math.h>
+
+namespace
+{
+    const float AMBIENT_TERM = 0.2;
+    //Brightening of light passing a transparent or refractive blocker
+    const float SEE_THROUGH_FACTOR = 1.46;
+}
+
+const int ShadingBatch::CAPACITY;
+
+int ShadingBatch::add(glm::vec3 hit, glm::vec3 normal, glm::vec3 viewVec, glm::vec3 surfaceColor, float shininess, bool specular)
+{
+    int k = count_++;
+    px_[k] = hit.x;
+    py_[k] = hit.y;
+    pz_[k] = hit.z;
+    nx_[k] = normal.x;
+    ny_[k] = normal.y;
+    nz_[k] = normal.z;
+    vx_[k] = viewVec.x;
+    vy_[k] = viewVec.y;
+    vz_[k] = viewVec.z;
+    r_[k] = surfaceColor.r;
+    g_[k] = surfaceColor.g;
+    b_[k] = surfaceColor.b;
+    shininess_[k] = shininess;
+    specular_[k] = specular;
+    return k;
+}
+
+#ifdef SHADING_BATCH_SSE
+/**
+* Diffuse terms and reflection . view of records [block, block + LANES) for
+* one light, with SSE. Packed arithmetic rounds as the scalar version does.
+*/
+void ShadingBatch::shadeBlock(int block, int light, glm::vec3 lightPos, float* rDotv)
+{
+    const __m128 signBit = _mm_set1_ps(-0.0f);
+    __m128 lx = _mm_sub_ps(_mm_set1_ps(lightPos.x), _mm_loadu_ps(px_ + block));
+    __m128 ly = _mm_sub_ps(_mm_set1_ps(lightPos.y), _mm_loadu_ps(py_ + block));
+    __m128 lz = _mm_sub_ps(_mm_set1_ps(lightPos.z), _mm_loadu_ps(pz_ + block));
+    __m128 lengthSquared = _mm_add_ps(_mm_add_ps(_mm_mul_ps(lx, lx), _mm_mul_ps(ly, ly)), _mm_mul_ps(lz, lz));
+    __m128 inverseLength = _mm_div_ps(_mm_set1_ps(1.0f), _mm_sqrt_ps(lengthSquared));
+    lx = _mm_mul_ps(lx, inverseLength);
+    ly = _mm_mul_ps(ly, inverseLength);
+    lz = _mm_mul_ps(lz, inverseLength);
+
+    __m128 nx = _mm_loadu_ps(nx_ + block);
+    __m128 ny = _mm_loadu_ps(ny_ + block);
+    __m128 nz = _mm_loadu_ps(nz_ + block);
+    __m128 diffuse = _mm_add_ps(_mm_add_ps(_mm_mul_ps(lx, nx), _mm_mul_ps(ly, ny)), _mm_mul_ps(lz, nz));
+    _mm_storeu_ps(diffuse_[light] + block, diffuse);
+
+    __m128 ix = _mm_xor_ps(lx, signBit);
+    __m128 iy = _mm_xor_ps(ly, signBit);
+    __m128 iz = _mm_xor_ps(lz, signBit);
+    __m128 nDotI = _mm_add_ps(_mm_add_ps(_mm_mul_ps(nx, ix), _mm_mul_ps(ny, iy)), _mm_mul_ps(nz, iz));
+    __m128 twoNDotI = _mm_mul_ps(_mm_set1_ps(2.0f), nDotI);
+    __m128 rx = _mm_sub_ps(ix, _mm_mul_ps(nx, twoNDotI));
+    __m128 ry = _mm_sub_ps(iy, _mm_mul_ps(ny, twoNDotI));
+    __m128 rz = _mm_sub_ps(iz, _mm_mul_ps(nz, twoNDotI));
+    __m128 vx = _mm_loadu_ps(vx_ + block);
+    __m128 vy = _mm_loadu_ps(vy_ + block);
+    __m128 vz = _mm_loadu_ps(vz_ + block);
+    _mm_storeu_ps(rDotv + block, _mm_add_ps(_mm_add_ps(_mm_mul_ps(rx, vx), _mm_mul_ps(ry, vy)), _mm_mul_ps(rz, vz)));
+}
+#else
+void ShadingBatch::shadeBlock(int block, int light, glm::vec3 lightPos, float* rDotv)
+{
+    for(int k = block; k < block + LANES; k++)
+    {
+        float lx = lightPos.x - px_[k];
+        float ly = lightPos.y - py_[k];
+        float lz = lightPos.z - pz_[k];
+        float inverseLength = 1.0f / sqrtf(lx * lx + ly * ly + lz * lz);
+        lx *= inverseLength;
+        ly *= inverseLength;
+        lz *= inverseLength;
+        diffuse_[light][k] = lx * nx_[k] + ly * ny_[k] + lz * nz_[k];
+
+        //reflect(-l, n) = -l - n * 2(n . -l)
+        float twoNDotI = 2.0f * (nx_[k] * -lx + ny_[k] * -ly + nz_[k] * -lz);
+        float rx = -lx - nx_[k] * twoNDotI;
+        float ry = -ly - ny_[k] * twoNDotI;
+        float rz = -lz - nz_[k] * twoNDotI;
+        rDotv[k] = rx * vx_[k] + ry * vy_[k] + rz * vz_[k];
+    }
+}
+#endif
+
+/**
+* The records are shaded LANES at a time, the last block padded with
+* copies of record 0. The vector arithmetic is written out in the order
+* glm::normalize(), dot() and reflect() use, so the terms match those of
+* scalar glm code exactly. Only the power in the highlight is left to a
+* per-record loop, for the specular records that face the light.
+*/
+void ShadingBatch::shade(const glm::vec3 lightPos[LIGHT_COUNT])
+{
+    int padded = (count_ + LANES - 1) / LANES * LANES;
+    for(int k = count_; k < padded; k++)
+    {
+        px_[k] = px_[0];
+        py_[k] = py_[0];
+        pz_[k] = pz_[0];
+        nx_[k] = nx_[0];
+        ny_[k] = ny_[0];
+        nz_[k] = nz_[0];
+        vx_[k] = vx_[0];
+        vy_[k] = vy_[0];
+        vz_[k] = vz_[0];
+    }
+
+    float rDotv[CAPACITY];
+    for(int light = 0; light < LIGHT_COUNT; light++)
+    {
+        for(int block = 0; block < padded; block += LANES)
+        {
+            shadeBlock(block, light, lightPos[light], rDotv);
+        }
+
+        float* highlight = highlight_[light];
+        for(int k = 0; k < count_; k++)
+        {
+            highlight[k] = specular_[k] && rDotv[k] > 0 ? mathPow(rDotv[k], shininess_[k]) : 0;
+        }
+    }
+}
+
+glm::vec3 ShadingBatch::ambient(int k) const
+{
+    return AMBIENT_TERM * getSurfaceColor(k);
+}
+
+glm::vec3 ShadingBatch::litBy(int k, int light) const
+{
+    glm::vec3 surfaceColor = getSurfaceColor(k);
+    glm::vec3 colorSum = AMBIENT_TERM * surfaceColor + diffuse_[light][k] * surfaceColor + highlight_[light][k] * glm::vec3(1);
+    return glm::max(colorSum, glm::vec3(0));
+}
+
+glm::vec3 ShadingBatch::litByAll(int k, bool twoSided) const
+{
+    glm::vec3 surfaceColor = getSurfaceColor(k);
+    glm::vec3 colorSum = AMBIENT_TERM * surfaceColor;
+    for(int light = 0; light < LIGHT_COUNT; light++)
+    {
+        float lDotn = diffuse_[light][k];
+        if(twoSided && lDotn < 0)
+        {
+            lDotn = -lDotn;
+        }
+        colorSum = colorSum + lDotn * surfaceColor + highlight_[light][k] * glm::vec3(1);
+    }
+    return glm::clamp(colorSum, 0.0f, 1.0f);
+}
+
+/**
+* The shadow rules of trace(), for its two lights (0 left, 1 right). With
+* both blocked only the ambient term is left, or, if the right light's
+* blocker lets light through, the sum of both lights dimmed. With one
+* blocked the record is lit by that same light alone, brightened if its
+* blocker lets light through.
+*/
+glm::vec3 ShadingBatch::resolveShadows(int k, unsigned shadowed, unsigned seeThrough, bool twoSided) const
+{
+    const unsigned LEFT = 1;
+    const unsigned RIGHT = 2;
+    glm::vec3 color;
+    if((shadowed & LEFT) && (shadowed & RIGHT))
+    {
+        color = ambient(k);
+        if(seeThrough & RIGHT)
+        {
+            glm::vec3 color1 = litBy(k, 1);
+            glm::vec3 color2 = litBy(k, 0);
+            color.r = (color1.r + color2.r) * SEE_THROUGH_FACTOR * 0.45;
+            color.g = (color1.g + color2.g) * SEE_THROUGH_FACTOR * 0.45;
+            color.b = (color1.b + color2.b) * SEE_THROUGH_FACTOR * 0.45;
+        }
+        return color;
+    }
+    if(shadowed == 0)
+    {
+        return litByAll(k, twoSided);
+    }
+
+    unsigned blocked = shadowed & RIGHT ? RIGHT : LEFT;
+    color = litBy(k, blocked == RIGHT ? 1 : 0);
+    if(seeThrough & blocked)
+    {
+        color.r = color.r * SEE_THROUGH_FACTOR > 1 ? 1 : color.r * SEE_THROUGH_FACTOR;
+        color.g = color.g * SEE_THROUGH_FACTOR > 1 ? 1 : color.g * SEE_THROUGH_FACTOR;
+        color.b = color.b * SEE_THROUGH_FACTOR > 1 ? 1 : color.b * SEE_THROUGH_FACTOR;
+    }
+    return color;
+}
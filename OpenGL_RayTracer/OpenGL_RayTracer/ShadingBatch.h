@@ -0,0 +1,79 @@
+/*----------------------------------------------------------
+* COSC363  Ray Tracer
+*
+*  The shading batch class
+*  Phong shading of up to CAPACITY hit records at once. The
+*  records are held as separate arrays of positions, normals,
+*  view vectors and materials, so shade() evaluates the
+*  diffuse and highlight terms of every light for the whole
+*  batch in loops the compiler vectorises. The lit colour of
+*  a record is then put together from those terms according
+*  to which lights its shadow rays found blocked: an ambient
+*  term of 0.2, plus the diffuse and highlight terms of each
+*  light that is not blocked. trace() shades its hit as a
+*  batch of one; the pixel kernel shades all of a pixel's
+*  sub-samples in one batch.
+-------------------------------------------------------------*/
+
+#ifndef H_SHADING_BATCH
+#define H_SHADING_BATCH
+
+#include <glm/glm.hpp>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define SHADING_BATCH_SSE
+#endif
+
+class ShadingBatch
+{
+public:
+    static const int CAPACITY = 16;
+    static const int LIGHT_COUNT = 2;
+    static const int LANES = 4;     //records shaded together in one SIMD register
+
+private:
+    int count_ = 0;
+    float px_[CAPACITY], py_[CAPACITY], pz_[CAPACITY];  //hit points
+    float nx_[CAPACITY], ny_[CAPACITY], nz_[CAPACITY];  //unit normals
+    float vx_[CAPACITY], vy_[CAPACITY], vz_[CAPACITY];  //unit vectors towards the viewer
+    float r_[CAPACITY], g_[CAPACITY], b_[CAPACITY];     //surface colours
+    float shininess_[CAPACITY];
+    bool specular_[CAPACITY];
+
+    float diffuse_[LIGHT_COUNT][CAPACITY];     //light direction . normal
+    float highlight_[LIGHT_COUNT][CAPACITY];   //specular term, 0 if not specular
+
+    void shadeBlock(int block, int light, glm::vec3 lightPos, float* rDotv);
+
+public:
+    void clear() { count_ = 0; }
+    int size() const { return count_; }
+    bool isFull() const { return count_ == CAPACITY; }
+
+    //Adds a record and returns its index; the batch must not be full
+    int add(glm::vec3 hit, glm::vec3 normal, glm::vec3 viewVec, glm::vec3 surfaceColor, float shininess, bool specular);
+
+    //Evaluates every light for every record
+    void shade(const glm::vec3 lightPos[LIGHT_COUNT]);
+
+    glm::vec3 getNormal(int k) const { return glm::vec3(nx_[k], ny_[k], nz_[k]); }
+    glm::vec3 getSurfaceColor(int k) const { return glm::vec3(r_[k], g_[k], b_[k]); }
+
+    //Ambient term only, for a record every light is blocked from
+    glm::vec3 ambient(int k) const;
+    //Ambient plus one light's terms, clamped below at 0
+    glm::vec3 litBy(int k, int light) const;
+    //Ambient plus every light's terms, clamped to [0, 1]; a two-sided record
+    //is lit from behind too
+    glm::vec3 litByAll(int k, bool twoSided) const;
+
+    /**
+    * Colour of record k given a mask of the lights its shadow rays found
+    * blocked, and of those whose blocker is transparent or refractive (which
+    * lets some light through). Bit n stands for light n.
+    */
+    glm::vec3 resolveShadows(int k, unsigned shadowed, unsigned seeThrough, bool twoSided) const;
+};
+
+#endif //!H_SHADING_BATCH
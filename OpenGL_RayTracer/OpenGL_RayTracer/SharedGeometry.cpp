@@ -0,0 +1,124 @@
+/*----------------------------------------------------------
+* COSC363  Ray Tracer
+*
+*  The shared geometry class
+-------------------------------------------------------------*/
+
+#include "SharedGeometry.h"
+#include "Plane.h"
+#include "Ray.h"
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <math.h>
+
+SharedGeometry::~SharedGeometry()
+{
+    for(size_t k = 0; k < parts_.size(); k++)
+    {
+        delete parts_[k];
+    }
+}
+
+void SharedGeometry::add(SceneObject* part)
+{
+    parts_.push_back(part);
+}
+
+/**
+* Faces are taken to be wound counter-clockwise seen from outside, as
+* OpenGL does, which is the order Plane's normal expects. Degenerate
+* triangles are skipped.
+*/
+bool SharedGeometry::loadOFF(const char* filename)
+{
+    std::ifstream file(filename);
+    std::string magic;
+    int vertexCount = 0, faceCount = 0, edgeCount = 0;
+    if(!(file >> magic >> vertexCount >> faceCount >> edgeCount) || magic != "OFF" || vertexCount < 0 || faceCount < 0)
+    {
+        std::cerr << "*** Not an OFF mesh: " << filename << std::endl;
+        return false;
+    }
+
+    std::vector<glm::vec3> vertices(vertexCount);
+    for(int v = 0; v < vertexCount; v++)
+    {
+        file >> vertices[v].x >> vertices[v].y >> vertices[v].z;
+    }
+    for(int f = 0; f < faceCount && file; f++)
+    {
+        int count = 0;
+        file >> count;
+        std::vector<int> face(std::max(0, count));
+        for(int k = 0; k < count; k++)
+        {
+            file >> face[k];
+            if(face[k] < 0 || face[k] >= vertexCount) face[k] = 0;
+        }
+        for(int k = 2; k < count && file; k++)
+        {
+            glm::vec3 a = vertices[face[0]], b = vertices[face[k - 1]], c = vertices[face[k]];
+            if(glm::length(glm::cross(b - a, c - a)) > 1.e-12f)
+            {
+                add(new Plane(a, b, c));
+            }
+        }
+    }
+    if(!file)
+    {
+        std::cerr << "*** Truncated OFF mesh: " << filename << std::endl;
+        return false;
+    }
+    return true;
+}
+
+void SharedGeometry::build()
+{
+    bvh_.build(parts_);
+    bounds_ = BoundingBox();
+    hash_ = 2166136261u;
+    float params[SHAPE_PARAMS];
+    for(size_t k = 0; k < parts_.size(); k++)
+    {
+        bounds_.expand(parts_[k]->bounds());
+        int kind = parts_[k]->getShape(params);
+        const unsigned char* bytes = (const unsigned char*)params;
+        for(size_t b = 0; b < sizeof(params); b++)
+        {
+            hash_ = (hash_ ^ bytes[b]) * 16777619u;
+        }
+        hash_ = (hash_ ^ kind) * 16777619u;
+    }
+}
+
+int SharedGeometry::closestPt(glm::vec3 p0, glm::vec3 dir, float& t)
+{
+    Ray ray;
+    ray.p0 = p0;
+    ray.dir = dir;
+    bvh_.closestPt(ray, parts_);
+    t = ray.dist;
+    return ray.index;
+}
+
+SceneObject* SharedGeometry::getPart(int k)
+{
+    return parts_[k];
+}
+
+int SharedGeometry::getPartCount()
+{
+    return parts_.size();
+}
+
+BoundingBox SharedGeometry::bounds()
+{
+    return bounds_;
+}
+
+uint32_t SharedGeometry::getHash()
+{
+    return hash_;
+}
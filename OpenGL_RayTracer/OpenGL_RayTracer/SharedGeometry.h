@@ -0,0 +1,53 @@
+/*----------------------------------------------------------
+* COSC363  Ray Tracer
+*
+*  The shared geometry class
+*  A group of objects (parts) in their own object space with
+*  their own BVH, built once and placed in the scene any
+*  number of times by Instance objects. The parts' materials
+*  are not used; each instance is shaded with its own.
+-------------------------------------------------------------*/
+
+#ifndef H_SHARED_GEOMETRY
+#define H_SHARED_GEOMETRY
+
+#include <stdint.h>
+#include <vector>
+#include "BVH.h"
+#include "SceneObject.h"
+
+class SharedGeometry
+{
+private:
+    std::vector<SceneObject*> parts_;
+    BVH bvh_;
+    BoundingBox bounds_;
+    uint32_t hash_ = 0;
+
+    SharedGeometry(const SharedGeometry&);
+    SharedGeometry& operator=(const SharedGeometry&);
+
+public:
+    SharedGeometry() {}
+    ~SharedGeometry();
+
+    void add(SceneObject* part);
+
+    //Adds the faces of an OFF mesh as triangles (polygons are split into fans); false if the file cannot be read
+    bool loadOFF(const char* filename);
+
+    //Builds the bottom-level BVH; call once all parts are added
+    void build();
+
+    //Index of the closest part the object space ray hits, with its distance along the unit 'dir'; -1 if none
+    int closestPt(glm::vec3 p0, glm::vec3 dir, float& t);
+
+    SceneObject* getPart(int k);
+    int getPartCount();
+    BoundingBox bounds();
+
+    //FNV-1a hash of the parts' shapes, so scene files notice when the geometry changes
+    uint32_t getHash();
+};
+
+#endif //!H_SHARED_GEOMETRY
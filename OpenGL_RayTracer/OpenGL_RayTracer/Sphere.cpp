@@ -1,47 +1,103 @@
-/*----------------------------------------------------------
-* COSC363  Ray Tracer
-*
-*  The sphere class
-*  This is a subclass of Object, and hence implements the
-*  methods intersect() and normal().
--------------------------------------------------------------*/
-
-#include "Sphere.h"
-#include <math.h>
-
-/**
-* Sphere's intersection method.  The input is a ray. 
-*/
-float Sphere::intersect(glm::vec3 p0, glm::vec3 dir)
-{
-    glm::vec3 vdif = p0 - center;   //Vector s (see Slide 28)
-    float b = glm::dot(dir, vdif);
-    float len = glm::length(vdif);
-    float c = len*len - radius*radius;
-    float delta = b*b - c;
-   
-	if(fabs(delta) < 0.001) return -1.0; 
-    if(delta < 0.0) return -1.0;
-
-    float t1 = -b - sqrt(delta);
-    float t2 = -b + sqrt(delta);
-    if(fabs(t1) < 0.001 )
-    {
-        if (t2 > 0) return t2;
-        else t1 = -1.0;
-    }
-    if(fabs(t2) < 0.001 ) t2 = -1.0;
-
-	return (t1 < t2)? t1: t2;
-}
-
-/**
-* Returns the unit normal vector at a given point.
-* Assumption: The input point p lies on the sphere.
-*/
-glm::vec3 Sphere::normal(glm::vec3 p)
-{
-    glm::vec3 n = p - center;
-    n = glm::normalize(n);
-    return n;
-}
+/*----------------------------------------------------------
+* COSC363  Ray Tracer
+*
+*  The sphere class
+*  This is a subclass of Object, and hence implements the
+*  methods intersect() and normal().
+-------------------------------------------------------------*/
+
+#include "Sphere.h"
+#include <math.h>
+
+/**
+* Sphere's intersection method.  The input is a ray. 
+*/
+float Sphere::intersect(glm::vec3 p0, glm::vec3 dir)
+{
+    glm::vec3 vdif = p0 - center;   //Vector s (see Slide 28)
+    float b = glm::dot(dir, vdif);
+    float len = glm::length(vdif);
+    float c = len*len - radius*radius;
+    float delta = b*b - c;
+   
+	if(fabs(delta) < 0.001) return -1.0; 
+    if(delta < 0.0) return -1.0;
+
+    float t1 = -b - sqrt(delta);
+    float t2 = -b + sqrt(delta);
+    if(fabs(t1) < 0.001 )
+    {
+        if (t2 > 0) return t2;
+        else t1 = -1.0;
+    }
+    if(fabs(t2) < 0.001 ) t2 = -1.0;
+
+	return (t1 < t2)? t1: t2;
+}
+
+/**
+* The far root of the ray-sphere equation: where a ray starting on or
+* inside the sphere leaves it.
+*/
+float Sphere::exitPoint(glm::vec3 p0, glm::vec3 dir)
+{
+    glm::vec3 vdif = p0 - center;
+    float b = glm::dot(dir, vdif);
+    float c = glm::dot(vdif, vdif) - radius*radius;
+    float delta = b*b - c;
+    if(delta < 0.0) return -1.0;
+
+    float t2 = -b + sqrt(delta);
+    return t2 > 0.001 ? t2 : -1.0;
+}
+
+/**
+* Returns the unit normal vector at a given point.
+* Assumption: The input point p lies on the sphere.
+*/
+glm::vec3 Sphere::normal(glm::vec3 p)
+{
+    glm::vec3 n = p - center;
+    n = glm::normalize(n);
+    return n;
+}
+
+/**
+* Longitude and latitude of the point, each scaled to [0, 1]; u is 0.5
+* facing +z and v is 0 at the bottom.
+*/
+glm::vec2 Sphere::textureCoords(glm::vec3 p)
+{
+    glm::vec3 n = normal(p);
+    float u = 0.5 + atan2(n.x, n.z) / (2 * M_PI);
+    float v = 0.5 + asin(glm::clamp(n.y, -1.0f, 1.0f)) / M_PI;
+    return glm::vec2(u, v);
+}
+
+BoundingBox Sphere::bounds()
+{
+    return BoundingBox(center - glm::vec3(radius), center + glm::vec3(radius));
+}
+
+void Sphere::translate(glm::vec3 d)
+{
+    center += d;
+}
+
+SceneObject* Sphere::clone()
+{
+    return new Sphere(*this);
+}
+
+ShapeKind Sphere::getShape(float* params)
+{
+    for(int k = 0; k < SHAPE_PARAMS; k++)
+    {
+        params[k] = 0;
+    }
+    params[0] = center.x;
+    params[1] = center.y;
+    params[2] = center.z;
+    params[3] = radius;
+    return SHAPE_SPHERE;
+}
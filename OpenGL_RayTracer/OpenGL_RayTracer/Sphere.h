@@ -1,36 +1,45 @@
-/*----------------------------------------------------------
-* COSC363  Ray Tracer
-*
-*  The sphere class
-*  This is a subclass of Object, and hence implements the
-*  methods intersect() and normal().
--------------------------------------------------------------*/
-
-#ifndef H_SPHERE
-#define H_SPHERE
-#include <glm/glm.hpp>
-#include "SceneObject.h"
-
-/**
- * Defines a simple Sphere located at 'center'
- * with the specified radius
- */
-class Sphere : public SceneObject
-{
-
-private:
-    glm::vec3 center = glm::vec3(0);
-    float radius = 1;
-
-public:
-	Sphere() {};  //Default constructor creates a unit sphere
-
-	Sphere(glm::vec3 c, float r) : center(c), radius(r) {}
-
-	float intersect(glm::vec3 p0, glm::vec3 dir);
-
-	glm::vec3 normal(glm::vec3 p);
-
-};
-
-#endif //!H_SPHERE
+/*----------------------------------------------------------
+* COSC363  Ray Tracer
+*
+*  The sphere class
+*  This is a subclass of Object, and hence implements the
+*  methods intersect() and normal().
+-------------------------------------------------------------*/
+
+#ifndef H_SPHERE
+#define H_SPHERE
+#include <glm/glm.hpp>
+#include "SceneObject.h"
+
+/**
+ * Defines a simple Sphere located at 'center'
+ * with the specified radius
+ */
+class Sphere : public SceneObject
+{
+
+private:
+    glm::vec3 center = glm::vec3(0);
+    float radius = 1;
+
+public:
+	Sphere() {};  //Default constructor creates a unit sphere
+
+	Sphere(glm::vec3 c, float r) : center(c), radius(r) {}
+
+	float intersect(glm::vec3 p0, glm::vec3 dir);
+	float exitPoint(glm::vec3 p0, glm::vec3 dir);
+
+	glm::vec3 normal(glm::vec3 p);
+	glm::vec2 textureCoords(glm::vec3 p);
+
+	BoundingBox bounds();
+
+	void translate(glm::vec3 d);
+
+	SceneObject* clone();
+	ShapeKind getShape(float* params);
+
+};
+
+#endif //!H_SPHERE
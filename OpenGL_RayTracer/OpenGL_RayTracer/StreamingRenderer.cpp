@@ -0,0 +1,219 @@
+/*----------------------------------------------------------
+* COSC363  Ray Tracer
+*
+*  The streaming renderer class
+-------------------------------------------------------------*/
+
+#include "StreamingRenderer.h"
+#include <algorithm>
+#include <condition_variable>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    unsigned char toByte(float c)
+    {
+        c = c < 0 ? 0 : (c > 1 ? 1 : c);
+        return (unsigned char)(c * 255.0f + 0.5f);
+    }
+}
+
+StreamingRenderer::StreamingRenderer(int width, int height) : width_(width), height_(height)
+{
+    threadCount_ = std::max(1, (int)std::thread::hardware_concurrency());
+}
+
+void StreamingRenderer::resize(int width, int height)
+{
+    width_ = width;
+    height_ = height;
+}
+
+void StreamingRenderer::setBandRows(int rows)
+{
+    bandRows_ = std::max(1, rows);
+}
+
+void StreamingRenderer::setMemoryLimit(size_t bytes)
+{
+    memoryLimit_ = bytes;
+}
+
+void StreamingRenderer::setThreadCount(int threads)
+{
+    threadCount_ = std::max(1, threads);
+}
+
+void StreamingRenderer::setChannels(int channels)
+{
+    channels_ = channels == 4 ? 4 : 3;
+}
+
+int StreamingRenderer::getBandRows()
+{
+    return bandRows_;
+}
+
+int StreamingRenderer::getBandCount()
+{
+    return (height_ + bandRows_ - 1) / bandRows_;
+}
+
+/**
+* Number of band buffers that fit in the memory limit (at least one).
+*/
+int StreamingRenderer::getMaxBandsInFlight()
+{
+    size_t bandBytes = (size_t)width_ * bandRows_ * channels_;
+    size_t bands = memoryLimit_ / bandBytes;
+    if(bands < 1) bands = 1;
+    return (int)std::min(bands, (size_t)getBandCount());
+}
+
+void StreamingRenderer::renderRows(const PixelFunction& pixel, int width, int height, int firstRow, int rows, unsigned char* rgb, int channels)
+{
+    for(int r = 0; r < rows; r++)
+    {
+        int j = height - 1 - (firstRow + r);
+        for(int i = 0; i < width; i++)
+        {
+            glm::vec3 color = pixel(i, j);
+            unsigned char* p = rgb + ((size_t)r * width + i) * channels;
+            p[0] = toByte(color.r);
+            p[1] = toByte(color.g);
+            p[2] = toByte(color.b);
+            if(channels == 4) p[3] = 255;
+        }
+    }
+}
+
+int StreamingRenderer::freeSlot()
+{
+    for(int s = 0; s < (int)slots_.size(); s++)
+    {
+        if(slots_[s].band == -1) return s;
+    }
+    return -1;
+}
+
+/**
+* Waits for renders and takes their bands until the renderer is destroyed.
+*/
+void StreamingRenderer::work(int index)
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    while(true)
+    {
+        int slot = -1;
+        changed_.wait(lock, [&]()
+        {
+            if(stopping_) return true;
+            if(pixel_ == nullptr || index >= workerLimit_ || failed_ || nextBand_ >= bandCount_) return false;
+            slot = freeSlot();
+            return slot >= 0;
+        });
+        if(stopping_) return;
+
+        int band = nextBand_++;
+        slots_[slot].band = band;
+        slots_[slot].done = false;
+        busyWorkers_++;
+
+        int firstRow = band * bandRows_;
+        int rows = std::min(bandRows_, height_ - firstRow);
+        const PixelFunction& pixel = *pixel_;
+
+        lock.unlock();
+        renderRows(pixel, width_, height_, firstRow, rows, slots_[slot].rgb.data(), channels_);
+        lock.lock();
+
+        slots_[slot].done = true;
+        busyWorkers_--;
+        changed_.notify_all();
+    }
+}
+
+/**
+* Worker threads claim bands in increasing order, each into a free slot;
+* the calling thread waits for the bands in order and passes them to the sink,
+* which releases their slots. Because bands are claimed in order, the oldest
+* occupied slot always holds the next band to be written, so a full pool
+* can never deadlock.
+*/
+bool StreamingRenderer::render(const PixelFunction& pixel, const BandSink& sink)
+{
+    int bandCount = getBandCount();
+    int slotCount = getMaxBandsInFlight();
+    int workerCount = std::min(threadCount_, slotCount);
+
+    if((size_t)width_ * bandRows_ * channels_ > memoryLimit_)
+    {
+        std::cerr << "*** A single band of " << bandRows_ << " rows exceeds the memory limit; rendering one band at a time" << std::endl;
+    }
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    slots_.resize(slotCount);
+    for(int s = 0; s < slotCount; s++)
+    {
+        slots_[s].rgb.resize((size_t)width_ * bandRows_ * channels_);
+        slots_[s].band = -1;
+    }
+    while((int)workers_.size() < workerCount)
+    {
+        workers_.push_back(std::thread(&StreamingRenderer::work, this, (int)workers_.size()));
+    }
+    pixel_ = &pixel;
+    workerLimit_ = workerCount;
+    nextBand_ = 0;
+    bandCount_ = bandCount;
+    failed_ = false;
+    changed_.notify_all();
+
+    for(int band = 0; band < bandCount && !failed_; band++)
+    {
+        int slot = -1;
+        changed_.wait(lock, [&]()
+        {
+            for(int s = 0; s < slotCount; s++)
+            {
+                if(slots_[s].band == band && slots_[s].done)
+                {
+                    slot = s;
+                    return true;
+                }
+            }
+            return false;
+        });
+
+        int firstRow = band * bandRows_;
+        int rows = std::min(bandRows_, height_ - firstRow);
+        lock.unlock();
+        bool accepted = sink(slots_[slot].rgb.data(), firstRow, rows);
+        lock.lock();
+
+        slots_[slot].band = -1;
+        if(!accepted) failed_ = true;
+        changed_.notify_all();
+    }
+
+    //Bands already claimed when the sink failed still finish before 'pixel' goes out of scope
+    changed_.wait(lock, [&]() { return busyWorkers_ == 0; });
+    pixel_ = nullptr;
+    return !failed_;
+}
+
+StreamingRenderer::~StreamingRenderer()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    changed_.notify_all();
+    for(size_t t = 0; t < workers_.size(); t++)
+    {
+        workers_[t].join();
+    }
+}
@@ -0,0 +1,90 @@
+/*----------------------------------------------------------
+* COSC363  Ray Tracer
+*
+*  The streaming renderer class
+*  Renders an image as a sequence of horizontal bands on a
+*  pool of worker threads and hands finished bands to a sink
+*  strictly from top to bottom. Only a bounded number of bands
+*  is held in memory at any time, so peak memory depends on
+*  the band size and memory limit, not on the image height.
+*  The worker threads and band buffers are kept from one
+*  render() to the next, so rendering frame after frame of the
+*  same size does not allocate.
+-------------------------------------------------------------*/
+
+#ifndef H_STREAMING_RENDERER
+#define H_STREAMING_RENDERER
+
+#include <glm/glm.hpp>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <cstddef>
+
+//Colour of pixel (i, j); i is the column, j the row counted from the bottom (as in display())
+typedef std::function<glm::vec3(int i, int j)> PixelFunction;
+
+//Receives 'rows' packed RGB (or RGBA) rows starting at image row 'firstRow' (counted from the top)
+typedef std::function<bool(const unsigned char* rgb, int firstRow, int rows)> BandSink;
+
+class StreamingRenderer
+{
+private:
+    //One in-flight band buffer
+    struct BandSlot
+    {
+        std::vector<unsigned char> rgb;
+        int band = -1;      //Band currently held, -1 if the slot is free
+        bool done = false;  //True once the band has been fully rendered
+    };
+
+    int width_;
+    int height_;
+    int bandRows_ = 16;
+    size_t memoryLimit_ = 64 << 20;
+    int threadCount_ = 1;
+    int channels_ = 3;
+
+    //State shared with the workers, guarded by mutex_
+    std::mutex mutex_;
+    std::condition_variable changed_;
+    std::vector<std::thread> workers_;
+    std::vector<BandSlot> slots_;
+    const PixelFunction* pixel_ = nullptr;  //the current render()'s pixels; null between renders
+    int workerLimit_ = 0;   //workers [0, workerLimit_) take bands
+    int busyWorkers_ = 0;
+    int nextBand_ = 0;
+    int bandCount_ = 0;
+    bool failed_ = false;
+    bool stopping_ = false;
+
+    int freeSlot();
+    void work(int index);
+
+public:
+    StreamingRenderer(int width, int height);
+    ~StreamingRenderer();
+
+    //Changes the image size for later renders; the workers and buffers are kept
+    void resize(int width, int height);
+
+    //Renders 'rows' image rows starting at 'firstRow' (counted from the top) into packed
+    //8-bit RGB, or RGBA with opaque alpha if channels is 4
+    static void renderRows(const PixelFunction& pixel, int width, int height, int firstRow, int rows, unsigned char* rgb, int channels = 3);
+
+    void setBandRows(int rows);
+    void setMemoryLimit(size_t bytes);
+    void setThreadCount(int threads);
+    void setChannels(int channels);
+
+    int getBandRows();
+    int getBandCount();
+    int getMaxBandsInFlight();
+
+    //Renders the whole image; returns false if the sink rejected a band
+    bool render(const PixelFunction& pixel, const BandSink& sink);
+};
+
+#endif //!H_STREAMING_RENDERER
@@ -1,89 +1,355 @@
-//=====================================================================
-// Image loader for files in BMP format.
-// Assumption:  Uncompressed data; 24 or 32 bits per pixel, Windows BMP.
-// Class definition suitable for ray tracing applications
-// Author:
-// R. Mukundan, Department of Computer Science and Software Engineering
-// University of Canterbury, Christchurch, New Zealand.
-//=====================================================================
-
-#include "TextureBMP.h"
-
-TextureBMP::TextureBMP(const char* filename)
-{
-	imageWid = 0;
-	imageHgt = 0;
-    if (loadBMPImage(filename)) {
-		cout << "Image " << filename << "  loaded successfully." << endl;
-		//cout << "Width = " << imageWid << "  Height = " << imageHgt <<
-		//	"  Channels = " << imageChnls << endl;
-    } else {
-        cerr << "Could not load image.";
-    }
-}
-
-/**
- * Return color at texture coord (s, t) where s and t are in [0,1]
- */
-glm::vec3 TextureBMP::getColorAt(float s, float t)
-{
-	if(imageWid == 0 || imageHgt == 0) return glm::vec3(0);
-    int i = (int) (s * imageWid);  //pixel coordinates
-    int j = (int) (t * imageHgt);
-	if(i < 0 || i > imageWid-1 || j < 0 || j > imageHgt-1) return glm::vec3(0);
-    int index = ((j * imageWid) + i) * imageChnls;
-
-    int r = imageData[index];
-    int g = imageData[index + 1];
-    int b = imageData[index + 2];
-
-	if(r < 0) r += 255;   //Unsigned byte values
-	if(g < 0) g += 255;
-	if(b < 0) b += 255;
- 
-    float rn = (float)r / 255.0;  //Normalized colour values
-    float gn = (float)g / 255.0;
-    float bn = (float)b / 255.0;
-    return glm::vec3(rn, gn, bn);
-}
-
-bool TextureBMP::loadBMPImage(const char* filename)
-{
-    char header1[18], header2[24];
-    short int planes, bpp;
-    int wid, hgt;
-    int nbytes, size, indx, temp;
-    ifstream file( filename, ios::in | ios::binary);
-    if(!file)
-    {
-        cout << "*** Error opening image file: " << filename << endl;
-        return false;
-    }
-    file.read (header1, 18);        //Initial part of header
-    file.read ((char*)&wid, 4);     //Width
-    file.read ((char*)&hgt, 4);     //Height
-    file.read ((char*)&planes, 2);  //Planes
-    file.read ((char*)&bpp, 2);     //Bits per pixel
-    file.read (header2, 24);        //Remaining part of header
-
-    nbytes = bpp / 8;           //No. of bytes per pixels
-    size = wid * hgt * nbytes;  //Total number of bytes to be read
-    imageData = new char[size];
-    file.read(imageData, size);
-    if(nbytes > 2)   //swap R and B
-    {
-        for(int i = 0; i < wid*hgt;  i++)
-        {
-            indx = i*nbytes;
-            temp = imageData[indx];
-            imageData[indx] = imageData[indx+2];
-            imageData[indx+2] = temp;
-        }
-    }
-
-    imageWid = wid;
-    imageHgt = hgt;
-    imageChnls = nbytes;
-
-    return true;
-}
+//=====================================================================
+// Image loader for files in BMP format.
+// Assumption:  Uncompressed data; 24 or 32 bits per pixel, Windows BMP.
+// Class definition suitable for ray tracing applications
+// Author:
+// R. Mukundan, Department of Computer Science and Software Engineering
+// University of Canterbury, Christchurch, New Zealand.
+//=====================================================================
+
+#include "TextureBMP.h"
+#include <cmath>
+#include <cstring>
+#include <stdint.h>
+
+namespace
+{
+    const int BLOCK_BYTES = 8;
+    const char BLOCK_FILE_MAGIC[4] = {'B', 'C', '1', 'T'};
+
+    uint16_t toRGB565(glm::vec3 c)
+    {
+        int r = (int)(glm::clamp(c.r, 0.0f, 1.0f) * 31.0f + 0.5f);
+        int g = (int)(glm::clamp(c.g, 0.0f, 1.0f) * 63.0f + 0.5f);
+        int b = (int)(glm::clamp(c.b, 0.0f, 1.0f) * 31.0f + 0.5f);
+        return (uint16_t)((r << 11) | (g << 5) | b);
+    }
+
+    glm::vec3 fromRGB565(uint16_t c)
+    {
+        return glm::vec3((c >> 11) / 31.0f, ((c >> 5) & 63) / 63.0f, (c & 31) / 31.0f);
+    }
+
+    //The four colours a block with end colours c0, c1 can hold
+    void blockPalette(uint16_t c0, uint16_t c1, glm::vec3 palette[4])
+    {
+        palette[0] = fromRGB565(c0);
+        palette[1] = fromRGB565(c1);
+        if(c0 > c1)
+        {
+            palette[2] = (2.0f * palette[0] + palette[1]) / 3.0f;
+            palette[3] = (palette[0] + 2.0f * palette[1]) / 3.0f;
+        }
+        else
+        {
+            palette[2] = (palette[0] + palette[1]) * 0.5f;
+            palette[3] = glm::vec3(0);
+        }
+    }
+
+    /**
+    * Encodes 16 texels into a block. The end colours are the texels furthest
+    * apart along the main axis of the block's colours, found by a few power
+    * iterations on their covariance; each texel then takes the nearest of
+    * the four palette colours.
+    */
+    void encodeBlock(const glm::vec3 texels[16], unsigned char* block)
+    {
+        glm::vec3 mean(0);
+        for(int k = 0; k < 16; k++) mean += texels[k];
+        mean /= 16.0f;
+
+        float cov[6] = {0, 0, 0, 0, 0, 0};
+        for(int k = 0; k < 16; k++)
+        {
+            glm::vec3 d = texels[k] - mean;
+            cov[0] += d.r * d.r;  cov[1] += d.r * d.g;  cov[2] += d.r * d.b;
+            cov[3] += d.g * d.g;  cov[4] += d.g * d.b;  cov[5] += d.b * d.b;
+        }
+        glm::vec3 axis(1, 1, 1);
+        for(int iteration = 0; iteration < 4; iteration++)
+        {
+            axis = glm::vec3(cov[0] * axis.r + cov[1] * axis.g + cov[2] * axis.b,
+                             cov[1] * axis.r + cov[3] * axis.g + cov[4] * axis.b,
+                             cov[2] * axis.r + cov[4] * axis.g + cov[5] * axis.b);
+            float length = glm::dot(axis, axis);
+            axis = length > 1.e-12f ? axis / sqrtf(length) : glm::vec3(0.57735f);
+        }
+
+        int lo = 0, hi = 0;
+        float loProj = 1.e+30f, hiProj = -1.e+30f;
+        for(int k = 0; k < 16; k++)
+        {
+            float proj = glm::dot(texels[k] - mean, axis);
+            if(proj < loProj) { loProj = proj; lo = k; }
+            if(proj > hiProj) { hiProj = proj; hi = k; }
+        }
+
+        uint16_t c0 = toRGB565(texels[hi]);
+        uint16_t c1 = toRGB565(texels[lo]);
+        if(c0 < c1)
+        {
+            uint16_t swap = c0; c0 = c1; c1 = swap;
+        }
+
+        uint32_t indices = 0;
+        if(c0 != c1)    //Equal end colours: every index is 0
+        {
+            glm::vec3 palette[4];
+            blockPalette(c0, c1, palette);
+            for(int k = 0; k < 16; k++)
+            {
+                int best = 0;
+                float bestError = 1.e+30f;
+                for(int p = 0; p < 4; p++)
+                {
+                    glm::vec3 d = texels[k] - palette[p];
+                    float error = glm::dot(d, d);
+                    if(error < bestError) { bestError = error; best = p; }
+                }
+                indices |= (uint32_t)best << (2 * k);
+            }
+        }
+
+        block[0] = c0 & 0xff;  block[1] = c0 >> 8;
+        block[2] = c1 & 0xff;  block[3] = c1 >> 8;
+        block[4] = indices & 0xff;          block[5] = (indices >> 8) & 0xff;
+        block[6] = (indices >> 16) & 0xff;  block[7] = indices >> 24;
+    }
+}
+
+TextureBMP::TextureBMP(const char* filename)
+{
+	imageWid = 0;
+	imageHgt = 0;
+	imageData = NULL;
+    if (loadBMPImage(filename)) {
+		cout << "Image " << filename << "  loaded successfully." << endl;
+		//cout << "Width = " << imageWid << "  Height = " << imageHgt <<
+		//	"  Channels = " << imageChnls << endl;
+    } else {
+        cerr << "Could not load image.";
+    }
+}
+
+/**
+ * Return color at texture coord (s, t) where s and t are in [0,1]
+ */
+glm::vec3 TextureBMP::getColorAt(float s, float t)
+{
+    if(pages) return pages->getColorAt(s, t);
+	if(imageWid == 0 || imageHgt == 0) return glm::vec3(0);
+    int i = (int) (s * imageWid);  //pixel coordinates
+    int j = (int) (t * imageHgt);
+	if(i < 0 || i > imageWid-1 || j < 0 || j > imageHgt-1) return glm::vec3(0);
+    if(!blockData.empty()) return getBlockColorAt(i, j);
+    int index = ((j * imageWid) + i) * imageChnls;
+
+    int r = imageData[index];
+    int g = imageData[index + 1];
+    int b = imageData[index + 2];
+
+	if(r < 0) r += 255;   //Unsigned byte values
+	if(g < 0) g += 255;
+	if(b < 0) b += 255;
+ 
+    float rn = (float)r / 255.0;  //Normalized colour values
+    float gn = (float)g / 255.0;
+    float bn = (float)b / 255.0;
+    return glm::vec3(rn, gn, bn);
+}
+
+bool TextureBMP::loadBMPImage(const char* filename)
+{
+    char header1[18], header2[24];
+    short int planes, bpp;
+    int wid, hgt;
+    int nbytes, size, indx, temp;
+    ifstream file( filename, ios::in | ios::binary);
+    if(!file)
+    {
+        cout << "*** Error opening image file: " << filename << endl;
+        return false;
+    }
+    file.read (header1, 18);        //Initial part of header
+    file.read ((char*)&wid, 4);     //Width
+    file.read ((char*)&hgt, 4);     //Height
+    file.read ((char*)&planes, 2);  //Planes
+    file.read ((char*)&bpp, 2);     //Bits per pixel
+    file.read (header2, 24);        //Remaining part of header
+
+    nbytes = bpp / 8;           //No. of bytes per pixels
+    size = wid * hgt * nbytes;  //Total number of bytes to be read
+    imageData = new char[size];
+    file.read(imageData, size);
+    if(nbytes > 2)   //swap R and B
+    {
+        for(int i = 0; i < wid*hgt;  i++)
+        {
+            indx = i*nbytes;
+            temp = imageData[indx];
+            imageData[indx] = imageData[indx+2];
+            imageData[indx+2] = temp;
+        }
+    }
+
+    imageWid = wid;
+    imageHgt = hgt;
+    imageChnls = nbytes;
+
+    return true;
+}
+
+/**
+* Texel (i, j) of the compressed image: only the palette entry it uses is
+* decoded, from the 8 bytes of its block.
+*/
+glm::vec3 TextureBMP::getBlockColorAt(int i, int j)
+{
+    int blocksWide = (imageWid + 3) / 4;
+    const unsigned char* block = &blockData[((j >> 2) * blocksWide + (i >> 2)) * BLOCK_BYTES];
+    uint16_t c0 = block[0] | (block[1] << 8);
+    uint16_t c1 = block[2] | (block[3] << 8);
+    int shift = 2 * (((j & 3) << 2) | (i & 3));
+    int index = (block[4 + (shift >> 3)] >> (shift & 7)) & 3;
+
+    glm::vec3 color0 = fromRGB565(c0);
+    glm::vec3 color1 = fromRGB565(c1);
+    switch(index)
+    {
+        case 0: return color0;
+        case 1: return color1;
+        case 2: return c0 > c1 ? (2.0f * color0 + color1) / 3.0f : (color0 + color1) * 0.5f;
+        default: return c0 > c1 ? (color0 + 2.0f * color1) / 3.0f : glm::vec3(0);
+    }
+}
+
+/**
+* Blocks overhanging the right or top edge repeat the edge texels.
+*/
+double TextureBMP::compress()
+{
+    if(imageData == NULL || imageWid == 0 || imageHgt == 0) return 0;
+
+    int blocksWide = (imageWid + 3) / 4;
+    int blocksHigh = (imageHgt + 3) / 4;
+    blockData.assign((size_t)blocksWide * blocksHigh * BLOCK_BYTES, 0);
+
+    double sum = 0;
+    for(int by = 0; by < blocksHigh; by++)
+    {
+        for(int bx = 0; bx < blocksWide; bx++)
+        {
+            glm::vec3 texels[16];
+            for(int k = 0; k < 16; k++)
+            {
+                int i = glm::min(bx * 4 + (k & 3), imageWid - 1);
+                int j = glm::min(by * 4 + (k >> 2), imageHgt - 1);
+                const unsigned char* pixel = (const unsigned char*)&imageData[(j * imageWid + i) * imageChnls];
+                texels[k] = glm::vec3(pixel[0], pixel[1], pixel[2]) / 255.0f;
+            }
+            encodeBlock(texels, &blockData[(by * blocksWide + bx) * BLOCK_BYTES]);
+
+            for(int k = 0; k < 16; k++)
+            {
+                int i = bx * 4 + (k & 3);
+                int j = by * 4 + (k >> 2);
+                if(i >= imageWid || j >= imageHgt) continue;
+                glm::vec3 d = getBlockColorAt(i, j) - texels[k];
+                sum += glm::dot(d, d);
+            }
+        }
+    }
+
+    delete[] imageData;
+    imageData = NULL;
+
+    double mse = sum / (3.0 * imageWid * imageHgt);
+    return mse > 0 ? 10.0 * log10(1.0 / mse) : INFINITY;
+}
+
+bool TextureBMP::isCompressed()
+{
+    return !blockData.empty();
+}
+
+bool TextureBMP::saveCompressed(const char* filename)
+{
+    if(blockData.empty()) return false;
+
+    ofstream file(filename, ios::out | ios::binary);
+    if(!file)
+    {
+        cerr << "*** Error writing compressed texture: " << filename << endl;
+        return false;
+    }
+    file.write(BLOCK_FILE_MAGIC, 4);
+    file.write((const char*)&imageWid, 4);
+    file.write((const char*)&imageHgt, 4);
+    file.write((const char*)blockData.data(), blockData.size());
+    return (bool)file;
+}
+
+bool TextureBMP::loadCompressed(const char* filename)
+{
+    ifstream file(filename, ios::in | ios::binary);
+    if(!file) return false;
+
+    char magic[4];
+    int wid = 0, hgt = 0;
+    file.read(magic, 4);
+    file.read((char*)&wid, 4);
+    file.read((char*)&hgt, 4);
+    if(!file || memcmp(magic, BLOCK_FILE_MAGIC, 4) != 0 || wid <= 0 || hgt <= 0)
+    {
+        cerr << "*** Not a compressed texture: " << filename << endl;
+        return false;
+    }
+
+    std::vector<unsigned char> blocks((size_t)((wid + 3) / 4) * ((hgt + 3) / 4) * BLOCK_BYTES);
+    file.read((char*)blocks.data(), blocks.size());
+    if(!file)
+    {
+        cerr << "*** Truncated compressed texture: " << filename << endl;
+        return false;
+    }
+
+    delete[] imageData;
+    imageData = NULL;
+    blockData.swap(blocks);
+    imageWid = wid;
+    imageHgt = hgt;
+    imageChnls = 3;
+    return true;
+}
+
+bool TextureBMP::openVirtual(const char* filename, size_t budget)
+{
+    std::shared_ptr<VirtualTexture> cache = std::make_shared<VirtualTexture>();
+    if(!cache->open(filename, budget)) return false;
+
+    delete[] imageData;
+    imageData = NULL;
+    blockData.clear();
+    pages = cache;
+    imageWid = cache->getWidth();
+    imageHgt = cache->getHeight();
+    imageChnls = 3;
+    return true;
+}
+
+bool TextureBMP::isVirtual()
+{
+    return (bool)pages;
+}
+
+VirtualTexture* TextureBMP::getVirtual()
+{
+    return pages.get();
+}
+
+size_t TextureBMP::getMemorySize()
+{
+    if(pages) return pages->getMemorySize();
+    return blockData.empty() ? (size_t)imageWid * imageHgt * imageChnls : blockData.size();
+}
@@ -1,31 +1,57 @@
-//=====================================================================
-// Image loader for files in BMP format.
-// Assumption:  Uncompressed data; 24 bits per pixel, Windows BMP.
-// Class definition suitable for ray tracing applications
-// Author:
-// R. Mukundan, Department of Computer Science and Software Engineering
-// University of Canterbury, Christchurch, New Zealand.
-//=====================================================================
-
-#if !defined(H_TEXBMP)
-#define H_TEXBMP
-
-#include <iostream>
-#include <fstream>
-#include <glm/glm.hpp>
-using namespace std;
-
-class TextureBMP
-{
-    private:
-        int imageWid, imageHgt, imageChnls;  //Width, height, number of channels
-        char* imageData;
-        bool loadBMPImage(const char* string);
-    public:
-		TextureBMP(): imageWid(0), imageHgt(0), imageChnls(0) {}
-        TextureBMP(const char* string);
-        glm::vec3 getColorAt(float s, float t);
-};
-
-#endif
-
+//=====================================================================
+// Image loader for files in BMP format.
+// Assumption:  Uncompressed data; 24 bits per pixel, Windows BMP.
+// Class definition suitable for ray tracing applications
+// Author:
+// R. Mukundan, Department of Computer Science and Software Engineering
+// University of Canterbury, Christchurch, New Zealand.
+//=====================================================================
+
+#if !defined(H_TEXBMP)
+#define H_TEXBMP
+
+#include <iostream>
+#include <fstream>
+#include <memory>
+#include <vector>
+#include <glm/glm.hpp>
+#include "VirtualTexture.h"
+using namespace std;
+
+//Texels may be kept as raw pixels or compressed into BC1 blocks: each 4x4
+//block stores two RGB565 end colours and a 2-bit palette index per texel,
+//8 bytes in place of 48 (RGB) or 64 (RGBA). They may also be virtual:
+//paged in tile by tile from a cache file, within a memory budget.
+class TextureBMP
+{
+    private:
+        int imageWid, imageHgt, imageChnls;  //Width, height, number of channels
+        char* imageData;
+        std::vector<unsigned char> blockData;  //BC1 blocks, row by row from the bottom; empty if raw
+        std::shared_ptr<VirtualTexture> pages; //Tile cache of a virtual texture; NULL otherwise
+        bool loadBMPImage(const char* string);
+        glm::vec3 getBlockColorAt(int i, int j);
+    public:
+		TextureBMP(): imageWid(0), imageHgt(0), imageChnls(0), imageData(NULL) {}
+        TextureBMP(const char* string);
+        glm::vec3 getColorAt(float s, float t);
+
+        //Replaces the raw pixels with BC1 blocks; returns the PSNR (dB) of the compressed texels
+        double compress();
+        bool isCompressed();
+
+        //Precompressed textures, so that compress() need not run at every start
+        bool saveCompressed(const char* filename);
+        bool loadCompressed(const char* filename);
+
+        //Samples the tile cache file written by VirtualTexture::build() instead of pixels in memory
+        bool openVirtual(const char* filename, size_t budget);
+        bool isVirtual();
+        VirtualTexture* getVirtual();
+
+        //Bytes of texel storage
+        size_t getMemorySize();
+};
+
+#endif
+
@@ -0,0 +1,307 @@
+/*----------------------------------------------------------
+* COSC363  Ray Tracer
+*
+*  The tile binner class
+-------------------------------------------------------------*/
+
+#include "TileBinner.h"
+#include "ParallelFor.h"
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    const int PROJECT_CHUNK = 1024;     //boxes a thread projects at a time
+}
+
+TileBinner::TileBinner()
+    : rows_(NULL)
+{
+}
+
+TileBinner::~TileBinner()
+{
+    RowSlot* slot = rows_.load();
+    while(slot != NULL)
+    {
+        RowSlot* next = slot->next;
+        delete slot;
+        slot = next;
+    }
+}
+
+/**
+* The box corners are projected onto the view plane and the bounding
+* rectangle, grown by a pixel for rounding, is converted to pixels. Since
+* the box is convex and wholly in front of the eye, every primary ray that
+* hits something inside it passes through that rectangle.
+*/
+TileBinner::PixelRect TileBinner::project(Camera& camera, const BoundingBox& box, float xMin, float cellX, float yMin, float cellY)
+{
+    bool anyInFront = false;
+    bool anyBehind = false;
+    glm::vec2 lo(1.e+30f), hi(-1.e+30f);
+    for(int c = 0; c < 8; c++)
+    {
+        glm::vec3 corner((c & 1) ? box.max.x : box.min.x,
+                         (c & 2) ? box.max.y : box.min.y,
+                         (c & 4) ? box.max.z : box.min.z);
+        glm::vec2 xy;
+        if(camera.project(corner, xy))
+        {
+            anyInFront = true;
+            lo = glm::vec2(std::min(lo.x, xy.x), std::min(lo.y, xy.y));
+            hi = glm::vec2(std::max(hi.x, xy.x), std::max(hi.y, xy.y));
+        }
+        else
+        {
+            anyBehind = true;
+        }
+    }
+
+    PixelRect rect;
+    if(!anyInFront)
+    {
+        rect.i0 = rect.j0 = 0;
+        rect.i1 = rect.j1 = -1;     //Wholly behind the eye: never hit by a primary ray
+    }
+    else if(anyBehind)
+    {
+        rect.i0 = rect.j0 = 0;
+        rect.i1 = width_ - 1;
+        rect.j1 = height_ - 1;
+    }
+    else
+    {
+        rect.i0 = std::max(0, (int)floor((lo.x - xMin) / cellX) - 1);
+        rect.j0 = std::max(0, (int)floor((lo.y - yMin) / cellY) - 1);
+        rect.i1 = std::min(width_ - 1, (int)floor((hi.x - xMin) / cellX) + 1);
+        rect.j1 = std::min(height_ - 1, (int)floor((hi.y - yMin) / cellY) + 1);
+    }
+    return rect;
+}
+
+/**
+* A node's box holds its objects' boxes, so its rectangle holds theirs and
+* the walk in listRow() can skip every node that misses a row of tiles.
+*/
+void TileBinner::build(Scene& scene, int width, int height, float xMin, float xMax, float yMin, float yMax,
+                       int tileSize, int threads)
+{
+    scene_ = &scene;
+    build_++;
+    width_ = width;
+    height_ = height;
+    tileSize_ = std::max(1, tileSize);
+    tilesX_ = (width + tileSize_ - 1) / tileSize_;
+    tilesY_ = (height + tileSize_ - 1) / tileSize_;
+
+    float cellX = (xMax - xMin) / width;
+    float cellY = (yMax - yMin) / height;
+
+    BVH& bvh = scene.getBVH();
+    const BVHNode* nodes = bvh.getNodes();
+    int objectCount = scene.objects.size();
+    int nodeCount = bvh.getNodeCount();
+    rects_.resize(objectCount);
+    nodeRects_.resize(nodeCount);
+
+    int objectChunks = (objectCount + PROJECT_CHUNK - 1) / PROJECT_CHUNK;
+    int nodeChunks = (nodeCount + PROJECT_CHUNK - 1) / PROJECT_CHUNK;
+    parallelFor(objectChunks + nodeChunks, threads, [&](int chunk)
+    {
+        if(chunk < objectChunks)
+        {
+            int end = std::min(objectCount, (chunk + 1) * PROJECT_CHUNK);
+            for(int n = chunk * PROJECT_CHUNK; n < end; n++)
+            {
+                rects_[n] = project(scene.camera, scene.objects[n]->bounds(), xMin, cellX, yMin, cellY);
+            }
+        }
+        else
+        {
+            chunk -= objectChunks;
+            int end = std::min(nodeCount, (chunk + 1) * PROJECT_CHUNK);
+            for(int m = chunk * PROJECT_CHUNK; m < end; m++)
+            {
+                nodeRects_[m] = project(scene.camera, nodes[m].box, xMin, cellX, yMin, cellY);
+            }
+        }
+    });
+}
+
+/**
+* The objects reaching the row are gathered by walking the BVH (or taken
+* from the whole scene if it has none) and sorted, then counted into their
+* tiles and copied into them in index order, so the lists come out sorted.
+* Tiles with more than MAX_LISTED objects are only marked.
+*/
+void TileBinner::listRow(int ty, TileRow& tiles) const
+{
+    int j0 = ty * tileSize_;
+    int j1 = std::min(height_, j0 + tileSize_) - 1;
+
+    tiles.objects.clear();
+    int nodeCount = nodeRects_.size();
+    if(nodeCount == 0)
+    {
+        for(int n = 0; n < (int)rects_.size(); n++)
+        {
+            if(rects_[n].j0 <= j1 && rects_[n].j1 >= j0) tiles.objects.push_back(n);
+        }
+    }
+    else
+    {
+        BVH& bvh = scene_->getBVH();
+        const BVHNode* nodes = bvh.getNodes();
+        const int* objectIndices = bvh.getObjectIndices();
+        int stack[BVH::STACK_SIZE];
+        int top = 0;
+        stack[top++] = 0;
+        while(top > 0)
+        {
+            int nodeIndex = stack[--top];
+            const PixelRect& r = nodeRects_[nodeIndex];
+            if(r.j0 > j1 || r.j1 < j0) continue;
+            const BVHNode& node = nodes[nodeIndex];
+            if(node.count == 0)
+            {
+                stack[top++] = node.first;
+                stack[top++] = nodeIndex + 1;
+                continue;
+            }
+            for(int k = node.first; k < node.first + node.count; k++)
+            {
+                int n = objectIndices[k];
+                if(rects_[n].j0 <= j1 && rects_[n].j1 >= j0) tiles.objects.push_back(n);
+            }
+        }
+        std::sort(tiles.objects.begin(), tiles.objects.end());
+    }
+
+    tiles.offsets.assign(tilesX_ + 1, 0);
+    for(int n : tiles.objects)
+    {
+        for(int tx = rects_[n].i0 / tileSize_; tx <= rects_[n].i1 / tileSize_; tx++)
+        {
+            tiles.offsets[tx + 1]++;
+        }
+    }
+    tiles.all.resize(tilesX_);
+    for(int tx = 0; tx < tilesX_; tx++)
+    {
+        tiles.all[tx] = tiles.offsets[tx + 1] > MAX_LISTED;
+        if(tiles.all[tx]) tiles.offsets[tx + 1] = 0;
+        tiles.offsets[tx + 1] += tiles.offsets[tx];
+    }
+
+    tiles.indices.resize(tiles.offsets[tilesX_]);
+    for(int n : tiles.objects)
+    {
+        for(int tx = rects_[n].i0 / tileSize_; tx <= rects_[n].i1 / tileSize_; tx++)
+        {
+            if(!tiles.all[tx]) tiles.indices[tiles.offsets[tx]++] = n;
+        }
+    }
+    //The copy advanced each tile's start to the next tile's; shift them back
+    for(int tx = tilesX_; tx > 0; tx--)
+    {
+        tiles.offsets[tx] = tiles.offsets[tx - 1];
+    }
+    tiles.offsets[0] = 0;
+}
+
+/**
+* A thread's slot is found by walking the list, which holds one slot per
+* thread that ever asked this binner, and added at its head the first time.
+* The list only grows, so a walk that races with a new slot still sees
+* every older one.
+*/
+TileBinner::TileRow& TileBinner::threadRow() const
+{
+    std::thread::id self = std::this_thread::get_id();
+    RowSlot* head = rows_.load(std::memory_order_acquire);
+    for(RowSlot* slot = head; slot != NULL; slot = slot->next)
+    {
+        if(slot->owner == self) return slot->tiles;
+    }
+
+    RowSlot* slot = new RowSlot();
+    slot->owner = self;
+    slot->next = head;
+    while(!rows_.compare_exchange_weak(slot->next, slot, std::memory_order_release, std::memory_order_acquire))
+    {
+    }
+    return slot->tiles;
+}
+
+/**
+* The binner keeps the last row of tiles each thread asked for, as the
+* renderers hand out whole rows of pixels and a thread's next pixel is
+* almost always in the same row of tiles. The row's lists are kept until
+* the thread asks for another row, and their storage for as long as the
+* binner lives, so once rows as wide have been listed, listing more (or
+* rebinning) allocates nothing.
+*/
+TileObjects TileBinner::candidates(int i, int j) const
+{
+    TileRow& tiles = threadRow();
+    int ty = j / tileSize_;
+    if(tiles.build != build_ || tiles.row != ty)
+    {
+        listRow(ty, tiles);
+        tiles.build = build_;
+        tiles.row = ty;
+    }
+
+    int tx = i / tileSize_;
+    TileObjects list;
+    list.indices = tiles.indices.data() + tiles.offsets[tx];
+    list.count = tiles.offsets[tx + 1] - tiles.offsets[tx];
+    list.all = tiles.all[tx] != 0;
+    return list;
+}
+
+void TileBinner::tally()
+{
+    if(tallied_ == build_) return;
+    TileRow tiles;
+    size_t listed = 0;
+    emptyTiles_ = unlistedTiles_ = 0;
+    for(int ty = 0; ty < tilesY_; ty++)
+    {
+        listRow(ty, tiles);
+        for(int tx = 0; tx < tilesX_; tx++)
+        {
+            if(tiles.all[tx]) unlistedTiles_++;
+            else if(tiles.offsets[tx + 1] == tiles.offsets[tx]) emptyTiles_++;
+        }
+        listed += tiles.indices.size();
+    }
+    int listedTiles = getTileCount() - unlistedTiles_;
+    meanCandidates_ = listedTiles > 0 ? (double)listed / listedTiles : 0;
+    tallied_ = build_;
+}
+
+int TileBinner::getTileCount()
+{
+    return tilesX_ * tilesY_;
+}
+
+int TileBinner::getEmptyTileCount()
+{
+    tally();
+    return emptyTiles_;
+}
+
+int TileBinner::getUnlistedTileCount()
+{
+    tally();
+    return unlistedTiles_;
+}
+
+double TileBinner::getMeanCandidates()
+{
+    tally();
+    return meanCandidates_;
+}
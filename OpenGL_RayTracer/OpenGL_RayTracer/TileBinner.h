@@ -0,0 +1,117 @@
+/*----------------------------------------------------------
+* COSC363  Ray Tracer
+*
+*  The tile binner class
+*  Splits the image into square tiles and lists, for each
+*  tile, the scene objects whose bounding boxes project onto
+*  it. A primary ray then only needs to be tested against the
+*  objects of its tile, and a tile with no objects is known to
+*  show only background. Objects whose box reaches behind the
+*  eye cannot be projected and are listed in every tile. A
+*  tile with more than MAX_LISTED objects is not listed: its
+*  rays search the scene's BVH, which is faster by then.
+*  build() only projects the objects and the BVH's boxes; the
+*  tiles are listed one row of tiles at a time, by walking the
+*  BVH, when a thread first asks for that row, and the binner
+*  keeps only each thread's latest row. Memory therefore depends
+*  on the image width and the number of threads, not on its
+*  height.
+-------------------------------------------------------------*/
+
+#ifndef H_TILE_BINNER
+#define H_TILE_BINNER
+
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <stdint.h>
+#include "Scene.h"
+
+//Objects a primary ray may hit: 'count' indices in ascending order, or every object if 'all'
+struct TileObjects
+{
+    const int* indices;
+    int count;
+    bool all;
+};
+
+class TileBinner
+{
+private:
+    //Screen rectangle of an object or BVH node in pixels, inclusive
+    struct PixelRect
+    {
+        int i0, j0, i1, j1;
+    };
+
+    //One row of tiles in compressed sparse row form
+    struct TileRow
+    {
+        uint64_t build = 0;             //build_ of the binner it was listed for, 0 if none
+        int row = -1;
+        std::vector<int> objects;       //objects reaching the row, ascending
+        std::vector<int> offsets;       //tile tx lists indices[offsets[tx], offsets[tx + 1])
+        std::vector<int> indices;
+        std::vector<unsigned char> all; //1 for tiles left to the BVH
+    };
+
+    //The latest row of one thread; slots are only added, and only by their own thread
+    struct RowSlot
+    {
+        std::thread::id owner;
+        TileRow tiles;
+        RowSlot* next;
+    };
+
+    Scene* scene_ = NULL;
+    uint64_t build_ = 0;    //counts build()s, so a thread can tell its row is stale
+    mutable std::atomic<RowSlot*> rows_;
+    int width_ = 0;
+    int height_ = 0;
+    int tileSize_ = 16;
+    int tilesX_ = 0;
+    int tilesY_ = 0;
+    std::vector<PixelRect> rects_;      //per object; kept between builds, so rebinning allocates nothing
+    std::vector<PixelRect> nodeRects_;  //per BVH node
+
+    //Counts over every tile, for the build 'tallied_'
+    uint64_t tallied_ = 0;
+    int emptyTiles_ = 0;
+    int unlistedTiles_ = 0;
+    double meanCandidates_ = 0;
+
+    PixelRect project(Camera& camera, const BoundingBox& box, float xMin, float cellX, float yMin, float cellY);
+    void listRow(int ty, TileRow& tiles) const;
+    TileRow& threadRow() const;
+    void tally();
+
+public:
+    static const int DEFAULT_TILE_SIZE = 16;
+    static const int MAX_LISTED = 16;
+
+    TileBinner();
+    ~TileBinner();
+    TileBinner(const TileBinner&) = delete;
+    TileBinner& operator=(const TileBinner&) = delete;
+
+    /**
+    * Bins the scene's objects for a width x height image of the view plane
+    * rectangle (xMin, yMin) - (xMax, yMax), seen through the scene's camera.
+    * The scene must not change until the binner is built again.
+    */
+    void build(Scene& scene, int width, int height, float xMin, float xMax, float yMin, float yMax,
+               int tileSize = DEFAULT_TILE_SIZE, int threads = 0);
+
+    //Objects that may be hit in pixel (i, j); j counted from the bottom. Valid until
+    //this thread asks this binner for a pixel in another row of tiles.
+    TileObjects candidates(int i, int j) const;
+
+    int getTileCount();
+
+    //These list every row of tiles once more, the first time one is asked for after a build
+    int getEmptyTileCount();
+    int getUnlistedTileCount();     //tiles whose rays search the BVH
+    double getMeanCandidates();     //over the listed tiles
+};
+
+#endif //!H_TILE_BINNER
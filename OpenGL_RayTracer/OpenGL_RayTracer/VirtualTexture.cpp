@@ -0,0 +1,473 @@
+/*----------------------------------------------------------
+* COSC363  Ray Tracer
+*
+*  The virtual texture class
+-------------------------------------------------------------*/
+
+#include "VirtualTexture.h"
+#include <algorithm>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <iostream>
+#include <unistd.h>
+
+namespace
+{
+    const char CACHE_FILE_MAGIC[4] = {'V', 'T', 'E', 'X'};
+    const int HEADER_BYTES = 20;
+
+    //Sizes of the mip levels, halved (rounding up) down to 1 x 1
+    void levelSizes(int width, int height, std::vector<int>& widths, std::vector<int>& heights)
+    {
+        widths.assign(1, width);
+        heights.assign(1, height);
+        while(width > 1 || height > 1)
+        {
+            width = (width + 1) / 2;
+            height = (height + 1) / 2;
+            widths.push_back(width);
+            heights.push_back(height);
+        }
+    }
+
+    /**
+    * Receives the rows of one mip level from the bottom up, writes its tiles
+    * to the cache file as each strip of tileSize rows fills, and passes every
+    * pair of rows, box filtered, to the next level.
+    */
+    struct LevelWriter
+    {
+        int width;
+        int height;
+        int tileSize;
+        long long offset;   //File offset of the level's first tile
+        std::vector<unsigned char> strip;
+        std::vector<unsigned char> evenRow;
+        std::vector<unsigned char> halfRow;
+        LevelWriter* next;
+
+        bool addRow(std::ofstream& file, const unsigned char* row, int y)
+        {
+            int T = tileSize;
+            memcpy(&strip[(size_t)(y % T) * width * 3], row, (size_t)width * 3);
+            if(y % T == T - 1 || y == height - 1)
+            {
+                if(!writeStrip(file, y / T, y % T + 1)) return false;
+            }
+
+            if(next == NULL) return true;
+            if(y % 2 == 0)
+            {
+                memcpy(evenRow.data(), row, (size_t)width * 3);
+                if(y < height - 1) return true;
+            }
+            const unsigned char* a = evenRow.data();
+            const unsigned char* b = y % 2 == 1 ? row : a;
+            for(int x = 0; x < next->width; x++)
+            {
+                int x0 = 2 * x;
+                int x1 = std::min(2 * x + 1, width - 1);
+                for(int c = 0; c < 3; c++)
+                {
+                    halfRow[x * 3 + c] = (a[x0 * 3 + c] + a[x1 * 3 + c] + b[x0 * 3 + c] + b[x1 * 3 + c] + 2) / 4;
+                }
+            }
+            return next->addRow(file, halfRow.data(), y / 2);
+        }
+
+        //Tiles overhanging the right or top edge repeat the edge texels
+        bool writeStrip(std::ofstream& file, int tileRow, int rows)
+        {
+            int T = tileSize;
+            int tilesX = (width + T - 1) / T;
+            std::vector<unsigned char> tile((size_t)T * T * 3);
+            for(int tx = 0; tx < tilesX; tx++)
+            {
+                for(int r = 0; r < T; r++)
+                {
+                    const unsigned char* src = &strip[(size_t)std::min(r, rows - 1) * width * 3];
+                    for(int c = 0; c < T; c++)
+                    {
+                        int x = std::min(tx * T + c, width - 1);
+                        memcpy(&tile[((size_t)r * T + c) * 3], &src[x * 3], 3);
+                    }
+                }
+                file.seekp(offset + ((long long)tileRow * tilesX + tx) * T * T * 3);
+                file.write((const char*)tile.data(), tile.size());
+            }
+            return (bool)file;
+        }
+    };
+
+    //Channel value as TextureBMP::getColorAt() reads a raw pixel byte
+    float channel(uint32_t byte)
+    {
+        return (byte < 128 ? byte : byte - 1) / 255.0f;
+    }
+}
+
+VirtualTexture::VirtualTexture()
+    : useClock_(0), pageIns_(0), evictions_(0), fallbacks_(0), readFailed_(false)
+{
+}
+
+VirtualTexture::~VirtualTexture()
+{
+    if(file_ >= 0)
+    {
+        close(file_);
+    }
+}
+
+/**
+* The image is read as TextureBMP::loadBMPImage() reads it: the pixels
+* follow the 54 byte header, rows from the bottom, with no row padding.
+* Only one strip of rows per level is held, so a gigapixel image converts
+* in a few megabytes.
+*/
+bool VirtualTexture::build(const char* imageFile, const char* cacheFile, int tileSize)
+{
+    std::ifstream image(imageFile, std::ios::in | std::ios::binary);
+    if(!image)
+    {
+        std::cerr << "*** Error opening image file: " << imageFile << std::endl;
+        return false;
+    }
+    char header1[18], header2[24];
+    short int planes = 0, bpp = 0;
+    int width = 0, height = 0;
+    image.read(header1, 18);
+    image.read((char*)&width, 4);
+    image.read((char*)&height, 4);
+    image.read((char*)&planes, 2);
+    image.read((char*)&bpp, 2);
+    image.read(header2, 24);
+    if(!image || width <= 0 || height <= 0 || (bpp != 24 && bpp != 32))
+    {
+        std::cerr << "*** Virtual textures need a 24 or 32 bit BMP image: " << imageFile << std::endl;
+        return false;
+    }
+
+    std::ofstream file(cacheFile, std::ios::out | std::ios::binary | std::ios::trunc);
+    if(!file)
+    {
+        std::cerr << "*** Error writing virtual texture: " << cacheFile << std::endl;
+        return false;
+    }
+    std::vector<int> widths, heights;
+    levelSizes(width, height, widths, heights);
+    int levelCount = widths.size();
+    int header[4] = {width, height, tileSize, levelCount};
+    file.write(CACHE_FILE_MAGIC, 4);
+    file.write((const char*)header, sizeof(header));
+
+    std::vector<LevelWriter> levels(levelCount);
+    long long offset = HEADER_BYTES;
+    for(int level = 0; level < levelCount; level++)
+    {
+        LevelWriter& writer = levels[level];
+        writer.width = widths[level];
+        writer.height = heights[level];
+        writer.tileSize = tileSize;
+        writer.offset = offset;
+        writer.strip.resize((size_t)tileSize * writer.width * 3);
+        writer.evenRow.resize((size_t)writer.width * 3);
+        writer.next = level + 1 < levelCount ? &levels[level + 1] : NULL;
+        if(writer.next != NULL)
+        {
+            writer.halfRow.resize((size_t)widths[level + 1] * 3);
+        }
+        long long tiles = (long long)((writer.width + tileSize - 1) / tileSize) * ((writer.height + tileSize - 1) / tileSize);
+        offset += tiles * tileSize * tileSize * 3;
+    }
+
+    int nbytes = bpp / 8;
+    std::vector<char> pixels((size_t)width * nbytes);
+    std::vector<unsigned char> row((size_t)width * 3);
+    for(int y = 0; y < height; y++)
+    {
+        image.read(pixels.data(), pixels.size());
+        if(!image)
+        {
+            //Texels missing from a short file are black
+            std::fill(pixels.begin() + image.gcount(), pixels.end(), 0);
+            image.clear();
+        }
+        for(int x = 0; x < width; x++)
+        {
+            row[x * 3] = pixels[x * nbytes + 2];     //BGR to RGB
+            row[x * 3 + 1] = pixels[x * nbytes + 1];
+            row[x * 3 + 2] = pixels[x * nbytes];
+        }
+        if(!levels[0].addRow(file, row.data(), y))
+        {
+            std::cerr << "*** Error writing virtual texture: " << cacheFile << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+bool VirtualTexture::open(const char* cacheFile, size_t budget)
+{
+    int file = ::open(cacheFile, O_RDONLY);
+    if(file < 0)
+    {
+        std::cerr << "*** Error opening virtual texture: " << cacheFile << std::endl;
+        return false;
+    }
+    char magic[4];
+    int header[4];
+    if(pread(file, magic, 4, 0) != 4 || pread(file, header, sizeof(header), 4) != (ssize_t)sizeof(header)
+       || memcmp(magic, CACHE_FILE_MAGIC, 4) != 0 || header[0] <= 0 || header[1] <= 0 || header[2] <= 0)
+    {
+        std::cerr << "*** Not a virtual texture: " << cacheFile << std::endl;
+        close(file);
+        return false;
+    }
+    if(file_ >= 0)
+    {
+        close(file_);
+    }
+    file_ = file;
+    width_ = header[0];
+    height_ = header[1];
+    tileSize_ = header[2];
+
+    levelSizes(width_, height_, levelWidth_, levelHeight_);
+    levelCount_ = levelWidth_.size();
+    levelTilesX_.resize(levelCount_);
+    levelFirstTile_.resize(levelCount_);
+    tileCount_ = 0;
+    int pinnedCount = 0;
+    for(int level = 0; level < levelCount_; level++)
+    {
+        levelTilesX_[level] = (levelWidth_[level] + tileSize_ - 1) / tileSize_;
+        levelFirstTile_[level] = tileCount_;
+        int tiles = levelTilesX_[level] * ((levelHeight_[level] + tileSize_ - 1) / tileSize_);
+        tileCount_ += tiles;
+        if(tiles == 1) pinnedCount++;
+    }
+
+    residency_.reset(new std::atomic<int>[tileCount_]);
+    for(int tile = 0; tile < tileCount_; tile++)
+    {
+        residency_[tile] = NOT_RESIDENT;
+    }
+
+    size_t slotBytes = (size_t)tileSize_ * tileSize_ * sizeof(uint32_t);
+    slotCount_ = std::max((int)std::min(budget / slotBytes, (size_t)tileCount_), pinnedCount + 1);
+    texels_.reset(new std::atomic<uint32_t>[(size_t)slotCount_ * tileSize_ * tileSize_]);
+    version_.reset(new std::atomic<unsigned>[slotCount_]);
+    owner_.reset(new std::atomic<int>[slotCount_]);
+    lastUse_.reset(new std::atomic<unsigned>[slotCount_]);
+    pinned_.assign(slotCount_, 0);
+    busy_.assign(slotCount_, 0);
+    for(int slot = 0; slot < slotCount_; slot++)
+    {
+        version_[slot] = 0;
+        owner_[slot] = -1;
+        lastUse_[slot] = 0;
+    }
+
+    for(int level = 0; level < levelCount_; level++)
+    {
+        if(levelFirstTile_[level] + 1 == (level + 1 < levelCount_ ? levelFirstTile_[level + 1] : tileCount_))
+        {
+            residency_[levelFirstTile_[level]] = PAGING_IN;
+            pageIn(levelFirstTile_[level], true);
+        }
+    }
+    pageIns_ = 0;
+    return true;
+}
+
+/**
+* A free slot, or else the least recently used one that is neither pinned
+* nor being filled; called with pageMutex_ held. Its old tile is made
+* non-resident before the slot is rewritten.
+*/
+int VirtualTexture::claimSlot(int tile)
+{
+    int best = -1;
+    unsigned bestAge = 0;
+    unsigned now = useClock_;
+    for(int slot = 0; slot < slotCount_; slot++)
+    {
+        if(pinned_[slot] || busy_[slot]) continue;
+        if(owner_[slot] < 0)
+        {
+            best = slot;
+            break;
+        }
+        unsigned age = now - lastUse_[slot].load(std::memory_order_relaxed);
+        if(best < 0 || age > bestAge)
+        {
+            best = slot;
+            bestAge = age;
+        }
+    }
+    if(best < 0) return -1;
+
+    int victim = owner_[best];
+    version_[best].store(version_[best].load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    if(victim >= 0)
+    {
+        residency_[victim].store(NOT_RESIDENT, std::memory_order_release);
+        evictions_++;
+    }
+    owner_[best].store(tile, std::memory_order_relaxed);
+    busy_[best] = 1;
+    return best;
+}
+
+/**
+* Reads a tile into a page slot; the caller has set its residency to
+* PAGING_IN. Readers of the slot's old tile notice the changed version.
+*/
+int VirtualTexture::pageIn(int tile, bool pin)
+{
+    int slot;
+    {
+        std::lock_guard<std::mutex> lock(pageMutex_);
+        slot = claimSlot(tile);
+        if(slot < 0)
+        {
+            residency_[tile].store(NOT_RESIDENT, std::memory_order_release);
+            return -1;
+        }
+        pinned_[slot] = pin;
+    }
+
+    int level = 0;
+    while(level + 1 < levelCount_ && levelFirstTile_[level + 1] <= tile) level++;
+    long long offset = HEADER_BYTES;
+    for(int l = 0; l < level; l++)
+    {
+        offset += (long long)(levelFirstTile_[l + 1] - levelFirstTile_[l]) * tileSize_ * tileSize_ * 3;
+    }
+    size_t tileBytes = (size_t)tileSize_ * tileSize_ * 3;
+    offset += (long long)(tile - levelFirstTile_[level]) * tileBytes;
+
+    std::vector<unsigned char> bytes(tileBytes, 0);
+    if(pread(file_, bytes.data(), tileBytes, offset) != (ssize_t)tileBytes && !readFailed_.exchange(true))
+    {
+        std::cerr << "*** Error reading virtual texture tile " << tile << "; missing texels are black" << std::endl;
+    }
+    std::atomic<uint32_t>* texels = &texels_[(size_t)slot * tileSize_ * tileSize_];
+    for(int k = 0; k < tileSize_ * tileSize_; k++)
+    {
+        uint32_t rgb = bytes[k * 3] | (bytes[k * 3 + 1] << 8) | (bytes[k * 3 + 2] << 16);
+        texels[k].store(rgb, std::memory_order_relaxed);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(pageMutex_);
+        busy_[slot] = 0;
+        lastUse_[slot].store(++useClock_, std::memory_order_relaxed);
+        version_[slot].store(version_[slot].load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+    residency_[tile].store(slot, std::memory_order_release);
+    pageIns_++;
+    return slot;
+}
+
+/**
+* Texel (x, y) of 'level' if its tile is resident, paging the tile in
+* first if 'pageIn' is set and no other thread is doing so. The texel is
+* read between two loads of the slot's version, so a slot rewritten while
+* it is read is detected and the read repeated.
+*/
+bool VirtualTexture::fetch(int level, int x, int y, bool pageIn, uint32_t& texel)
+{
+    int tile = levelFirstTile_[level] + (y / tileSize_) * levelTilesX_[level] + x / tileSize_;
+    int index = (y % tileSize_) * tileSize_ + x % tileSize_;
+    while(true)
+    {
+        int slot = residency_[tile].load(std::memory_order_acquire);
+        if(slot >= 0)
+        {
+            unsigned before = version_[slot].load(std::memory_order_acquire);
+            texel = texels_[(size_t)slot * tileSize_ * tileSize_ + index].load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if((before & 1) == 0 && version_[slot].load(std::memory_order_relaxed) == before
+               && owner_[slot].load(std::memory_order_relaxed) == tile)
+            {
+                unsigned now = useClock_.load(std::memory_order_relaxed);
+                if(lastUse_[slot].load(std::memory_order_relaxed) != now)
+                {
+                    lastUse_[slot].store(now, std::memory_order_relaxed);
+                }
+                return true;
+            }
+            continue;
+        }
+
+        int expected = NOT_RESIDENT;
+        if(!pageIn || slot != NOT_RESIDENT || !residency_[tile].compare_exchange_strong(expected, PAGING_IN))
+        {
+            return false;
+        }
+        if(this->pageIn(tile, false) < 0)
+        {
+            return false;
+        }
+    }
+}
+
+glm::vec3 VirtualTexture::getColorAt(float s, float t)
+{
+    if(width_ == 0 || height_ == 0) return glm::vec3(0);
+    int i = (int)(s * width_);
+    int j = (int)(t * height_);
+    if(i < 0 || i > width_ - 1 || j < 0 || j > height_ - 1) return glm::vec3(0);
+
+    uint32_t texel = 0;
+    for(int level = 0; level < levelCount_; level++)
+    {
+        if(fetch(level, i >> level, j >> level, level == 0, texel))
+        {
+            if(level > 0) fallbacks_++;
+            break;
+        }
+    }
+    return glm::vec3(channel(texel & 0xff), channel((texel >> 8) & 0xff), channel(texel >> 16));
+}
+
+int VirtualTexture::getWidth()
+{
+    return width_;
+}
+
+int VirtualTexture::getHeight()
+{
+    return height_;
+}
+
+int VirtualTexture::getLevelCount()
+{
+    return levelCount_;
+}
+
+size_t VirtualTexture::getMemorySize()
+{
+    return (size_t)slotCount_ * (tileSize_ * tileSize_ * sizeof(uint32_t) + 2 * sizeof(unsigned) + sizeof(int) + 2)
+           + (size_t)tileCount_ * sizeof(int);
+}
+
+size_t VirtualTexture::getPageIns()
+{
+    return pageIns_;
+}
+
+size_t VirtualTexture::getEvictions()
+{
+    return evictions_;
+}
+
+size_t VirtualTexture::getFallbacks()
+{
+    return fallbacks_;
+}
@@ -0,0 +1,98 @@
+/*----------------------------------------------------------
+* COSC363  Ray Tracer
+*
+*  The virtual texture class
+*  Samples an image of any size with bounded memory. build()
+*  converts a BMP image, a strip of rows at a time, into a
+*  cache file of square tiles for every mip level. open()
+*  maps the cache file; tiles are then paged in when they are
+*  first sampled and the least recently used ones evicted
+*  once the page budget is full. The residency table is read
+*  without locks: a sample whose tile is being paged in by
+*  another thread takes the texel from the nearest coarser
+*  resident level instead of waiting. The coarsest levels,
+*  one tile each, are always resident.
+-------------------------------------------------------------*/
+
+#ifndef H_VIRTUAL_TEXTURE
+#define H_VIRTUAL_TEXTURE
+
+#include <glm/glm.hpp>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <stdint.h>
+
+class VirtualTexture
+{
+private:
+    int width_ = 0;
+    int height_ = 0;
+    int tileSize_ = 0;
+    int levelCount_ = 0;
+    int file_ = -1;
+    std::vector<int> levelWidth_;
+    std::vector<int> levelHeight_;
+    std::vector<int> levelTilesX_;
+    std::vector<int> levelFirstTile_;   //Index of each level's first tile; tiles of a level are row by row from the bottom
+    int tileCount_ = 0;
+
+    //Page slot holding each tile, or NOT_RESIDENT / PAGING_IN
+    std::unique_ptr<std::atomic<int>[]> residency_;
+
+    //Page slots: tileSize x tileSize packed RGB texels each
+    int slotCount_ = 0;
+    std::unique_ptr<std::atomic<uint32_t>[]> texels_;
+    std::unique_ptr<std::atomic<unsigned>[]> version_;  //Odd while the slot is rewritten
+    std::unique_ptr<std::atomic<int>[]> owner_;         //Tile held, -1 if free
+    std::unique_ptr<std::atomic<unsigned>[]> lastUse_;
+    std::vector<char> pinned_;      //Guarded by pageMutex_, as is busy_
+    std::vector<char> busy_;
+    std::mutex pageMutex_;
+
+    std::atomic<unsigned> useClock_;
+    std::atomic<size_t> pageIns_;
+    std::atomic<size_t> evictions_;
+    std::atomic<size_t> fallbacks_;
+    std::atomic<bool> readFailed_;
+
+    VirtualTexture(const VirtualTexture&);
+    VirtualTexture& operator=(const VirtualTexture&);
+
+    bool fetch(int level, int x, int y, bool pageIn, uint32_t& texel);
+    int pageIn(int tile, bool pin);
+    int claimSlot(int tile);
+
+public:
+    static const int DEFAULT_TILE_SIZE = 64;
+    static const int NOT_RESIDENT = -1;
+    static const int PAGING_IN = -2;
+
+    VirtualTexture();
+    ~VirtualTexture();
+
+    //Converts a 24 or 32 bit BMP image into a tile cache file; memory use depends on the image width only
+    static bool build(const char* imageFile, const char* cacheFile, int tileSize = DEFAULT_TILE_SIZE);
+
+    //Opens a cache file written by build(); at most 'budget' bytes of tiles are kept resident
+    bool open(const char* cacheFile, size_t budget);
+
+    //Colour at texture coordinates (s, t) in [0, 1], like TextureBMP::getColorAt()
+    glm::vec3 getColorAt(float s, float t);
+
+    int getWidth();
+    int getHeight();
+    int getLevelCount();
+
+    //Bytes of page slots and residency table; fixed by the budget when the texture is opened
+    size_t getMemorySize();
+
+    size_t getPageIns();
+    size_t getEvictions();
+
+    //Samples answered from a coarser level because their tile was being paged in
+    size_t getFallbacks();
+};
+
+#endif //!H_VIRTUAL_TEXTURE